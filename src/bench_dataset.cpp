@@ -0,0 +1,61 @@
+#include "dataset.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+
+// Measures samples/sec of every batch generator kernel, single-threaded and
+// across all hardware threads, writing into SoA columns.
+
+struct KernelEntry {
+    const char* name;
+    playground::GeneratorKernel kernel;
+};
+
+static double samplesPerSecond(playground::GeneratorKernel kernel, size_t numSamples, unsigned numThreads,
+                               std::vector<double>& columns) {
+    double* x = columns.data();
+    playground::ExampleColumns out{x, x + numSamples, x + 2 * numSamples};
+    double best = 0;
+    // Best of three, to filter out scheduling noise.
+    for (int rep = 0; rep < 3; ++rep) {
+        auto start = std::chrono::steady_clock::now();
+        playground::generateParallel(kernel, {numSamples, 0.1, static_cast<uint64_t>(rep)}, out, numThreads);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::max(best, numSamples / elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    size_t numSamples = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    const KernelEntry kernels[] = {
+        {"circle", playground::circleKernel},
+        {"xor", playground::xorKernel},
+        {"gauss", playground::twoGaussKernel},
+        {"spiral", playground::spiralKernel},
+        {"star", playground::starKernel},
+        {"sine", playground::sineKernel},
+        {"checkerboard", playground::checkerboardKernel},
+        {"moons", playground::moonsKernel},
+        {"heart", playground::heartKernel},
+        {"reg-plane", playground::regressPlaneKernel},
+        {"reg-gauss", playground::regressGaussianKernel},
+    };
+
+    std::vector<double> columns(3 * numSamples);
+    std::cout << "samples: " << numSamples << ", threads: " << numThreads << std::endl;
+    std::cout << std::left << std::setw(14) << "generator"
+              << std::right << std::setw(16) << "1 thread/s" << std::setw(16) << "all threads/s" << std::endl;
+    for (const auto& entry : kernels) {
+        double serial = samplesPerSecond(entry.kernel, numSamples, 1, columns);
+        double parallel = samplesPerSecond(entry.kernel, numSamples, numThreads, columns);
+        std::cout << std::left << std::setw(14) << entry.name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(16) << serial << std::setw(16) << parallel << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "nn.hpp"
+#include "kernels.hpp"
+#include "quantized.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Measures training examples/sec of the graph engine and of the kernel
+// Session would pick, from the default toy network up to layers a thousand
+// wide. Batches are 10 examples, as in the app. Then times one redraw of
+// the app's 50x50 boundary grid on the kernel and on the fixed-point network,
+// and scoring on the graph with forwardProp and with forwardPropBatch.
+
+static const size_t BATCH = 10;
+
+static size_t countLinks(const std::vector<int>& shape) {
+    size_t links = 0;
+    for (size_t l = 1; l < shape.size(); ++l) links += static_cast<size_t>(shape[l - 1]) * shape[l];
+    return links;
+}
+
+// Runs batches until about half a second has passed; returns examples/sec.
+template <typename TrainBatch>
+static double examplesPerSecond(TrainBatch trainBatch) {
+    size_t examples = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0);
+    while (elapsed.count() < 0.5) {
+        trainBatch();
+        examples += BATCH;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return examples / elapsed.count();
+}
+
+int main() {
+    const std::vector<std::vector<int>> shapes = {
+        {2, 4, 2, 1}, {6, 8, 8, 1}, {6, 8, 8, 8, 8, 1}, {16, 64, 64, 1}, {32, 256, 256, 1}, {64, 1024, 1024, 1},
+    };
+
+    std::cout << std::left << std::setw(24) << "shape" << std::right << std::setw(12) << "links"
+              << std::setw(14) << "graph ex/s" << std::setw(14) << "kernel ex/s" << std::setw(10) << "speedup"
+              << std::setw(14) << "kernel GF/s" << std::endl;
+    for (const auto& shape : shapes) {
+        std::string name;
+        std::vector<std::string> inputIds;
+        for (size_t l = 0; l < shape.size(); ++l) name += (l ? "-" : "") + std::to_string(shape[l]);
+        for (int i = 0; i < shape[0]; ++i) inputIds.push_back("x" + std::to_string(i));
+
+        std::vector<double> inputs(BATCH * shape[0]), targets(BATCH);
+        for (size_t i = 0; i < inputs.size(); ++i) inputs[i] = std::sin(i * 0.37);
+        for (size_t b = 0; b < BATCH; ++b) targets[b] = b % 2 ? 1.0 : -1.0;
+
+        nn::Network network = nn::buildNetwork(shape, nn::Activations::TANH, nn::Activations::TANH, nullptr,
+                                               inputIds, false, 1);
+        std::vector<double> input(shape[0]);
+        double graph = examplesPerSecond([&]() {
+            for (size_t b = 0; b < BATCH; ++b) {
+                input.assign(inputs.begin() + b * shape[0], inputs.begin() + (b + 1) * shape[0]);
+                nn::forwardProp(network, input);
+                nn::backProp(network, targets[b], nn::Errors::SQUARE);
+            }
+            nn::updateWeights(network, 0.03, 0);
+        });
+
+        auto kernel = nn::makeKernel(shape, nn::ActivationKind::TANH, nn::ActivationKind::TANH,
+                                     nn::RegularizationKind::NONE);
+        kernel->load(network);
+        double fast = examplesPerSecond([&]() {
+            kernel->train(inputs.data(), targets.data(), BATCH, nullptr);
+            kernel->update(0.03, 0);
+        });
+        nn::deleteNetwork(network);
+
+        // Forward, gradient and delta products: about 6 flops per link.
+        size_t links = countLinks(shape);
+        std::cout << std::left << std::setw(24) << name << std::right << std::setw(12) << links << std::fixed
+                  << std::setprecision(0) << std::setw(14) << graph << std::setw(14) << fast << std::setprecision(1)
+                  << std::setw(9) << fast / graph << "x" << std::setprecision(2) << std::setw(14)
+                  << fast * links * 6 / 1e9 << std::endl;
+    }
+
+    // The app evaluates the grid one column of 50 points at a time.
+    const size_t COLUMN = 50;
+    std::cout << std::endl
+              << std::left << std::setw(24) << "boundary 50x50" << std::right << std::setw(14) << "kernel ms"
+              << std::setw(14) << "fixed ms" << std::setw(10) << "speedup" << std::endl;
+    for (const auto& shape : shapes) {
+        std::string name;
+        std::vector<std::string> inputIds;
+        for (size_t l = 0; l < shape.size(); ++l) name += (l ? "-" : "") + std::to_string(shape[l]);
+        for (int i = 0; i < shape[0]; ++i) inputIds.push_back("x" + std::to_string(i));
+        std::vector<double> inputs(COLUMN * shape[0]), outputs(COLUMN);
+        for (size_t i = 0; i < inputs.size(); ++i) inputs[i] = 6 * std::sin(i * 0.37);
+
+        nn::Network network = nn::buildNetwork(shape, nn::Activations::TANH, nn::Activations::TANH, nullptr,
+                                               inputIds, false, 1);
+        auto kernel = nn::makeKernel(shape, nn::ActivationKind::TANH, nn::ActivationKind::TANH,
+                                     nn::RegularizationKind::NONE);
+        kernel->load(network);
+        nn::QuantizedNetwork quantized(shape, nn::ActivationKind::TANH, nn::ActivationKind::TANH);
+        quantized.load(network);
+        nn::deleteNetwork(network);
+        // examplesPerSecond counts BATCH per call; here a call is one column.
+        auto redrawMs = [&](auto column) { return 1000.0 * COLUMN * BATCH / examplesPerSecond(column); };
+        double exact = redrawMs([&]() { kernel->predict(inputs.data(), COLUMN, outputs.data()); });
+        double fixed = redrawMs([&]() { quantized.forward(inputs.data(), COLUMN); });
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(14) << exact << std::setw(14) << fixed << std::setprecision(1) << std::setw(9)
+                  << exact / fixed << "x" << std::endl;
+    }
+
+    // Scoring a batch of float rows, one example at a time or all at once.
+    const size_t SCORED = 1000;
+    std::cout << std::endl
+              << std::left << std::setw(24) << "scoring" << std::right << std::setw(14) << "single ex/s"
+              << std::setw(14) << "batch ex/s" << std::setw(10) << "speedup" << std::endl;
+    for (const auto& shape : shapes) {
+        std::string name;
+        std::vector<std::string> inputIds;
+        for (size_t l = 0; l < shape.size(); ++l) name += (l ? "-" : "") + std::to_string(shape[l]);
+        for (int i = 0; i < shape[0]; ++i) inputIds.push_back("x" + std::to_string(i));
+        std::vector<float> inputs(SCORED * shape[0]), outputs(SCORED);
+        for (size_t i = 0; i < inputs.size(); ++i) inputs[i] = static_cast<float>(std::sin(i * 0.37));
+
+        nn::Network network = nn::buildNetwork(shape, nn::Activations::TANH, nn::Activations::TANH, nullptr,
+                                               inputIds, false, 1);
+        std::vector<double> input(shape[0]);
+        // examplesPerSecond counts BATCH per call; here a call is SCORED rows.
+        auto scoredPerSecond = [&](auto score) { return examplesPerSecond(score) * SCORED / BATCH; };
+        double single = scoredPerSecond([&]() {
+            for (size_t i = 0; i < SCORED; ++i) {
+                input.assign(inputs.begin() + i * shape[0], inputs.begin() + (i + 1) * shape[0]);
+                outputs[i] = static_cast<float>(nn::forwardProp(network, input));
+            }
+        });
+        double batch = scoredPerSecond([&]() {
+            nn::forwardPropBatch(network, inputs.data(), SCORED, shape[0], outputs.data());
+        });
+        nn::deleteNetwork(network);
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(14) << single << std::setw(14) << batch << std::setprecision(1) << std::setw(9)
+                  << batch / single << "x" << std::endl;
+    }
+    return 0;
+}
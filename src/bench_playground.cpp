@@ -0,0 +1,375 @@
+#include "session.hpp"
+#include "quantized.hpp"
+#ifdef PLAYGROUND_BENCH_HEATMAP
+#include "heatmap.hpp"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Benchmark suite over the hot paths of the engine and the app, for
+// comparing builds and guarding against regressions. Sweeps network shapes
+// and sample counts and writes JSON: one entry per case with the median
+// and best time per item over several repetitions. Everything is seeded,
+// so runs differ only by the machine. The heat map colouring is measured
+// when the app is built; the other app paths are measured on the engine
+// calls PlaygroundApp makes.
+
+struct Options {
+    double minTime = 0.1;    // Seconds per repetition.
+    int repetitions = 5;
+    bool quick = false;      // Only the smallest case of every sweep.
+    std::string filter;      // Substring of the case names to run.
+    std::string out;         // JSON file; stdout if empty.
+};
+
+struct Result {
+    std::string name;
+    std::map<std::string, std::string> params;
+    size_t items;            // Items per call: examples, points or samples.
+    size_t calls;
+    double nsMedian;
+    double nsBest;
+};
+
+class Suite {
+public:
+    explicit Suite(const Options& options) : options(options) {}
+
+    bool wants(const std::string& name) const {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    /**
+     * Times `run`, which processes `items` items, after one untimed warm-up
+     * call. Each repetition calls it until options.minTime has passed (at
+     * least once). `setup`, if given, runs untimed before every call.
+     */
+    void measure(const std::string& name, const std::map<std::string, std::string>& params, size_t items,
+                 const std::function<void()>& run, const std::function<void()>& setup = {}) {
+        if (!wants(name)) return;
+        using Clock = std::chrono::steady_clock;
+        if (setup) setup();
+        run();
+        std::vector<double> nsPerItem;
+        size_t totalCalls = 0;
+        for (int rep = 0; rep < options.repetitions; ++rep) {
+            size_t calls = 0;
+            std::chrono::duration<double> timed(0);
+            auto start = Clock::now();
+            do {
+                if (setup) {
+                    setup();
+                    auto begin = Clock::now();
+                    run();
+                    timed += Clock::now() - begin;
+                } else {
+                    run();
+                    timed = Clock::now() - start;
+                }
+                ++calls;
+            } while ((setup ? std::chrono::duration<double>(Clock::now() - start) : timed).count() <
+                     options.minTime);
+            nsPerItem.push_back(timed.count() * 1e9 / (calls * items));
+            totalCalls += calls;
+        }
+        std::sort(nsPerItem.begin(), nsPerItem.end());
+        results.push_back({name, params, items, totalCalls, nsPerItem[nsPerItem.size() / 2], nsPerItem[0]});
+        std::cerr << name;
+        for (const auto& [key, value] : params) std::cerr << " " << key << "=" << value;
+        std::cerr << ": " << results.back().nsMedian << " ns/item" << std::endl;
+    }
+
+    void writeJson(std::ostream& out) const {
+        auto quoted = [](const std::string& text) {
+            std::string escaped = "\"";
+            for (char c : text) {
+                if (c == '"' || c == '\\') escaped += '\\';
+                escaped += c;
+            }
+            return escaped + "\"";
+        };
+        out.precision(6);
+        out << "{\n  \"context\": {\"repetitions\": " << options.repetitions << ", \"min_time\": " << options.minTime
+            << ", \"hardware_threads\": " << std::thread::hardware_concurrency() << ", \"assertions\": "
+#ifdef NDEBUG
+            << "false"
+#else
+            << "true"
+#endif
+            << "},\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << (i ? "," : "") << "\n    {\"name\": " << quoted(r.name) << ", \"params\": {";
+            size_t p = 0;
+            for (const auto& [key, value] : r.params) {
+                out << (p++ ? ", " : "") << quoted(key) << ": " << quoted(value);
+            }
+            out << "}, \"items_per_call\": " << r.items << ", \"calls\": " << r.calls
+                << ", \"ns_per_item\": " << r.nsMedian << ", \"ns_per_item_best\": " << r.nsBest
+                << ", \"items_per_second\": " << 1e9 / r.nsMedian << "}";
+        }
+        out << "\n  ]\n}" << std::endl;
+    }
+
+    const Options& options;
+
+private:
+    std::vector<Result> results;
+};
+
+// The full sweep, or its first entry with --quick.
+template <typename T>
+static std::vector<T> sweep(const Suite& suite, const std::vector<T>& values) {
+    return suite.options.quick ? std::vector<T>{values.front()} : values;
+}
+
+static std::string shapeName(const std::vector<int>& shape) {
+    std::string name;
+    for (size_t l = 0; l < shape.size(); ++l) name += (l ? "-" : "") + std::to_string(shape[l]);
+    return name;
+}
+
+static nn::Network buildBenchNetwork(const std::vector<int>& shape) {
+    std::vector<std::string> inputIds;
+    for (int i = 0; i < shape[0]; ++i) inputIds.push_back("x" + std::to_string(i));
+    return nn::buildNetwork(shape, nn::Activations::TANH, nn::Activations::TANH, nullptr, inputIds, false, 1);
+}
+
+// forwardProp, backProp and updateWeights on the graph, a batch of 10
+// examples per call as in the app.
+static void benchGraph(Suite& suite) {
+    const size_t BATCH = 10;
+    const std::vector<std::vector<int>> shapes = {
+        {2, 4, 2, 1}, {6, 8, 8, 1}, {6, 8, 8, 8, 8, 1}, {16, 64, 64, 1}, {32, 256, 256, 1},
+    };
+    for (const auto& shape : sweep(suite, shapes)) {
+        std::map<std::string, std::string> params = {{"shape", shapeName(shape)}};
+        std::vector<std::vector<double>> inputs(BATCH, std::vector<double>(shape[0]));
+        for (size_t b = 0; b < BATCH; ++b) {
+            for (int k = 0; k < shape[0]; ++k) inputs[b][k] = std::sin((b * shape[0] + k) * 0.37);
+        }
+        auto target = [](size_t b) { return b % 2 ? 1.0 : -1.0; };
+
+        nn::Network network = buildBenchNetwork(shape);
+        suite.measure("graph/forwardProp", params, BATCH, [&] {
+            for (const auto& input : inputs) nn::forwardProp(network, input);
+        });
+        // Derivatives for the last forward pass, accumulated BATCH times.
+        suite.measure("graph/backProp", params, BATCH, [&] {
+            for (size_t b = 0; b < BATCH; ++b) nn::backProp(network, target(b), nn::Errors::SQUARE);
+        });
+        nn::deleteNetwork(network);
+
+        // updateWeights consumes the accumulated derivatives, so each call
+        // updates copies that an untimed batch has just been run through;
+        // enough copies that a call is long next to the clock.
+        size_t links = 0;
+        for (size_t l = 1; l < shape.size(); ++l) links += static_cast<size_t>(shape[l - 1]) * shape[l];
+        size_t copies = std::max<size_t>(1, std::min<size_t>(64, 20000 / links));
+        std::vector<nn::Network> networks;
+        for (size_t c = 0; c < copies; ++c) networks.push_back(buildBenchNetwork(shape));
+        suite.measure(
+            "graph/updateWeights", params, copies,
+            [&] {
+                for (nn::Network& copy : networks) nn::updateWeights(copy, 0.03, 0);
+            },
+            [&] {
+                for (nn::Network& copy : networks) {
+                    for (size_t b = 0; b < BATCH; ++b) {
+                        nn::forwardProp(copy, inputs[b]);
+                        nn::backProp(copy, target(b), nn::Errors::SQUARE);
+                    }
+                }
+            });
+        for (nn::Network& copy : networks) nn::deleteNetwork(copy);
+    }
+}
+
+// What the app does per frame while training (PlaygroundApp::oneStep
+// without the drawing: one epoch and the losses), and getLoss alone.
+static void benchSession(Suite& suite) {
+    for (const std::string& shape : sweep(suite, std::vector<std::string>{"4,2", "8,8,8", "64,64"})) {
+        for (int numSamples : sweep(suite, std::vector<int>{500, 5000, 50000})) {
+            Session session;
+            session.state = applySettings(session.state, {{"seed", "1"}, {"dataset", "spiral"},
+                                                          {"networkShape", shape},
+                                                          {"numSamples", std::to_string(numSamples)}});
+            session.reset(true);
+            std::map<std::string, std::string> params = {{"hidden", shape}, {"samples", std::to_string(numSamples)}};
+            suite.measure("session/oneStep", params, session.examplesPerEpoch(), [&] {
+                session.step();
+                session.updateLosses();
+            });
+            playground::Dataset test = session.testData();
+            suite.measure("session/getLoss", params, test.size(),
+                          [&] { session.getLoss(session.getNetwork(), test); });
+        }
+    }
+}
+
+// The three ways PlaygroundApp::updateDecisionBoundary fills the 50x50
+// grid: every node through the graph, every node through the fixed-point
+// network (a column per batch), or only the output through the kernel.
+static void benchBoundary(Suite& suite) {
+    const int DENSITY = 50;
+    for (const std::string& shape : sweep(suite, std::vector<std::string>{"4,2", "8,8", "8,8,8,8", "64,64"})) {
+        Session session;
+        session.state = applySettings(session.state, {{"seed", "1"}, {"dataset", "spiral"}, {"networkShape", shape},
+                                                      {"xSquared", "1"}, {"ySquared", "1"}});
+        session.reset(true);
+        nn::Network& network = session.getNetwork();
+        size_t numInputs = network[0].size();
+        std::vector<int> layers;
+        for (const auto& layer : network) layers.push_back(static_cast<int>(layer.size()));
+        std::map<std::string, std::string> params = {{"shape", shapeName(layers)}};
+
+        std::vector<double> points(DENSITY * DENSITY * 2), outputs(DENSITY * DENSITY);
+        for (int i = 0; i < DENSITY; ++i) {
+            for (int j = 0; j < DENSITY; ++j) {
+                points[(i * DENSITY + j) * 2] = -6 + 12.0 * i / (DENSITY - 1);
+                points[(i * DENSITY + j) * 2 + 1] = -6 + 12.0 * j / (DENSITY - 1);
+            }
+        }
+        std::vector<double> input(numInputs), rows(DENSITY * numInputs);
+        std::vector<double> nodeOutputs(network.back()[0]->id + 1);
+        suite.measure("boundary/graph", params, DENSITY * DENSITY, [&] {
+            for (int p = 0; p < DENSITY * DENSITY; ++p) {
+                session.constructInput(&points[p * 2], input.data());
+                nn::forwardProp(network, input);
+                nn::forEachNode(network, true, [&](nn::Node* node) { nodeOutputs[node->id] = node->output; });
+            }
+        });
+        nn::QuantizedNetwork quantized(layers, nn::ActivationKind::TANH, nn::ActivationKind::TANH);
+        suite.measure("boundary/quantized", params, DENSITY * DENSITY, [&] {
+            quantized.load(network);
+            for (int i = 0; i < DENSITY; ++i) {
+                for (int j = 0; j < DENSITY; ++j) {
+                    session.constructInput(&points[(i * DENSITY + j) * 2], &rows[j * numInputs]);
+                }
+                quantized.forward(rows.data(), DENSITY);
+            }
+        });
+        suite.measure("boundary/kernel", params, DENSITY * DENSITY,
+                      [&] { session.predict(points.data(), outputs.size(), outputs.data()); });
+    }
+}
+
+// Every dataset generator kernel, on one thread and on all of them.
+static void benchGenerators(Suite& suite) {
+    const std::pair<const char*, playground::GeneratorKernel> kernels[] = {
+        {"circle", playground::circleKernel},
+        {"xor", playground::xorKernel},
+        {"gauss", playground::twoGaussKernel},
+        {"spiral", playground::spiralKernel},
+        {"star", playground::starKernel},
+        {"sine", playground::sineKernel},
+        {"checkerboard", playground::checkerboardKernel},
+        {"moons", playground::moonsKernel},
+        {"heart", playground::heartKernel},
+        {"reg-plane", playground::regressPlaneKernel},
+        {"reg-gauss", playground::regressGaussianKernel},
+    };
+    unsigned allThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts = {1};
+    if (allThreads > 1) threadCounts.push_back(allThreads);
+    for (size_t numSamples : sweep(suite, std::vector<size_t>{1000, 100000, 1000000})) {
+        std::vector<double> columns(3 * numSamples);
+        playground::ExampleColumns out{columns.data(), columns.data() + numSamples,
+                                       columns.data() + 2 * numSamples};
+        for (const auto& [name, kernel] : kernels) {
+            for (unsigned numThreads : threadCounts) {
+                std::map<std::string, std::string> params = {{"samples", std::to_string(numSamples)},
+                                                             {"threads", std::to_string(numThreads)}};
+                suite.measure(std::string("generator/") + name, params, numSamples, [&, kernel = kernel] {
+                    playground::generateParallel(kernel, {numSamples, 0.1, 1}, out, numThreads);
+                });
+            }
+        }
+    }
+}
+
+#ifdef PLAYGROUND_BENCH_HEATMAP
+// Colouring the boundary grid, continuous and discretized.
+static void benchHeatMap(Suite& suite) {
+    const int DENSITY = 50;
+    HeatMap heatMap(DENSITY, {-6.0, 6.0}, {-6.0, 6.0});
+    std::vector<std::vector<double>> grid(DENSITY, std::vector<double>(DENSITY));
+    for (int i = 0; i < DENSITY; ++i) {
+        for (int j = 0; j < DENSITY; ++j) grid[i][j] = std::sin(i * 0.3) * std::cos(j * 0.2);
+    }
+    for (bool discretize : {false, true}) {
+        suite.measure("heatmap/updateBackground", {{"discretize", discretize ? "1" : "0"}}, DENSITY * DENSITY,
+                      [&] { heatMap.updateBackground(grid, discretize); });
+    }
+}
+#endif
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --filter TEXT        run only the cases whose name contains TEXT\n"
+              << "                       (e.g. graph/, session/oneStep, generator/spiral)\n"
+              << "  --min-time S         seconds per repetition (default 0.1)\n"
+              << "  --repetitions N      repetitions per case; the median is reported (default 5)\n"
+              << "  --quick              only the smallest shape and sample count of each sweep\n"
+              << "  --out FILE           write the JSON there instead of stdout\n"
+              << "Progress goes to stderr." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::runtime_error("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--filter") options.filter = value();
+            else if (arg == "--min-time") options.minTime = std::stod(value());
+            else if (arg == "--repetitions") options.repetitions = std::max(1, std::stoi(value()));
+            else if (arg == "--quick") options.quick = true;
+            else if (arg == "--out") options.out = value();
+            else if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                return 0;
+            } else {
+                throw std::runtime_error("Unknown option " + arg);
+            }
+        }
+
+        Suite suite(options);
+        benchGraph(suite);
+        benchSession(suite);
+        benchBoundary(suite);
+        benchGenerators(suite);
+#ifdef PLAYGROUND_BENCH_HEATMAP
+        benchHeatMap(suite);
+#endif
+
+        if (options.out.empty()) {
+            suite.writeJson(std::cout);
+        } else {
+            std::ofstream file(options.out);
+            suite.writeJson(file);
+            if (!file) throw std::runtime_error("Could not write " + options.out);
+        }
+    } catch (const std::logic_error& e) {
+        std::cerr << "Error: malformed number (" << e.what() << ")" << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include "checkpoint.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nn {
+
+static_assert(sizeof(CheckpointHeader) == 64, "CheckpointHeader must stay 64 bytes");
+
+static const size_t SECTION_ALIGNMENT = 64;
+
+static size_t alignUp(size_t value) {
+    return (value + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+// Byte offsets of every section of a checkpoint file.
+struct Sections {
+    size_t shape, biases, weights, dead, strings, end;
+};
+
+static Sections sectionsFor(uint64_t numLayers, uint64_t numNodes, uint64_t numLinks, uint64_t stringBytes) {
+    Sections s;
+    s.shape = sizeof(CheckpointHeader);
+    s.biases = alignUp(s.shape + numLayers * sizeof(int32_t));
+    s.weights = alignUp(s.biases + numNodes * sizeof(double));
+    s.dead = alignUp(s.weights + numLinks * sizeof(double));
+    s.strings = alignUp(s.dead + numLinks);
+    s.end = s.strings + stringBytes;
+    return s;
+}
+
+static std::runtime_error fileError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+// ==============================================================================
+// SAVING
+// ==============================================================================
+
+void saveCheckpoint(const std::string& path, const Network& network, uint64_t iteration,
+                    const std::map<std::string, std::string>& metadata) {
+    std::string strings;
+    for (const Node* node : network[0]) {
+        strings += node->label;
+        strings += '\0';
+    }
+    for (const auto& [key, value] : metadata) {
+        strings += key + "=" + value + "\n";
+    }
+
+    size_t numNodes = 0, numLinks = 0;
+    for (const auto& layer : network) {
+        numNodes += layer.size();
+        for (const Node* node : layer) {
+            numLinks += node->inputLinks.size();
+        }
+    }
+
+    CheckpointHeader header = {};
+    std::memcpy(header.magic, "NNCK", 4);
+    header.version = CHECKPOINT_VERSION;
+    header.numLayers = static_cast<uint32_t>(network.size());
+    header.numNodes = static_cast<uint32_t>(numNodes);
+    header.numLinks = numLinks;
+    header.iteration = iteration;
+    header.stringBytes = strings.size();
+    Sections s = sectionsFor(header.numLayers, numNodes, numLinks, strings.size());
+
+    // Lay the whole file out in memory so it goes to disk in one write.
+    std::vector<uint8_t> buffer(s.end, 0);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    int32_t* shape = reinterpret_cast<int32_t*>(buffer.data() + s.shape);
+    double* biases = reinterpret_cast<double*>(buffer.data() + s.biases);
+    double* weights = reinterpret_cast<double*>(buffer.data() + s.weights);
+    uint8_t* dead = buffer.data() + s.dead;
+    for (const auto& layer : network) {
+        *shape++ = static_cast<int32_t>(layer.size());
+        for (const Node* node : layer) {
+            *biases++ = node->bias;
+            for (const Link* link : node->inputLinks) {
+                *weights++ = link->weight;
+                *dead++ = link->isDead ? 1 : 0;
+            }
+        }
+    }
+    std::memcpy(buffer.data() + s.strings, strings.data(), strings.size());
+
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw fileError("Cannot create checkpoint", tmpPath);
+    }
+    const uint8_t* p = buffer.data();
+    size_t remaining = buffer.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, p, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            std::remove(tmpPath.c_str());
+            throw fileError("Cannot write checkpoint", tmpPath);
+        }
+        p += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    if (::close(fd) != 0 || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        throw fileError("Cannot write checkpoint", path);
+    }
+}
+
+// ==============================================================================
+// MAPPED CHECKPOINT
+// ==============================================================================
+
+MappedCheckpoint::MappedCheckpoint(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw fileError("Cannot open checkpoint", path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw fileError("Cannot stat checkpoint", path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length < sizeof(CheckpointHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Checkpoint file '" + path + "' is too small");
+    }
+    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        throw fileError("Cannot map checkpoint", path);
+    }
+    base = static_cast<const uint8_t*>(mapped);
+    header = reinterpret_cast<const CheckpointHeader*>(base);
+
+    std::string error;
+    if (std::memcmp(header->magic, "NNCK", 4) != 0) {
+        error = "bad magic";
+    } else if (header->version != CHECKPOINT_VERSION) {
+        error = "unsupported version " + std::to_string(header->version);
+    } else if (header->numLayers < 2) {
+        error = "fewer than two layers";
+    } else if (header->numNodes > length / sizeof(double) || header->numLinks > length / sizeof(double) ||
+               header->stringBytes > length) {
+        // Checked before sectionsFor, whose offsets could otherwise wrap.
+        error = "truncated";
+    } else if (length < sectionsFor(header->numLayers, header->numNodes, header->numLinks, header->stringBytes).end) {
+        error = "truncated";
+    } else {
+        // The shape must account for every node and link (fully connected).
+        std::vector<int> layers = shape();
+        uint64_t nodes = 0, links = 0;
+        for (size_t l = 0; l < layers.size(); ++l) {
+            if (layers[l] <= 0) error = "empty layer";
+            nodes += layers[l];
+            if (l > 0) links += static_cast<uint64_t>(layers[l - 1]) * layers[l];
+        }
+        if (error.empty() && (nodes != header->numNodes || links != header->numLinks)) {
+            error = "shape does not match the node and link counts";
+        }
+    }
+    if (error.empty()) {
+        Sections s = sectionsFor(header->numLayers, header->numNodes, header->numLinks, header->stringBytes);
+        const char* strings = reinterpret_cast<const char*>(base + s.strings);
+        const char* end = strings + header->stringBytes;
+        size_t numInputs = static_cast<size_t>(shape()[0]);
+        while (ids.size() < numInputs && strings < end) {
+            const char* nul = static_cast<const char*>(std::memchr(strings, '\0', end - strings));
+            if (!nul) break;
+            ids.emplace_back(strings, nul);
+            strings = nul + 1;
+        }
+        while (strings < end) {
+            const char* eol = static_cast<const char*>(std::memchr(strings, '\n', end - strings));
+            std::string line(strings, eol ? eol : end);
+            size_t eq = line.find('=');
+            if (eq != std::string::npos) {
+                meta[line.substr(0, eq)] = line.substr(eq + 1);
+            }
+            strings = eol ? eol + 1 : end;
+        }
+        if (ids.size() != numInputs) {
+            error = "missing input ids";
+        }
+    }
+    if (!error.empty()) {
+        ::munmap(const_cast<uint8_t*>(base), length);
+        throw std::runtime_error("Invalid checkpoint file '" + path + "': " + error);
+    }
+}
+
+MappedCheckpoint::~MappedCheckpoint() {
+    if (base) {
+        ::munmap(const_cast<uint8_t*>(base), length);
+    }
+}
+
+std::vector<int> MappedCheckpoint::shape() const {
+    const int32_t* layers = reinterpret_cast<const int32_t*>(base + sizeof(CheckpointHeader));
+    return std::vector<int>(layers, layers + header->numLayers);
+}
+
+const double* MappedCheckpoint::biases() const {
+    Sections s = sectionsFor(header->numLayers, header->numNodes, header->numLinks, header->stringBytes);
+    return reinterpret_cast<const double*>(base + s.biases);
+}
+
+const double* MappedCheckpoint::weights() const {
+    Sections s = sectionsFor(header->numLayers, header->numNodes, header->numLinks, header->stringBytes);
+    return reinterpret_cast<const double*>(base + s.weights);
+}
+
+const uint8_t* MappedCheckpoint::deadFlags() const {
+    Sections s = sectionsFor(header->numLayers, header->numNodes, header->numLinks, header->stringBytes);
+    return base + s.dead;
+}
+
+// ==============================================================================
+// RESTORING
+// ==============================================================================
+
+Network restoreNetwork(const MappedCheckpoint& checkpoint, const ActivationFunction& activation,
+                       const ActivationFunction& outputActivation, const RegularizationFunction* regularization) {
+    std::vector<int> shape = checkpoint.shape();
+    const double* biases = checkpoint.biases();
+    const double* weights = checkpoint.weights();
+    const uint8_t* dead = checkpoint.deadFlags();
+
+    // Node ids and link order follow buildNetwork, so a restored network is
+    // indistinguishable from the one that was saved.
+    int nodeCounter = 0, linkCounter = 0;
+    Network network(shape.size());
+    for (size_t layerIdx = 0; layerIdx < shape.size(); ++layerIdx) {
+        bool isOutputLayer = layerIdx == shape.size() - 1;
+        for (int i = 0; i < shape[layerIdx]; ++i) {
+            Node* node = new Node(nodeCounter++, isOutputLayer ? outputActivation : activation, false,
+                                  layerIdx == 0 ? checkpoint.inputIds()[i] : std::string());
+            node->bias = *biases++;
+            network[layerIdx].push_back(node);
+            if (layerIdx >= 1) {
+                for (Node* prevNode : network[layerIdx - 1]) {
+                    Link* link = new Link(linkCounter++, prevNode, node, regularization, *weights++);
+                    link->isDead = *dead++ != 0;
+                    prevNode->outputs.push_back(link);
+                    node->inputLinks.push_back(link);
+                }
+            }
+        }
+    }
+    return network;
+}
+
+} // namespace nn
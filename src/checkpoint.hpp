@@ -0,0 +1,95 @@
+#pragma once
+
+#include "nn.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace nn {
+
+/**
+ * On-disk layout of a network checkpoint (all fields little-endian):
+ *
+ *   CheckpointHeader                   (64 bytes)
+ *   int32 shape[numLayers]
+ *   float64 bias[numNodes]             (layer by layer, input nodes included)
+ *   float64 weight[numLinks]           (layer by layer; within a layer, the
+ *                                       input links of each node in order)
+ *   uint8 isDead[numLinks]
+ *   char strings[stringBytes]          (NUL-terminated input ids, followed by
+ *                                       "key=value\n" metadata lines)
+ *
+ * Every section starts on a 64-byte boundary, so the weight and bias blocks
+ * can be read in place from a mapped file.
+ */
+struct CheckpointHeader {
+    char magic[4];        // "NNCK"
+    uint32_t version;     // CHECKPOINT_VERSION
+    uint32_t numLayers;
+    uint32_t numNodes;
+    uint64_t numLinks;
+    uint64_t iteration;   // Training epoch the checkpoint was taken at.
+    uint64_t stringBytes;
+    uint64_t reserved[3];
+};
+
+constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+/**
+ * Writes `network` to `path` as a single contiguous block. The file is written
+ * next to `path` and renamed over it, so an interrupted save never leaves a
+ * truncated checkpoint behind. `metadata` carries application settings (the
+ * playground stores its hyperparameters there); keys and values must not
+ * contain '=' or newlines respectively. Throws std::runtime_error on I/O
+ * errors.
+ */
+void saveCheckpoint(const std::string& path, const Network& network, uint64_t iteration,
+                    const std::map<std::string, std::string>& metadata);
+
+/**
+ * A checkpoint file mapped read-only into memory. The constructor validates
+ * the header and section sizes; the weight and bias blocks are then read
+ * directly from the mapping.
+ */
+class MappedCheckpoint {
+public:
+    /**
+     * Maps the file at `path`. Throws std::runtime_error if the file cannot be
+     * opened or is not a valid checkpoint.
+     */
+    explicit MappedCheckpoint(const std::string& path);
+    ~MappedCheckpoint();
+
+    MappedCheckpoint(const MappedCheckpoint&) = delete;
+    MappedCheckpoint& operator=(const MappedCheckpoint&) = delete;
+
+    std::vector<int> shape() const;
+    uint64_t iteration() const { return header->iteration; }
+    size_t numNodes() const { return header->numNodes; }
+    size_t numLinks() const { return header->numLinks; }
+
+    const double* biases() const;
+    const double* weights() const;
+    const uint8_t* deadFlags() const;
+
+    const std::vector<std::string>& inputIds() const { return ids; }
+    const std::map<std::string, std::string>& metadata() const { return meta; }
+
+private:
+    const CheckpointHeader* header = nullptr;
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    std::vector<std::string> ids;
+    std::map<std::string, std::string> meta;
+};
+
+/**
+ * Rebuilds the network stored in `checkpoint`. Nodes and links are created
+ * directly from the mapped blocks, skipping buildNetwork's weight init.
+ * IMPORTANT: The returned network must be freed using `deleteNetwork`.
+ */
+Network restoreNetwork(const MappedCheckpoint& checkpoint, const ActivationFunction& activation,
+                       const ActivationFunction& outputActivation, const RegularizationFunction* regularization);
+
+} // namespace nn
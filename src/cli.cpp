@@ -0,0 +1,263 @@
+#include "session.hpp"
+#include "sweep.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Headless trainer: runs a Session for a number of epochs and prints losses
+// and throughput, without any window or GL context. With --vary it runs a
+// hyperparameter sweep instead, one Session per configuration.
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --epochs N            epochs to train (default 100)\n"
+              << "  --config FILE         read key=value settings, one per line\n"
+              << "  --set KEY=VALUE       override one setting (repeatable)\n"
+              << "  --dataset-file FILE   register a binary dataset file (repeatable)\n"
+              << "  --resume FILE         start from a checkpoint; --set can then change only\n"
+              << "                        optimizer, lbfgs, lbfgsHistory, fastActivations,\n"
+              << "                        learningRate, regularizationRate and batchSize\n"
+              << "  --checkpoint FILE     write a checkpoint when training ends\n"
+              << "  --checkpoint-every N  also write it every N epochs\n"
+              << "  --export FILE         write the trained network as a C++ header with a\n"
+              << "                        predict() function, in a namespace named after FILE\n"
+              << "  --report N            print losses every N epochs (default 10)\n"
+              << "Sweeps:\n"
+              << "  --vary KEY=V1/V2/...  sweep a setting over these values (repeatable)\n"
+              << "  --random N            draw N random configurations instead of the grid;\n"
+              << "                        a value LO..HI is then sampled from that range\n"
+              << "  --threads N           concurrent runs (default: all hardware threads)\n"
+              << "  --target-loss X       record when each run's test loss reaches X\n"
+              << "  --results FILE        write the CSV results there (default: stdout)\n"
+              << "Settings use the checkpoint keys, e.g. dataset=spiral, networkShape=8,8,\n"
+              << "learningRate=0.03, batchSize=10, numSamples=500, seed=1." << std::endl;
+}
+
+// Splits "key=value" into `settings`. Returns false if there is no '='.
+static bool parseSetting(const std::string& line, std::map<std::string, std::string>& settings) {
+    size_t eq = line.find('=');
+    if (eq == std::string::npos) {
+        return false;
+    }
+    settings[line.substr(0, eq)] = line.substr(eq + 1);
+    return true;
+}
+
+// A C++ identifier from the file name of `path`: "out/spiral-net.hpp"
+// becomes "spiral_net".
+static std::string namespaceFor(const std::string& path) {
+    size_t begin = path.find_last_of("/\\") + 1;
+    size_t end = path.find('.', begin);
+    std::string name = path.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    for (char& c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c))) c = '_';
+    }
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) name = "model_" + name;
+    return name;
+}
+
+static void readConfig(const std::string& path, std::map<std::string, std::string>& settings) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open config '" + path + "'");
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        if (!parseSetting(line, settings)) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected key=value");
+        }
+    }
+}
+
+// Runs the sweep, streaming one CSV row per finished run.
+static int runSweepCommand(SweepSpec& sweep, const std::map<std::string, std::string>& settings, int epochs,
+                           unsigned numThreads, const std::string& resultsPath) {
+    sweep.base = settings;
+    sweep.epochs = epochs;
+    std::ofstream file;
+    if (!resultsPath.empty()) {
+        file.open(resultsPath);
+        if (!file) {
+            throw std::runtime_error("Cannot create results file '" + resultsPath + "'");
+        }
+    }
+    std::ostream& out = resultsPath.empty() ? std::cout : file;
+
+    size_t numRuns = sweepConfigurations(sweep).size();
+    size_t done = 0, failed = 0;
+    SweepResult best;
+    best.lossTest = INFINITY;
+    auto start = std::chrono::steady_clock::now();
+    writeSweepHeader(out, sweep);
+    runSweep(sweep, numThreads, [&](const SweepResult& result) {
+        writeSweepRow(out, sweep, result);
+        ++done;
+        if (!result.error.empty()) {
+            ++failed;
+        } else if (result.lossTest < best.lossTest) {
+            best = result;
+        }
+        if (!resultsPath.empty()) {
+            std::cerr << "\r" << done << "/" << numRuns << " runs" << std::flush;
+        }
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::ostream& log = resultsPath.empty() ? std::cerr : std::cout;
+    if (!resultsPath.empty()) std::cerr << std::endl;
+    log << numRuns << " runs in " << std::setprecision(3) << elapsed.count() << " s";
+    if (failed > 0) log << ", " << failed << " failed";
+    log << std::endl;
+    if (std::isfinite(best.lossTest)) {
+        log << "best test loss " << best.lossTest << " (run " << best.index << ":";
+        for (const auto& [key, value] : best.settings) {
+            log << " " << key << "=" << value;
+        }
+        log << ")" << std::endl;
+    }
+    return failed == numRuns ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    int epochs = 100;
+    int reportEvery = 10;
+    int checkpointEvery = 0;
+    std::string resumePath, checkpointPath, exportPath;
+    std::vector<std::string> datasetFiles;
+    std::map<std::string, std::string> settings;
+    SweepSpec sweep;
+    unsigned numThreads = 0;
+    std::string resultsPath;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                return 0;
+            }
+            if (i + 1 >= argc) {
+                printUsage(argv[0]);
+                return 2;
+            }
+            std::string value = argv[++i];
+            if (arg == "--epochs") epochs = std::stoi(value);
+            else if (arg == "--report") reportEvery = std::max(1, std::stoi(value));
+            else if (arg == "--checkpoint-every") checkpointEvery = std::stoi(value);
+            else if (arg == "--config") readConfig(value, settings);
+            else if (arg == "--set" && parseSetting(value, settings)) {}
+            else if (arg == "--dataset-file") datasetFiles.push_back(value);
+            else if (arg == "--resume") resumePath = value;
+            else if (arg == "--checkpoint") checkpointPath = value;
+            else if (arg == "--export") exportPath = value;
+            else if (arg == "--vary") sweep.axes.push_back(parseSweepAxis(value));
+            else if (arg == "--random") sweep.randomSamples = std::stoul(value);
+            else if (arg == "--threads") numThreads = static_cast<unsigned>(std::stoul(value));
+            else if (arg == "--target-loss") sweep.targetLoss = std::stod(value);
+            else if (arg == "--results") resultsPath = value;
+            else {
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+        // A sweep trains many sessions and keeps none of them.
+        if (!sweep.axes.empty() &&
+            (!resumePath.empty() || !checkpointPath.empty() || checkpointEvery > 0 || !exportPath.empty())) {
+            std::cerr << "--vary cannot be combined with --resume, --checkpoint, --checkpoint-every or --export"
+                      << std::endl;
+            printUsage(argv[0]);
+            return 2;
+        }
+
+        Session session;
+        for (const auto& path : datasetFiles) {
+            std::cout << "Loaded dataset '" << session.loadDatasetFile(path) << "'" << std::endl;
+        }
+        if (!sweep.axes.empty()) {
+            return runSweepCommand(sweep, settings, epochs, numThreads, resultsPath);
+        }
+        if (!resumePath.empty()) {
+            session.loadCheckpoint(resumePath);
+            // Command-line settings override the checkpoint's training
+            // hyperparameters; data and shape settings must match it.
+            session.applyOverrides(settings);
+            std::cout << "Resumed '" << resumePath << "' at epoch " << session.iteration() << std::endl;
+        } else {
+            session.state = applySettings(session.state, settings);
+            session.reset(true);
+        }
+
+        std::cout << "seed: " << session.state.seed << ", train examples/epoch: " << session.examplesPerEpoch()
+                  << ", test examples: " << session.testData().size() << std::endl;
+        std::cout << std::setw(8) << "epoch" << std::setw(12) << "train loss" << std::setw(12) << "test loss"
+                  << std::setw(16) << "examples/s" << std::endl;
+
+        auto report = [&](double examplesPerSecond) {
+            session.updateLosses();
+            std::cout << std::setw(8) << session.iteration() << std::fixed << std::setprecision(6)
+                      << std::setw(12) << session.lossTrain() << std::setw(12) << session.lossTest()
+                      << std::setprecision(0) << std::setw(16) << examplesPerSecond << std::endl;
+        };
+        report(0);
+
+        // Only the training epochs are timed; loss evaluation and checkpoint
+        // writes are excluded from the throughput.
+        std::chrono::duration<double> trainTime(0), sinceReport(0);
+        size_t examplesSinceReport = 0, examplesTotal = 0;
+        for (int epoch = 1; epoch <= epochs; ++epoch) {
+            auto start = std::chrono::steady_clock::now();
+            session.step();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            trainTime += elapsed;
+            sinceReport += elapsed;
+            examplesSinceReport += session.examplesPerEpoch();
+            examplesTotal += session.examplesPerEpoch();
+
+            const nn::Lbfgs* lbfgs = session.lbfgsProgress();
+            if (lbfgs && lbfgs->status() != nn::Lbfgs::Status::RUNNING) {
+                report(examplesSinceReport / std::max(sinceReport.count(), 1e-9));
+                std::cout << "L-BFGS " << (lbfgs->status() == nn::Lbfgs::Status::CONVERGED ? "converged" : "stalled")
+                          << " at epoch " << epoch << " after " << lbfgs->evaluations()
+                          << " evaluations, gradient norm " << std::scientific << std::setprecision(2)
+                          << lbfgs->gradientNorm() << std::fixed << std::endl;
+                epochs = epoch;
+                break;
+            }
+            if (epoch % reportEvery == 0 || epoch == epochs) {
+                report(examplesSinceReport / std::max(sinceReport.count(), 1e-9));
+                sinceReport = std::chrono::duration<double>(0);
+                examplesSinceReport = 0;
+            }
+            if (!checkpointPath.empty() && checkpointEvery > 0 && epoch % checkpointEvery == 0) {
+                session.saveCheckpoint(checkpointPath);
+            }
+        }
+        if (!checkpointPath.empty()) {
+            session.saveCheckpoint(checkpointPath);
+            std::cout << "Wrote checkpoint '" << checkpointPath << "'" << std::endl;
+        }
+        if (!exportPath.empty()) {
+            session.exportSource(exportPath, namespaceFor(exportPath));
+            std::cout << "Wrote '" << exportPath << "'" << std::endl;
+        }
+        std::cout << "Trained " << epochs << " epochs in " << std::setprecision(3) << trainTime.count() << " s ("
+                  << std::setprecision(0) << examplesTotal / std::max(trainTime.count(), 1e-9) << " examples/s)"
+                  << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "codegen.hpp"
+#include <cctype>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace nn {
+
+// `total` passed through the activation, as C++ source.
+static std::string applyActivation(ActivationKind kind, const std::string& total) {
+    switch (kind) {
+    case ActivationKind::TANH:
+        return "std::tanh(" + total + ")";
+    case ActivationKind::RELU:
+        return "std::max(0.0, " + total + ")";
+    case ActivationKind::SIGMOID:
+        return "1.0 / (1.0 + std::exp(-(" + total + ")))";
+    case ActivationKind::LINEAR:
+        break;
+    case ActivationKind::FAST_TANH:
+        return "fastTanh(" + total + ")";
+    case ActivationKind::FAST_SIGMOID:
+        return "fastSigmoid(" + total + ")";
+    }
+    return total;
+}
+
+static bool isFast(ActivationKind kind) {
+    return kind == ActivationKind::FAST_TANH || kind == ActivationKind::FAST_SIGMOID;
+}
+
+// fastExp, fastTanh and fastSigmoid of kernel_math.hpp, for headers that use
+// the FAST_ kinds. Keep them in step.
+static const char* const FAST_FUNCTIONS = R"(// The playground's approximations of tanh and the sigmoid.
+inline double fastExp(double x) {
+    const double LOG2E = 1.4426950408889634;
+    const double LN2_HI = 6.93147180369123816490e-01, LN2_LO = 1.90821492927058770002e-10;
+    const double SHIFT = 6755399441055744.0;
+    double t = x * LOG2E + SHIFT;
+    double k = t - SHIFT;
+    double r = (x - k * LN2_HI) - k * LN2_LO;
+    double p = 1.0 / 5040;
+    p = p * r + 1.0 / 720;
+    p = p * r + 1.0 / 120;
+    p = p * r + 1.0 / 24;
+    p = p * r + 1.0 / 6;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+    std::int64_t bits, shiftBits;
+    std::memcpy(&bits, &t, sizeof bits);
+    std::memcpy(&shiftBits, &SHIFT, sizeof shiftBits);
+    std::uint64_t scaleBits = static_cast<std::uint64_t>(bits - shiftBits + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &scaleBits, sizeof scale);
+    return p * scale;
+}
+
+inline double clampAbs(double x, double limit) {
+    return 0.5 * (std::abs(x + limit) - std::abs(x - limit));
+}
+
+inline double fastTanh(double x) {
+    return 1 - 2 / (fastExp(2 * clampAbs(x, 20.0)) + 1);
+}
+
+inline double fastSigmoid(double x) {
+    return 1 / (1 + fastExp(-clampAbs(x, 700.0)));
+}
+
+)";
+
+static const char* kindName(ActivationKind kind) {
+    switch (kind) {
+    case ActivationKind::TANH: return "tanh";
+    case ActivationKind::RELU: return "relu";
+    case ActivationKind::SIGMOID: return "sigmoid";
+    case ActivationKind::LINEAR: return "linear";
+    case ActivationKind::FAST_TANH: return "fast tanh";
+    case ActivationKind::FAST_SIGMOID: return "fast sigmoid";
+    }
+    return "";
+}
+
+// True if `source` uses the identifier `name`.
+static bool mentions(const std::string& source, const std::string& name) {
+    auto isIdentifier = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+    for (size_t at = source.find(name); at != std::string::npos; at = source.find(name, at + 1)) {
+        size_t end = at + name.size();
+        if ((at == 0 || !isIdentifier(source[at - 1])) && (end == source.size() || !isIdentifier(source[end]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Writes `values` as the body of an array initializer, four per line.
+static void writeValues(std::ostream& out, const std::vector<double>& values) {
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i % 4 == 0 ? "\n    " : " ") << values[i] << ",";
+    }
+    out << "\n";
+}
+
+std::string generateSource(const Network& network, ActivationKind activation, ActivationKind outputActivation,
+                           const std::vector<std::string>& arguments, const std::vector<std::string>& inputs,
+                           const std::string& name) {
+    if (inputs.size() != network[0].size()) {
+        throw std::runtime_error("Expected one input expression per input node");
+    }
+    std::vector<double> weights, biases;
+    std::string shape;
+    for (const auto& layer : network) {
+        shape += (shape.empty() ? "" : "-") + std::to_string(layer.size());
+        for (const Node* node : layer) {
+            biases.push_back(node->bias);
+            for (const Link* link : node->inputLinks) {
+                if (static_cast<size_t>(link->id) >= weights.size()) weights.resize(link->id + 1);
+                weights[link->id] = link->weight;
+            }
+        }
+    }
+    // Arrays cannot be empty.
+    if (weights.empty()) weights.push_back(0.0);
+
+    std::ostringstream out;
+    // Enough digits that every value reads back exactly.
+    out << std::setprecision(std::numeric_limits<double>::max_digits10);
+    out << "// Generated by the neural network playground: a " << shape << " network with "
+        << kindName(activation) << " hidden and " << kindName(outputActivation) << " output activations.\n"
+        << "#pragma once\n\n"
+        << "#include <algorithm>\n"
+        << "#include <cmath>\n";
+    bool fast = isFast(activation) || isFast(outputActivation);
+    if (fast) out << "#include <cstdint>\n#include <cstring>\n";
+    out << "\nnamespace " << name << " {\n\n";
+    if (fast) out << FAST_FUNCTIONS;
+    out << "// Weights by link id.\n"
+        << "inline constexpr double WEIGHTS[" << weights.size() << "] = {";
+    writeValues(out, weights);
+    out << "};\n\n"
+        << "// Biases by node id; those of the input nodes are unused.\n"
+        << "inline constexpr double BIASES[" << biases.size() << "] = {";
+    writeValues(out, biases);
+    out << "};\n\n"
+        << "inline double predict(";
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        bool used = false;
+        for (const auto& input : inputs) used = used || mentions(input, arguments[i]);
+        out << (i ? ", " : "") << (used ? "" : "[[maybe_unused]] ") << "double " << arguments[i];
+    }
+    out << ") {\n";
+    for (size_t i = 0; i < network[0].size(); ++i) {
+        out << "    const double n" << network[0][i]->id << " = " << inputs[i] << ";\n";
+    }
+    for (size_t l = 1; l < network.size(); ++l) {
+        for (const Node* node : network[l]) {
+            std::string total = "BIASES[" + std::to_string(node->id) + "]";
+            for (const Link* link : node->inputLinks) {
+                total += " + WEIGHTS[" + std::to_string(link->id) + "] * n" + std::to_string(link->source->id);
+            }
+            out << "    const double n" << node->id << " = "
+                << applyActivation(l + 1 == network.size() ? outputActivation : activation, total) << ";\n";
+        }
+    }
+    out << "    return n" << network.back()[0]->id << ";\n"
+        << "}\n\n"
+        << "} // namespace " << name << "\n";
+    return out.str();
+}
+
+} // namespace nn
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "nn.hpp"
+#include <string>
+#include <vector>
+
+namespace nn {
+
+/**
+ * Returns a self-contained C++17 header that computes `network` without
+ * this library: the weights (by link id) and biases (by node id) as
+ * constexpr arrays, and an inline `predict` in namespace `name` with one
+ * statement per node and every loop unrolled. `arguments` name the
+ * parameters of predict, and `inputs` gives the value of each input node as
+ * a C++ expression over them, e.g. "x * x".
+ *
+ * The sums run in the order forwardProp uses, so predict returns the same
+ * value unless the compiler fuses multiply-adds. Headers with FAST_ kinds
+ * also define the polynomial approximations those use. Throws
+ * std::runtime_error if `inputs` does not match the input layer.
+ */
+std::string generateSource(const Network& network, ActivationKind activation, ActivationKind outputActivation,
+                           const std::vector<std::string>& arguments, const std::vector<std::string>& inputs,
+                           const std::string& name);
+
+} // namespace nn
@@ -0,0 +1,20 @@
+#include "dataset_file.hpp"
+#include <iostream>
+
+// One-time converter from x,y,label CSV files to the binary dataset format.
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.csv> <output.nnpd>" << std::endl;
+        return 2;
+    }
+    try {
+        size_t rows = playground::convertCsvToDataset(argv[1], argv[2]);
+        playground::MappedDataset dataset(argv[2]);
+        std::cout << "Wrote " << rows << " rows ("
+                  << (dataset.isClassification() ? "classification" : "regression") << ") to " << argv[2] << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -5,7 +5,9 @@
 #include <algorithm>
 #include <vector>
 #include <array>
-#include <chrono> // Required for a better random seed
+#include <thread>
+
+#include "random.hpp"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -17,39 +19,6 @@ namespace playground {
 // UTILITY/HELPER FUNCTIONS
 // ==============================================================================
 
-// A helper to get a thread-safe random number generator, seeded once.
-// This version uses a more robust seeding mechanism.
-static std::mt19937& getRandomEngine() {
-    // Seed with a combination of a random device and the current time to ensure
-    // high-quality randomness and prevent deterministic behavior on some platforms.
-    static std::seed_seq ss{
-        static_cast<unsigned int>(std::chrono::high_resolution_clock::now().time_since_epoch().count()),
-        std::random_device{}(),
-        std::random_device{}(),
-        std::random_device{}(),
-    };
-    static std::mt19937 engine(ss);
-    return engine;
-}
-
-/**
- * Returns a sample from a uniform [a, b] distribution.
- */
-static double randUniform(double a, double b) {
-    std::uniform_real_distribution<double> dist(a, b);
-    return dist(getRandomEngine());
-}
-
-/**
- * Samples from a normal distribution.
- * @param mean The mean.
- * @param variance The variance.
- */
-static double normalRandom(double mean = 0.0, double variance = 1.0) {
-    std::normal_distribution<double> dist(mean, std::sqrt(variance));
-    return dist(getRandomEngine());
-}
-
 /**
  * Returns the Euclidean distance between two points.
  */
@@ -79,291 +48,619 @@ static double linearScale(double value, double domainMin, double domainMax, doub
 // PUBLIC API IMPLEMENTATION
 // ==============================================================================
 
-void shuffle(std::vector<Example2D>& array) {
-    std::shuffle(array.begin(), array.end(), getRandomEngine());
+// Fisher-Yates over [first, first + n) where the swap partner for position i
+// is drawn from counter (base + i), so the result only depends on the stream.
+template<typename T>
+static void shuffleRange(T* first, size_t n, const rng::Stream& stream, uint64_t base) {
+    for (size_t i = n; i-- > 1;) {
+        size_t j = static_cast<size_t>(stream.below(i + 1, base + i));
+        std::swap(first[i], first[j]);
+    }
 }
 
-std::vector<Example2D> classifyTwoGaussData(int numSamples, double noise) {
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
+void shuffle(std::vector<Example2D>& array, uint64_t seed) {
+    shuffleRange(array.data(), array.size(), rng::Stream(seed, rng::SHUFFLE), 0);
+}
 
-    double variance = linearScale(noise, 0.0, 0.5, 0.5, 4.0);
+void permutation(std::vector<uint32_t>& order, size_t n, size_t blockSize, uint64_t seed, uint64_t epoch) {
+    order.resize(n);
+    const rng::Stream stream = rng::Stream(seed, rng::EPOCH_ORDER).fork(epoch);
 
-    // Correctly split samples to handle odd numSamples.
-    const int n1 = numSamples / 2;
-    const int n2 = numSamples - n1;
-
-    auto genGauss = [&](int count, double cx, double cy, double label) {
-        for (int i = 0; i < count; i++) {
-            double x = normalRandom(cx, variance);
-            double y = normalRandom(cy, variance);
-            points.push_back({x, y, label});
+    if (blockSize <= 1 || blockSize >= n) {
+        for (size_t i = 0; i < n; ++i) {
+            order[i] = static_cast<uint32_t>(i);
         }
-    };
+        shuffleRange(order.data(), n, stream, 0);
+        return;
+    }
 
-    genGauss(n1, 2, 2, 1);  // Gaussian with positive examples.
-    genGauss(n2, -2, -2, -1); // Gaussian with negative examples.
-    return points;
+    // Shuffle the full blocks' ids in the head of the buffer, then expand them
+    // back to front. Block k is written to [k * blockSize, (k + 1) * blockSize),
+    // which never overlaps a block id that has not been read yet.
+    const size_t numFull = n / blockSize;
+    for (size_t k = 0; k < numFull; ++k) {
+        order[k] = static_cast<uint32_t>(k);
+    }
+    shuffleRange(order.data(), numFull, stream, n);
+    for (size_t i = numFull * blockSize; i < n; ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    for (size_t k = numFull; k-- > 0;) {
+        const size_t start = static_cast<size_t>(order[k]) * blockSize;
+        for (size_t j = 0; j < blockSize; ++j) {
+            order[k * blockSize + j] = static_cast<uint32_t>(start + j);
+        }
+    }
+
+    // Shuffle within each block (including the trailing partial one).
+    for (size_t begin = 0; begin < n; begin += blockSize) {
+        shuffleRange(order.data() + begin, std::min(blockSize, n - begin), stream, begin);
+    }
 }
 
-std::vector<Example2D> regressPlane(int numSamples, double noise) {
-    double radius = 6.0;
+// Splits [0, n) into one contiguous range per thread and runs fn(begin, end)
+// on each, the first range on the calling thread.
+template<typename F>
+static void parallelFor(size_t n, unsigned numThreads, F fn) {
+    // Below this many samples per thread, spawning threads costs more than it saves.
+    const size_t minChunk = 16384;
 
-    auto getLabel = [&](double x, double y) {
-        return linearScale(x + y, -10.0, 10.0, -1.0, 1.0);
-    };
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t numChunks = std::min<size_t>(numThreads, (n + minChunk - 1) / minChunk);
+    if (numChunks <= 1) {
+        fn(size_t(0), n);
+        return;
+    }
 
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
-    for (int i = 0; i < numSamples; i++) {
-        double x = randUniform(-radius, radius);
-        double y = randUniform(-radius, radius);
-        double noiseX = randUniform(-radius, radius) * noise;
-        double noiseY = randUniform(-radius, radius) * noise;
-        double label = getLabel(x + noiseX, y + noiseY);
-        points.push_back({x, y, label});
+    std::vector<std::thread> workers;
+    workers.reserve(numChunks - 1);
+    const size_t chunk = (n + numChunks - 1) / numChunks;
+    for (size_t c = 1; c < numChunks; ++c) {
+        size_t begin = std::min(n, c * chunk);
+        size_t end = std::min(n, begin + chunk);
+        workers.emplace_back(fn, begin, end);
+    }
+    fn(size_t(0), chunk);
+    for (auto& worker : workers) {
+        worker.join();
     }
-    return points;
 }
 
-std::vector<Example2D> regressGaussian(int numSamples, double noise) {
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
+void generateParallel(GeneratorKernel kernel, const GeneratorParams& params, ExampleColumns out, unsigned numThreads) {
+    // Every sample only depends on its index, so any partition of [0, n)
+    // produces output identical to a serial run.
+    parallelFor(params.numSamples, numThreads, [&](size_t begin, size_t end) {
+        ExampleColumns chunkOut{out.x + begin * out.stride, out.y + begin * out.stride,
+                                out.label + begin * out.stride, out.stride};
+        kernel(params, begin, end, chunkOut);
+    });
+}
 
-    static const std::vector<std::array<double, 3>> gaussians = {
-        {-4, 2.5, 1}, {0, 2.5, -1}, {4, 2.5, 1},
-        {-4, -2.5, -1}, {0, -2.5, 1}, {4, -2.5, -1}
-    };
+std::vector<Example2D> generate(GeneratorKernel kernel, int numSamples, double noise, uint64_t seed) {
+    std::vector<Example2D> points(std::max(0, numSamples));
+    if (points.empty()) {
+        return points;
+    }
+    // Write straight into the Example2D array through strided columns.
+    ExampleColumns out{&points.data()->x, &points.data()->y, &points.data()->label, 3};
+    static_assert(sizeof(Example2D) == 3 * sizeof(double), "Example2D must be three packed doubles");
+    generateParallel(kernel, {points.size(), noise, seed}, out);
+    return points;
+}
 
-    auto getLabel = [&](double x, double y) {
-        double maxAbsLabel = 0.0;
-        double finalLabel = 0.0;
-        for (const auto& g : gaussians) {
-            double cx = g[0], cy = g[1], sign = g[2];
-            double d = dist({x, y}, {cx, cy});
-            double newLabel = sign * linearScale(d, 0.0, 2.0, 1.0, 0.0, true);
-            if (std::abs(newLabel) > maxAbsLabel) {
-                maxAbsLabel = std::abs(newLabel);
-                finalLabel = newLabel;
+Dataset generateDataset(GeneratorKernel kernel, const GeneratorParams& params, bool classification,
+                        unsigned numThreads) {
+    DatasetColumns columns;
+    Dataset dataset = Dataset::allocate(params.numSamples, 2, classification, columns);
+    float* xs = columns.column(0);
+    float* ys = columns.column(1);
+
+    // Kernels produce doubles; each thread converts them through a small
+    // cache-resident buffer.
+    parallelFor(params.numSamples, numThreads, [&](size_t begin, size_t end) {
+        const size_t block = 4096;
+        std::vector<double> buffer(3 * block);
+        ExampleColumns out{buffer.data(), buffer.data() + block, buffer.data() + 2 * block};
+        for (size_t first = begin; first < end; first += block) {
+            size_t n = std::min(block, end - first);
+            kernel(params, first, first + n, out);
+            for (size_t i = 0; i < n; ++i) {
+                xs[first + i] = static_cast<float>(out.x[i]);
+                ys[first + i] = static_cast<float>(out.y[i]);
+            }
+            if (classification) {
+                for (size_t i = 0; i < n; ++i) {
+                    columns.classLabels[first + i] = out.label[i] > 0 ? 1 : -1;
+                }
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    columns.regressionLabels[first + i] = static_cast<float>(out.label[i]);
+                }
             }
         }
-        return finalLabel;
-    };
+    });
+    return dataset;
+}
+
+// ==============================================================================
+// DATASET
+// ==============================================================================
 
-    double radius = 6.0;
-    for (int i = 0; i < numSamples; i++) {
-        double x = randUniform(-radius, radius);
-        double y = randUniform(-radius, radius);
-        double noiseX = randUniform(-radius, radius) * noise;
-        double noiseY = randUniform(-radius, radius) * noise;
-        double label = getLabel(x + noiseX, y + noiseY);
-        points.push_back({x, y, label});
+namespace {
+
+// Owned storage behind Dataset::allocate.
+struct OwnedColumns {
+    std::vector<float> features;
+    std::vector<int8_t> classLabels;
+    std::vector<float> regressionLabels;
+};
+
+} // namespace
+
+Dataset Dataset::allocate(size_t n, size_t dims, bool classification, DatasetColumns& columns) {
+    auto storage = std::make_shared<OwnedColumns>();
+    storage->features.resize(n * dims);
+    columns = {};
+    columns.features = storage->features.data();
+    columns.stride = n;
+    const void* labels;
+    if (classification) {
+        storage->classLabels.resize(n);
+        labels = columns.classLabels = storage->classLabels.data();
+    } else {
+        storage->regressionLabels.resize(n);
+        labels = columns.regressionLabels = storage->regressionLabels.data();
     }
-    return points;
+    return view(n, dims, n, classification, columns.features, labels, std::move(storage));
 }
 
-std::vector<Example2D> classifySpiralData(int numSamples, double noise) {
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
+Dataset Dataset::view(size_t n, size_t dims, size_t stride, bool classification, const float* features,
+                      const void* labels, std::shared_ptr<const void> owner) {
+    Dataset dataset;
+    dataset.count = n;
+    dataset.dims = dims;
+    dataset.stride = stride;
+    dataset.classification = classification;
+    dataset.features = features;
+    dataset.labels = labels;
+    dataset.owner = std::move(owner);
+    return dataset;
+}
 
-    // Correctly split samples to handle odd numSamples.
-    const int n_pos = numSamples / 2;
-    const int n_neg = numSamples - n_pos;
-
-    auto genSpiral = [&](int num_points_in_spiral, double deltaT, double label) {
-        for (int i = 0; i < num_points_in_spiral; i++) {
-            double r = static_cast<double>(i) / num_points_in_spiral * 5.0;
-            double t = 1.75 * static_cast<double>(i) / num_points_in_spiral * 2.0 * M_PI + deltaT;
-            double x = r * std::sin(t) + randUniform(-1, 1) * noise;
-            double y = r * std::cos(t) + randUniform(-1, 1) * noise;
-            points.push_back({x, y, label});
+Dataset Dataset::fromExamples(const std::vector<Example2D>& examples, bool classification) {
+    DatasetColumns columns;
+    Dataset dataset = allocate(examples.size(), 2, classification, columns);
+    for (size_t i = 0; i < examples.size(); ++i) {
+        columns.column(0)[i] = static_cast<float>(examples[i].x);
+        columns.column(1)[i] = static_cast<float>(examples[i].y);
+        if (classification) {
+            columns.classLabels[i] = examples[i].label > 0 ? 1 : -1;
+        } else {
+            columns.regressionLabels[i] = static_cast<float>(examples[i].label);
         }
-    };
-
-    genSpiral(n_pos, 0, 1); // Positive examples.
-    genSpiral(n_neg, M_PI, -1); // Negative examples.
-    return points;
+    }
+    return dataset;
 }
 
-std::vector<Example2D> classifyCircleData(int numSamples, double noise) {
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
-    double radius = 5.0;
+std::pair<float, float> Dataset::range(size_t c) const {
+    if (count == 0) {
+        return {0.0f, 0.0f};
+    }
+    const float* values = column(c);
+    if (!rows) {
+        auto minMax = std::minmax_element(values, values + count);
+        return {*minMax.first, *minMax.second};
+    }
+    std::pair<float, float> result(values[rows[0]], values[rows[0]]);
+    for (size_t i = 1; i < count; ++i) {
+        result.first = std::min(result.first, values[rows[i]]);
+        result.second = std::max(result.second, values[rows[i]]);
+    }
+    return result;
+}
 
-    auto getCircleLabel = [&](const Point& p) {
-        return (dist(p, {0, 0}) < (radius * 0.5)) ? 1.0 : -1.0;
-    };
+std::vector<double> Dataset::means() const {
+    std::vector<double> result(dims, 0.0);
+    for (size_t c = 0; c < dims && count > 0; ++c) {
+        const float* values = column(c);
+        double sum = 0;
+        for (size_t i = 0; i < count; ++i) {
+            sum += values[row(i)];
+        }
+        result[c] = sum / count;
+    }
+    return result;
+}
 
-    // Correctly split samples to handle odd numSamples.
-    const int num_positive = numSamples / 2;
-    const int num_negative = numSamples - num_positive;
+Dataset Dataset::slice(size_t begin, size_t n) const {
+    begin = std::min(begin, count);
+    n = std::min(n, count - begin);
+    if (rows) {
+        // Indexed views slice the index and keep the columns.
+        Dataset result = *this;
+        result.count = n;
+        result.rows = rows + begin;
+        return result;
+    }
+    const void* sliceLabels = classification ? static_cast<const void*>(classLabels() + begin)
+                                             : static_cast<const void*>(regressionLabels() + begin);
+    return view(n, dims, stride, classification, features + begin, sliceLabels, owner);
+}
 
-    // Generate positive points inside the circle.
-    for (int i = 0; i < num_positive; i++) {
-        double r = randUniform(0, radius * 0.5);
-        double angle = randUniform(0, 2 * M_PI);
-        double x = r * std::sin(angle);
-        double y = r * std::cos(angle);
-        double noiseX = randUniform(-radius, radius) * noise;
-        double noiseY = randUniform(-radius, radius) * noise;
-        double label = getCircleLabel({x + noiseX, y + noiseY});
-        points.push_back({x, y, label});
+// Gathers examples `examples[0..n)` into a new owned dataset.
+static Dataset gather(const Dataset& source, const uint32_t* examples, size_t n) {
+    DatasetColumns columns;
+    Dataset dataset = Dataset::allocate(n, source.numFeatures(), source.isClassification(), columns);
+    for (size_t c = 0; c < source.numFeatures(); ++c) {
+        const float* from = source.column(c);
+        float* to = columns.column(c);
+        for (size_t i = 0; i < n; ++i) {
+            to[i] = from[source.row(examples[i])];
+        }
+    }
+    if (source.isClassification()) {
+        for (size_t i = 0; i < n; ++i) columns.classLabels[i] = source.classLabels()[source.row(examples[i])];
+    } else {
+        for (size_t i = 0; i < n; ++i) columns.regressionLabels[i] = source.regressionLabels()[source.row(examples[i])];
     }
+    return dataset;
+}
 
-    // Generate negative points outside the circle.
-    for (int i = 0; i < num_negative; i++) {
-        double r = randUniform(radius * 0.7, radius);
-        double angle = randUniform(0, 2 * M_PI);
-        double x = r * std::sin(angle);
-        double y = r * std::cos(angle);
-        double noiseX = randUniform(-radius, radius) * noise;
-        double noiseY = randUniform(-radius, radius) * noise;
-        double label = getCircleLabel({x + noiseX, y + noiseY});
-        points.push_back({x, y, label});
+// The examples [0, n) in the random order of permuted(seed).
+static std::vector<uint32_t> shuffledExamples(size_t n, uint64_t seed) {
+    std::vector<uint32_t> examples(n);
+    for (size_t i = 0; i < n; ++i) {
+        examples[i] = static_cast<uint32_t>(i);
     }
-    return points;
+    shuffleRange(examples.data(), n, rng::Stream(seed, rng::SHUFFLE), 0);
+    return examples;
 }
 
-std::vector<Example2D> classifyXORData(int numSamples, double noise) {
-    auto getXORLabel = [](const Point& p) {
-        return p.x * p.y >= 0 ? 1.0 : -1.0;
-    };
+Dataset Dataset::permuted(uint64_t seed) const {
+    std::vector<uint32_t> examples = shuffledExamples(count, seed);
+    return gather(*this, examples.data(), count);
+}
 
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
-    for (int i = 0; i < numSamples; i++) {
-        double x = randUniform(-5, 5);
-        double padding = 0.3;
-        x += x > 0 ? padding : -padding;
-        double y = randUniform(-5, 5);
-        y += y > 0 ? padding : -padding;
-        double noiseX = randUniform(-5, 5) * noise;
-        double noiseY = randUniform(-5, 5) * noise;
-        double label = getXORLabel({x + noiseX, y + noiseY});
-        points.push_back({x, y, label});
+Dataset Dataset::shuffled(uint64_t seed) const {
+    auto index = std::make_shared<std::vector<uint32_t>>(shuffledExamples(count, seed));
+    for (uint32_t& example : *index) {
+        example = static_cast<uint32_t>(row(example));
     }
-    return points;
+    Dataset result = *this;
+    result.rows = index->data();
+    result.rowsOwner = std::move(index);
+    return result;
 }
 
-std::vector<Example2D> classifyStarData(int numSamples, double noise) {
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
-    double radius = 5.0;
+Dataset Dataset::subsample(size_t n) const {
+    if (n >= count) {
+        return *this;
+    }
+    std::vector<uint32_t> rows(n);
+    for (size_t i = 0; i < n; ++i) {
+        rows[i] = static_cast<uint32_t>(i * count / n);
+    }
+    return gather(*this, rows.data(), n);
+}
 
-    auto getStarLabel = [&](const Point& p) {
-        double angle = atan2(p.y, p.x) + M_PI;
-        double r = sqrt(p.x * p.x + p.y * p.y);
+// ==============================================================================
+// BATCH KERNELS
+// ==============================================================================
+//
+// Each kernel fills samples [begin, end) of a dataset with params.numSamples
+// examples into rows [0, end - begin) of `out`. Sample i draws only from
+// counter i of the DATA stream, and the
+// loop bodies are branch-free (selects instead of ifs) so they stay friendly
+// to auto-vectorization.
+
+void twoGaussKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    const rng::Stream rand(params.seed, rng::DATA);
+    const double variance = linearScale(params.noise, 0.0, 0.5, 0.5, 4.0);
+    // First half: Gaussian with positive examples, second half: negative.
+    const size_t numPositive = params.numSamples / 2;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        double center = i < numPositive ? 2.0 : -2.0;
+        out.x[row] = rand.normal(center, variance, i, 0);
+        out.y[row] = rand.normal(center, variance, i, 2);
+        out.label[row] = i < numPositive ? 1.0 : -1.0;
+    }
+}
 
-        int num_points = 5;
-        double a = M_PI / num_points;
-        double t = fmod(angle, 2 * a);
-        double r_star = radius / 2.0 * (cos(a) / cos(t - a));
+void regressPlaneKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    const rng::Stream rand(params.seed, rng::DATA);
+    const double radius = 6.0;
+    const double noise = params.noise;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        double x = rand.uniform(-radius, radius, i, 0);
+        double y = rand.uniform(-radius, radius, i, 1);
+        double noiseX = rand.uniform(-radius, radius, i, 2) * noise;
+        double noiseY = rand.uniform(-radius, radius, i, 3) * noise;
+        out.x[row] = x;
+        out.y[row] = y;
+        out.label[row] = linearScale(x + noiseX + y + noiseY, -10.0, 10.0, -1.0, 1.0);
+    }
+}
 
-        return (r < r_star) ? 1.0 : -1.0;
+void regressGaussianKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    static const double gaussians[6][3] = {
+        {-4, 2.5, 1}, {0, 2.5, -1}, {4, 2.5, 1},
+        {-4, -2.5, -1}, {0, -2.5, 1}, {4, -2.5, -1}
     };
+    const rng::Stream rand(params.seed, rng::DATA);
+    const double radius = 6.0;
+    const double noise = params.noise;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        double x = rand.uniform(-radius, radius, i, 0);
+        double y = rand.uniform(-radius, radius, i, 1);
+        double px = x + rand.uniform(-radius, radius, i, 2) * noise;
+        double py = y + rand.uniform(-radius, radius, i, 3) * noise;
+        double maxAbsLabel = 0.0;
+        double label = 0.0;
+        for (const auto& g : gaussians) {
+            double d = dist({px, py}, {g[0], g[1]});
+            double newLabel = g[2] * linearScale(d, 0.0, 2.0, 1.0, 0.0, true);
+            bool larger = std::abs(newLabel) > maxAbsLabel;
+            maxAbsLabel = larger ? std::abs(newLabel) : maxAbsLabel;
+            label = larger ? newLabel : label;
+        }
+        out.x[row] = x;
+        out.y[row] = y;
+        out.label[row] = label;
+    }
+}
+
+void spiralKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    const rng::Stream rand(params.seed, rng::DATA);
+    // Correctly split samples to handle odd numSamples.
+    const size_t numPositive = params.numSamples / 2;
+    const size_t numNegative = params.numSamples - numPositive;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        bool positive = i < numPositive;
+        double local = static_cast<double>(positive ? i : i - numPositive);
+        double count = static_cast<double>(positive ? numPositive : numNegative);
+        double deltaT = positive ? 0.0 : M_PI;
+        double r = local / count * 5.0;
+        double t = 1.75 * local / count * 2.0 * M_PI + deltaT;
+        out.x[row] = r * std::sin(t) + rand.uniform(-1, 1, i, 0) * params.noise;
+        out.y[row] = r * std::cos(t) + rand.uniform(-1, 1, i, 1) * params.noise;
+        out.label[row] = positive ? 1.0 : -1.0;
+    }
+}
 
-    for (int i = 0; i < numSamples; i++) {
-        double r = randUniform(0, radius);
-        double angle = randUniform(0, 2 * M_PI);
+void circleKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    const rng::Stream rand(params.seed, rng::DATA);
+    const double radius = 5.0;
+    // Positive points inside the circle first, then negative points outside.
+    const size_t numPositive = params.numSamples / 2;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        bool inside = i < numPositive;
+        double r = inside ? rand.uniform(0, radius * 0.5, i, 0) : rand.uniform(radius * 0.7, radius, i, 0);
+        double angle = rand.uniform(0, 2 * M_PI, i, 1);
         double x = r * std::sin(angle);
         double y = r * std::cos(angle);
-        double noiseX = randUniform(-radius, radius) * noise;
-        double noiseY = randUniform(-radius, radius) * noise;
-        double label = getStarLabel({x + noiseX, y + noiseY});
-        points.push_back({x, y, label});
+        double noiseX = rand.uniform(-radius, radius, i, 2) * params.noise;
+        double noiseY = rand.uniform(-radius, radius, i, 3) * params.noise;
+        out.x[row] = x;
+        out.y[row] = y;
+        out.label[row] = dist({x + noiseX, y + noiseY}, {0, 0}) < radius * 0.5 ? 1.0 : -1.0;
+    }
+}
+
+void xorKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    const rng::Stream rand(params.seed, rng::DATA);
+    const double padding = 0.3;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        double x = rand.uniform(-5, 5, i, 0);
+        x += x > 0 ? padding : -padding;
+        double y = rand.uniform(-5, 5, i, 1);
+        y += y > 0 ? padding : -padding;
+        double noiseX = rand.uniform(-5, 5, i, 2) * params.noise;
+        double noiseY = rand.uniform(-5, 5, i, 3) * params.noise;
+        out.x[row] = x;
+        out.y[row] = y;
+        out.label[row] = (x + noiseX) * (y + noiseY) >= 0 ? 1.0 : -1.0;
     }
-    return points;
 }
 
-std::vector<Example2D> classifySineData(int numSamples, double noise) {
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
-    double radius = 5.0;
+void starKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    const rng::Stream rand(params.seed, rng::DATA);
+    const double radius = 5.0;
+    const int num_points = 5;
+    const double a = M_PI / num_points;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        double r = rand.uniform(0, radius, i, 0);
+        double angle = rand.uniform(0, 2 * M_PI, i, 1);
+        double x = r * std::sin(angle);
+        double y = r * std::cos(angle);
+        double px = x + rand.uniform(-radius, radius, i, 2) * params.noise;
+        double py = y + rand.uniform(-radius, radius, i, 3) * params.noise;
 
-    auto getSineLabel = [&](const Point& p) {
-        return p.y > sin(p.x * 2.0) ? 1.0 : -1.0;
-    };
+        double pAngle = std::atan2(py, px) + M_PI;
+        double pr = std::sqrt(px * px + py * py);
+        double t = std::fmod(pAngle, 2 * a);
+        double r_star = radius / 2.0 * (std::cos(a) / std::cos(t - a));
 
-    for (int i = 0; i < numSamples; i++) {
-        double x = randUniform(-radius, radius);
-        double y = randUniform(-radius, radius);
-        double noiseX = randUniform(-radius, radius) * noise;
-        double noiseY = randUniform(-radius, radius) * noise;
-        double label = getSineLabel({x + noiseX, y + noiseY});
-        points.push_back({x, y, label});
+        out.x[row] = x;
+        out.y[row] = y;
+        out.label[row] = pr < r_star ? 1.0 : -1.0;
     }
-    return points;
 }
 
-std::vector<Example2D> classifyCheckerboardData(int numSamples, double noise) {
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
-    double radius = 5.0;
-
-    auto getCheckerboardLabel = [&](const Point& p) {
-        return (static_cast<int>(floor(p.x / 2.0)) + static_cast<int>(floor(p.y / 2.0))) % 2 == 0 ? 1.0 : -1.0;
-    };
+void sineKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    const rng::Stream rand(params.seed, rng::DATA);
+    const double radius = 5.0;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        double x = rand.uniform(-radius, radius, i, 0);
+        double y = rand.uniform(-radius, radius, i, 1);
+        double noiseX = rand.uniform(-radius, radius, i, 2) * params.noise;
+        double noiseY = rand.uniform(-radius, radius, i, 3) * params.noise;
+        out.x[row] = x;
+        out.y[row] = y;
+        out.label[row] = y + noiseY > std::sin((x + noiseX) * 2.0) ? 1.0 : -1.0;
+    }
+}
 
-    for (int i = 0; i < numSamples; i++) {
-        double x = randUniform(-radius, radius);
-        double y = randUniform(-radius, radius);
-        double noiseX = randUniform(-radius, radius) * noise;
-        double noiseY = randUniform(-radius, radius) * noise;
-        double label = getCheckerboardLabel({x + noiseX, y + noiseY});
-        points.push_back({x, y, label});
+void checkerboardKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    const rng::Stream rand(params.seed, rng::DATA);
+    const double radius = 5.0;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        double x = rand.uniform(-radius, radius, i, 0);
+        double y = rand.uniform(-radius, radius, i, 1);
+        double noiseX = rand.uniform(-radius, radius, i, 2) * params.noise;
+        double noiseY = rand.uniform(-radius, radius, i, 3) * params.noise;
+        int cells = static_cast<int>(std::floor((x + noiseX) / 2.0)) + static_cast<int>(std::floor((y + noiseY) / 2.0));
+        out.x[row] = x;
+        out.y[row] = y;
+        out.label[row] = cells % 2 == 0 ? 1.0 : -1.0;
     }
-    return points;
 }
 
 // Idea: Two interleaving half-circles (classic for testing classifiers).
-std::vector<Example2D> classifyMoonsData(int numSamples, double noise) {
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
-    double radius = 4.0; // Reduced radius to fit within the domain
-    double crescent_width = 2.0;
-
-    auto getMoonLabel = [&](const Point& p) {
+void moonsKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    const rng::Stream rand(params.seed, rng::DATA);
+    const double radius = 4.0; // Reduced radius to fit within the domain
+    const double crescent_width = 2.0;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        double x = rand.uniform(-6, 6, i, 0);
+        double y = rand.uniform(-6, 6, i, 1);
+        Point p{x + rand.uniform(-1, 1, i, 2) * params.noise * 5.0,
+                y + rand.uniform(-1, 1, i, 3) * params.noise * 5.0};
         double dist_to_center = dist(p, {0, 0});
         double dist_to_offset = dist(p, {-crescent_width / 2, 0});
-        return (dist_to_center < radius && dist_to_offset > radius) ? 1.0 : -1.0;
-    };
+        out.x[row] = x;
+        out.y[row] = y;
+        out.label[row] = (dist_to_center < radius && dist_to_offset > radius) ? 1.0 : -1.0;
+    }
+}
 
-    for (int i = 0; i < numSamples; i++) {
-        double x = randUniform(-6, 6);
-        double y = randUniform(-6, 6);
-        double noiseX = randUniform(-1, 1) * noise * 5.0;
-        double noiseY = randUniform(-1, 1) * noise * 5.0;
-        double label = getMoonLabel({x + noiseX, y + noiseY});
-        points.push_back({x, y, label});
+void heartKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out) {
+    const rng::Stream rand(params.seed, rng::DATA);
+    const double radius = 6.0;
+    for (size_t i = begin; i < end; i++) {
+        const size_t row = (i - begin) * out.stride;
+        double x = rand.uniform(-radius, radius, i, 0);
+        double y = rand.uniform(-radius, radius, i, 1);
+        double noiseX = rand.uniform(-radius, radius, i, 2) * params.noise;
+        double noiseY = rand.uniform(-radius, radius, i, 3) * params.noise;
+        // Flip the y-axis and scale to the unit heart.
+        double hx = (x + noiseX) / (radius / 2.0);
+        double hy = -(y + noiseY) / (radius / 2.0);
+        double x2 = hx * hx;
+        double y2 = hy * hy;
+        double s = x2 + y2 - 1;
+        out.x[row] = x;
+        out.y[row] = y;
+        // Equation for a heart shape
+        out.label[row] = s * s * s - x2 * y2 * hy < 0 ? 1.0 : -1.0;
     }
+}
 
-    return points;
+// ==============================================================================
+// GENERATORS
+// ==============================================================================
+
+std::vector<Example2D> classifyTwoGaussData(int numSamples, double noise, uint64_t seed) {
+    return generate(twoGaussKernel, numSamples, noise, seed);
 }
 
-std::vector<Example2D> classifyHeartData(int numSamples, double noise) {
-    std::vector<Example2D> points;
-    points.reserve(numSamples);
-    double radius = 6.0;
+std::vector<Example2D> regressPlane(int numSamples, double noise, uint64_t seed) {
+    return generate(regressPlaneKernel, numSamples, noise, seed);
+}
 
-    auto getHeartLabel = [&](Point p) {
-        p.y *= -1; // Flip the y-axis
-        double x = p.x / (radius / 2.0);
-        double y = p.y / (radius / 2.0);
-        double x2 = x * x;
-        double y2 = y * y;
-        // Equation for a heart shape
-        return (x2 + y2 - 1) * (x2 + y2 - 1) * (x2 + y2 - 1) - x2 * y2 * y < 0 ? 1.0 : -1.0;
-    };
+std::vector<Example2D> regressGaussian(int numSamples, double noise, uint64_t seed) {
+    return generate(regressGaussianKernel, numSamples, noise, seed);
+}
+
+std::vector<Example2D> classifySpiralData(int numSamples, double noise, uint64_t seed) {
+    return generate(spiralKernel, numSamples, noise, seed);
+}
+
+std::vector<Example2D> classifyCircleData(int numSamples, double noise, uint64_t seed) {
+    return generate(circleKernel, numSamples, noise, seed);
+}
+
+std::vector<Example2D> classifyXORData(int numSamples, double noise, uint64_t seed) {
+    return generate(xorKernel, numSamples, noise, seed);
+}
+
+std::vector<Example2D> classifyStarData(int numSamples, double noise, uint64_t seed) {
+    return generate(starKernel, numSamples, noise, seed);
+}
 
-    for (int i = 0; i < numSamples; i++) {
-        double x = randUniform(-radius, radius);
-        double y = randUniform(-radius, radius);
-        double noiseX = randUniform(-radius, radius) * noise;
-        double noiseY = randUniform(-radius, radius) * noise;
-        double label = getHeartLabel({x + noiseX, y + noiseY});
-        points.push_back({x, y, label});
+std::vector<Example2D> classifySineData(int numSamples, double noise, uint64_t seed) {
+    return generate(sineKernel, numSamples, noise, seed);
+}
+
+std::vector<Example2D> classifyCheckerboardData(int numSamples, double noise, uint64_t seed) {
+    return generate(checkerboardKernel, numSamples, noise, seed);
+}
+
+std::vector<Example2D> classifyMoonsData(int numSamples, double noise, uint64_t seed) {
+    return generate(moonsKernel, numSamples, noise, seed);
+}
+
+std::vector<Example2D> classifyHeartData(int numSamples, double noise, uint64_t seed) {
+    return generate(heartKernel, numSamples, noise, seed);
+}
+
+std::vector<Example2D> FixedDataGenerator::operator()(int numSamples, double /*noise*/, uint64_t /*seed*/) const {
+    Dataset rows = dataset.subsample(numSamples > 0 ? static_cast<size_t>(numSamples) : dataset.size());
+    std::vector<Example2D> points(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        points[i] = rows.example(i);
     }
     return points;
 }
 
+Dataset makeDataset(const DataGenerator& generator, int numSamples, double noise, uint64_t seed, bool classification,
+                    unsigned numThreads) {
+    size_t n = static_cast<size_t>(std::max(0, numSamples));
+    if (GeneratorKernel kernel = kernelFor(generator)) {
+        return generateDataset(kernel, {n, noise, seed}, classification, numThreads);
+    }
+    if (const auto* fixed = generator.target<FixedDataGenerator>()) {
+        return fixed->dataset.subsample(n);
+    }
+    return Dataset::fromExamples(generator(numSamples, noise, seed), classification);
+}
+
+GeneratorKernel kernelFor(const DataGenerator& generator) {
+    using GeneratorFn = std::vector<Example2D> (*)(int, double, uint64_t);
+    static const std::pair<GeneratorFn, GeneratorKernel> table[] = {
+        {classifyTwoGaussData, twoGaussKernel},
+        {regressPlane, regressPlaneKernel},
+        {regressGaussian, regressGaussianKernel},
+        {classifySpiralData, spiralKernel},
+        {classifyCircleData, circleKernel},
+        {classifyXORData, xorKernel},
+        {classifyStarData, starKernel},
+        {classifySineData, sineKernel},
+        {classifyCheckerboardData, checkerboardKernel},
+        {classifyMoonsData, moonsKernel},
+        {classifyHeartData, heartKernel},
+    };
+    const GeneratorFn* fn = generator.target<GeneratorFn>();
+    if (!fn) {
+        return nullptr;
+    }
+    for (const auto& entry : table) {
+        if (entry.first == *fn) {
+            return entry.second;
+        }
+    }
+    return nullptr;
+}
+
 } // namespace playground
@@ -2,6 +2,10 @@
 
 #include <vector>
 #include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
 
 namespace playground {
 
@@ -23,26 +27,255 @@ struct Point {
 };
 
 /**
- * Shuffles the vector using the Fisher-Yates algorithm provided by the standard library.
+ * Writable columns of a freshly allocated Dataset. Feature column c starts
+ * at features + c * stride. Exactly one of the label columns is non-null.
  */
-void shuffle(std::vector<Example2D>& array);
+struct DatasetColumns {
+    float* features = nullptr;
+    size_t stride = 0;
+    int8_t* classLabels = nullptr;
+    float* regressionLabels = nullptr;
+
+    float* column(size_t c) const { return features + c * stride; }
+};
+
+/**
+ * An immutable N-dimensional dataset in struct-of-arrays layout: one float32
+ * column per feature plus labels packed as int8 (-1/+1) for classification or
+ * float32 for regression. A 2D dataset takes 9-12 bytes per example instead
+ * of 24 for Example2D.
+ *
+ * A Dataset is a cheap, shareable view: copies and slices point at the same
+ * columns, which are kept alive by a shared owner (owned storage or a mapped
+ * file). A view may also visit the rows through an index (see shuffled());
+ * example i is then stored at row(i) of the columns.
+ */
+class Dataset {
+public:
+    Dataset() = default;
+
+    /**
+     * Allocates owned, uninitialized columns for n examples with `dims`
+     * features and returns them through `columns` so they can be filled
+     * before the Dataset is shared.
+     */
+    static Dataset allocate(size_t n, size_t dims, bool classification, DatasetColumns& columns);
+
+    /**
+     * Wraps existing columns: feature c of row i is features[c * stride + i].
+     * `labels` points at int8 labels for classification and float32 labels
+     * otherwise; `owner` keeps the memory alive.
+     */
+    static Dataset view(size_t n, size_t dims, size_t stride, bool classification, const float* features,
+                        const void* labels, std::shared_ptr<const void> owner);
+
+    /**
+     * Packs Example2D data (adapter for DataGenerator output).
+     */
+    static Dataset fromExamples(const std::vector<Example2D>& examples, bool classification);
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t numFeatures() const { return dims; }
+    bool isClassification() const { return classification; }
+
+    // The columns in storage order: example i is at index row(i).
+    const float* column(size_t c) const { return features + c * stride; }
+    const float* x() const { return column(0); }
+    const float* y() const { return column(1); }
+    const int8_t* classLabels() const { return static_cast<const int8_t*>(labels); }
+    const float* regressionLabels() const { return static_cast<const float*>(labels); }
+
+    // Where example i is stored in the columns.
+    size_t row(size_t i) const { return rows ? rows[i] : i; }
+
+    double label(size_t i) const {
+        return classification ? classLabels()[row(i)] : regressionLabels()[row(i)];
+    }
+
+    /**
+     * Writes the numFeatures() values of example i to `out`.
+     */
+    void point(size_t i, double* out) const {
+        const float* values = features + row(i);
+        for (size_t c = 0; c < dims; ++c) {
+            out[c] = values[c * stride];
+        }
+    }
+
+    /**
+     * Returns example i projected onto the feature columns (axisX, axisY). A
+     * missing axis reads as 0.
+     */
+    Example2D example(size_t i, size_t axisX = 0, size_t axisY = 1) const {
+        double px = axisX < dims ? column(axisX)[row(i)] : 0.0;
+        double py = axisY < dims ? column(axisY)[row(i)] : 0.0;
+        return {px, py, label(i)};
+    }
+
+    /**
+     * Returns the (min, max) of feature column c.
+     */
+    std::pair<float, float> range(size_t c) const;
+
+    /**
+     * Returns the mean of every feature column.
+     */
+    std::vector<double> means() const;
+
+    /**
+     * Returns a view of examples [begin, begin + n) sharing these columns.
+     */
+    Dataset slice(size_t begin, size_t n) const;
+
+    /**
+     * Returns an owned copy with the rows in a random order that only
+     * depends on the seed.
+     */
+    Dataset permuted(uint64_t seed) const;
+
+    /**
+     * Returns a view of the examples in the order permuted() gives them,
+     * through a row index instead of a copy of the columns.
+     */
+    Dataset shuffled(uint64_t seed) const;
+
+    /**
+     * Returns an owned copy holding every (size() / n)-th row, or this
+     * dataset if n >= size().
+     */
+    Dataset subsample(size_t n) const;
+
+private:
+    size_t count = 0;
+    size_t dims = 0;
+    size_t stride = 0;
+    bool classification = true;
+    const float* features = nullptr;
+    const void* labels = nullptr;
+    std::shared_ptr<const void> owner;
+    // Row index of an indexed view, kept alive by rowsOwner; null otherwise.
+    const uint32_t* rows = nullptr;
+    std::shared_ptr<const void> rowsOwner;
+};
+
+/**
+ * Shuffles the vector using the Fisher-Yates algorithm. The result only
+ * depends on the seed.
+ */
+void shuffle(std::vector<Example2D>& array, uint64_t seed = 0);
+
+/**
+ * Fills `order` with a random permutation of [0, n), reusing its storage.
+ * With blockSize > 1 the shuffle is blocked: runs of blockSize consecutive
+ * indices are visited in random order and shuffled internally, so each run
+ * touches a small contiguous window of the dataset. A trailing partial block
+ * always stays last. Every (seed, epoch) pair yields its own permutation.
+ */
+void permutation(std::vector<uint32_t>& order, size_t n, size_t blockSize = 0, uint64_t seed = 0, uint64_t epoch = 0);
+
+/**
+ * Struct-of-arrays output buffers for the batch generator kernels. Row r is
+ * stored at x[r * stride], y[r * stride] and label[r * stride].
+ */
+struct ExampleColumns {
+    double* x;
+    double* y;
+    double* label;
+    size_t stride = 1;
+};
+
+/**
+ * Parameters shared by every sample of one generated dataset.
+ */
+struct GeneratorParams {
+    size_t numSamples;
+    double noise;
+    uint64_t seed;
+};
+
+/**
+ * A batch kernel fills samples [begin, end) of a dataset described by
+ * `params`, writing sample i to row i - begin of `out`. Each sample only
+ * depends on its own index, so disjoint ranges can be filled concurrently.
+ */
+using GeneratorKernel = void (*)(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+
+/**
+ * Runs `kernel` over all params.numSamples samples, split across threads.
+ * numThreads = 0 uses the hardware concurrency. The output does not depend on
+ * the number of threads.
+ */
+void generateParallel(GeneratorKernel kernel, const GeneratorParams& params, ExampleColumns out, unsigned numThreads = 0);
+
+/**
+ * Runs `kernel` in parallel and returns the samples as Example2D.
+ */
+std::vector<Example2D> generate(GeneratorKernel kernel, int numSamples, double noise, uint64_t seed);
 
 /**
- * A function that generates data.
+ * Runs `kernel` in parallel and packs the samples straight into a Dataset,
+ * without an intermediate Example2D array. numThreads is as for
+ * generateParallel.
  */
-using DataGenerator = std::function<std::vector<Example2D>(int numSamples, double noise)>;
+Dataset generateDataset(GeneratorKernel kernel, const GeneratorParams& params, bool classification,
+                        unsigned numThreads = 0);
+
+// Batch kernels behind the data generation functions
+void twoGaussKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+void regressPlaneKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+void regressGaussianKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+void spiralKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+void circleKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+void xorKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+void starKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+void sineKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+void checkerboardKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+void moonsKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+void heartKernel(const GeneratorParams& params, size_t begin, size_t end, ExampleColumns out);
+
+/**
+ * A function that generates data. The same seed always yields the same data.
+ */
+using DataGenerator = std::function<std::vector<Example2D>(int numSamples, double noise, uint64_t seed)>;
 
 // Data generation functions
-std::vector<Example2D> classifyTwoGaussData(int numSamples, double noise);
-std::vector<Example2D> regressPlane(int numSamples, double noise);
-std::vector<Example2D> regressGaussian(int numSamples, double noise);
-std::vector<Example2D> classifySpiralData(int numSamples, double noise);
-std::vector<Example2D> classifyCircleData(int numSamples, double noise);
-std::vector<Example2D> classifyXORData(int numSamples, double noise);
-std::vector<Example2D> classifyStarData(int numSamples, double noise);
-std::vector<Example2D> classifySineData(int numSamples, double noise);
-std::vector<Example2D> classifyCheckerboardData(int numSamples, double noise);
-std::vector<Example2D> classifyMoonsData(int numSamples, double noise);
-std::vector<Example2D> classifyHeartData(int numSamples, double noise);
+std::vector<Example2D> classifyTwoGaussData(int numSamples, double noise, uint64_t seed = 0);
+std::vector<Example2D> regressPlane(int numSamples, double noise, uint64_t seed = 0);
+std::vector<Example2D> regressGaussian(int numSamples, double noise, uint64_t seed = 0);
+std::vector<Example2D> classifySpiralData(int numSamples, double noise, uint64_t seed = 0);
+std::vector<Example2D> classifyCircleData(int numSamples, double noise, uint64_t seed = 0);
+std::vector<Example2D> classifyXORData(int numSamples, double noise, uint64_t seed = 0);
+std::vector<Example2D> classifyStarData(int numSamples, double noise, uint64_t seed = 0);
+std::vector<Example2D> classifySineData(int numSamples, double noise, uint64_t seed = 0);
+std::vector<Example2D> classifyCheckerboardData(int numSamples, double noise, uint64_t seed = 0);
+std::vector<Example2D> classifyMoonsData(int numSamples, double noise, uint64_t seed = 0);
+std::vector<Example2D> classifyHeartData(int numSamples, double noise, uint64_t seed = 0);
+
+/**
+ * Returns the batch kernel behind one of the generation functions above, or
+ * nullptr if `generator` wraps anything else.
+ */
+GeneratorKernel kernelFor(const DataGenerator& generator);
+
+/**
+ * A DataGenerator over a fixed, already materialized dataset (e.g. a mapped
+ * file). Asking for fewer samples than it holds returns an evenly strided
+ * subsample; noise and seed are ignored.
+ */
+struct FixedDataGenerator {
+    Dataset dataset;
+
+    std::vector<Example2D> operator()(int numSamples, double noise, uint64_t seed) const;
+};
+
+/**
+ * Produces a Dataset from any DataGenerator: built-in generators run their
+ * kernel directly into the columns, fixed datasets are shared without a copy
+ * where possible, and anything else goes through Example2D. Kernels run on
+ * `numThreads` threads (0 uses the hardware concurrency).
+ */
+Dataset makeDataset(const DataGenerator& generator, int numSamples, double noise, uint64_t seed, bool classification,
+                    unsigned numThreads = 0);
 
 } // namespace playground
@@ -0,0 +1,245 @@
+#include "dataset_file.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace playground {
+
+static_assert(sizeof(DatasetFileHeader) == 64, "DatasetFileHeader must stay 64 bytes");
+
+static const size_t COLUMN_ALIGNMENT = 64;
+
+static size_t alignUp(size_t value) {
+    return (value + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+}
+
+size_t datasetColumnOffset(uint64_t numRows, size_t c) {
+    // Every feature column is float32; the label column follows the last one.
+    return sizeof(DatasetFileHeader) + c * alignUp(numRows * sizeof(float));
+}
+
+static std::runtime_error fileError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+// ==============================================================================
+// MAPPED DATASET
+// ==============================================================================
+
+MappedDataset::MappedDataset(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw fileError("Cannot open dataset", path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw fileError("Cannot stat dataset", path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length < sizeof(DatasetFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Dataset file '" + path + "' is too small");
+    }
+    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        throw fileError("Cannot map dataset", path);
+    }
+    base = static_cast<const uint8_t*>(mapped);
+    header = reinterpret_cast<const DatasetFileHeader*>(base);
+
+    std::string error;
+    if (std::memcmp(header->magic, "NNPD", 4) != 0) {
+        error = "bad magic";
+    } else if (header->version != DATASET_FILE_VERSION) {
+        error = "unsupported version " + std::to_string(header->version);
+    } else if (header->numFeatures == 0) {
+        error = "no feature columns";
+    } else if (header->labelType != LABELS_FLOAT32 && header->labelType != LABELS_INT8) {
+        error = "unknown label type";
+    } else if (header->numRows > length / sizeof(float) ||
+               (header->numRows > 0 &&
+                header->numFeatures > length / alignUp(header->numRows * sizeof(float)))) {
+        // Checked before the size arithmetic below, which could wrap.
+        error = "truncated";
+    } else {
+        size_t labelBytes = header->labelType == LABELS_INT8 ? sizeof(int8_t) : sizeof(float);
+        size_t expected = datasetColumnOffset(header->numRows, header->numFeatures) + header->numRows * labelBytes;
+        if (length < expected) {
+            error = "truncated";
+        }
+    }
+    if (!error.empty()) {
+        ::munmap(const_cast<uint8_t*>(base), length);
+        throw std::runtime_error("Invalid dataset file '" + path + "': " + error);
+    }
+    // The training loop streams the columns front to back.
+    ::madvise(const_cast<uint8_t*>(base), length, MADV_SEQUENTIAL);
+}
+
+MappedDataset::~MappedDataset() {
+    if (base) {
+        ::munmap(const_cast<uint8_t*>(base), length);
+    }
+}
+
+const float* MappedDataset::column(size_t f) const {
+    return reinterpret_cast<const float*>(base + datasetColumnOffset(header->numRows, f));
+}
+
+const int8_t* MappedDataset::classLabels() const {
+    return reinterpret_cast<const int8_t*>(base + datasetColumnOffset(header->numRows, header->numFeatures));
+}
+
+const float* MappedDataset::regressionLabels() const {
+    return reinterpret_cast<const float*>(base + datasetColumnOffset(header->numRows, header->numFeatures));
+}
+
+double MappedDataset::label(size_t i) const {
+    return isClassification() ? classLabels()[i] : regressionLabels()[i];
+}
+
+// ==============================================================================
+// WRITING AND CONVERSION
+// ==============================================================================
+
+void writeDatasetFile(const std::string& path, const float* const* columns, size_t numFeatures,
+                      const double* labels, size_t numRows, bool classification) {
+    DatasetFileHeader header = {};
+    std::memcpy(header.magic, "NNPD", 4);
+    header.version = DATASET_FILE_VERSION;
+    header.numRows = numRows;
+    header.numFeatures = static_cast<uint32_t>(numFeatures);
+    header.labelType = classification ? LABELS_INT8 : LABELS_FLOAT32;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw fileError("Cannot create dataset", path);
+    }
+    auto padTo = [&](size_t offset) {
+        static const char zeros[COLUMN_ALIGNMENT] = {};
+        size_t pos = static_cast<size_t>(out.tellp());
+        out.write(zeros, static_cast<std::streamsize>(offset - pos));
+    };
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t c = 0; c < numFeatures; ++c) {
+        out.write(reinterpret_cast<const char*>(columns[c]), static_cast<std::streamsize>(numRows * sizeof(float)));
+        padTo(datasetColumnOffset(numRows, c + 1));
+    }
+    if (classification) {
+        std::vector<int8_t> packed(numRows);
+        for (size_t i = 0; i < numRows; ++i) {
+            packed[i] = labels[i] > 0 ? 1 : -1;
+        }
+        out.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(numRows));
+    } else {
+        std::vector<float> packed(labels, labels + numRows);
+        out.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(numRows * sizeof(float)));
+    }
+    if (!out) {
+        throw fileError("Cannot write dataset", path);
+    }
+}
+
+// Parses a comma (or semicolon) separated row of numbers into `values`.
+// Returns false if the line is not numeric.
+static bool parseRow(const std::string& line, std::vector<double>& values) {
+    values.clear();
+    const char* p = line.c_str();
+    while (true) {
+        char* end = nullptr;
+        double value = std::strtod(p, &end);
+        if (end == p) {
+            return false;
+        }
+        values.push_back(value);
+        p = end;
+        while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+        if (*p == '\0') {
+            return true;
+        }
+        if (*p != ',' && *p != ';') {
+            return false;
+        }
+        p++;
+    }
+}
+
+size_t convertCsvToDataset(const std::string& csvPath, const std::string& datasetPath) {
+    std::ifstream in(csvPath);
+    if (!in) {
+        throw fileError("Cannot open CSV", csvPath);
+    }
+
+    std::vector<std::vector<float>> columns;
+    std::vector<double> labels;
+    std::vector<double> row;
+    bool isBinary = true;
+    bool hasZero = false;
+    std::string line;
+    size_t lineNo = 0;
+    while (std::getline(in, line)) {
+        lineNo++;
+        if (line.empty() || line == "\r") continue;
+        if (!parseRow(line, row)) {
+            if (lineNo == 1) continue; // Header line.
+            throw std::runtime_error(csvPath + ":" + std::to_string(lineNo) + ": expected numeric f1,...,fN,label");
+        }
+        if (columns.empty()) {
+            if (row.size() < 2) {
+                throw std::runtime_error(csvPath + ":" + std::to_string(lineNo) + ": need at least one feature and a label");
+            }
+            columns.resize(row.size() - 1);
+        } else if (row.size() != columns.size() + 1) {
+            throw std::runtime_error(csvPath + ":" + std::to_string(lineNo) + ": expected " +
+                                     std::to_string(columns.size() + 1) + " columns");
+        }
+        for (size_t c = 0; c < columns.size(); ++c) {
+            columns[c].push_back(static_cast<float>(row[c]));
+        }
+        double label = row.back();
+        labels.push_back(label);
+        isBinary = isBinary && (label == -1 || label == 0 || label == 1);
+        hasZero = hasZero || label == 0;
+    }
+
+    // 0/1 labels are mapped onto the -1/+1 convention used by the generators.
+    if (isBinary && hasZero) {
+        for (double& label : labels) {
+            label = label > 0 ? 1.0 : -1.0;
+        }
+    }
+    std::vector<const float*> columnPointers;
+    for (const auto& column : columns) {
+        columnPointers.push_back(column.data());
+    }
+    writeDatasetFile(datasetPath, columnPointers.data(), columns.size(), labels.data(), labels.size(), isBinary);
+    return labels.size();
+}
+
+DataGenerator makeFileGenerator(std::shared_ptr<const MappedDataset> dataset) {
+    // The Dataset views the mapped columns directly; the mapping stays alive
+    // for as long as any copy or slice of it does.
+    const void* labels = dataset->isClassification() ? static_cast<const void*>(dataset->classLabels())
+                                                     : static_cast<const void*>(dataset->regressionLabels());
+    // Consecutive feature columns are a fixed, 64-byte aligned distance apart.
+    size_t stride = (datasetColumnOffset(dataset->size(), 1) - datasetColumnOffset(dataset->size(), 0)) / sizeof(float);
+    Dataset view = Dataset::view(dataset->size(), dataset->numFeatures(), stride, dataset->isClassification(),
+                                 dataset->column(0), labels, dataset);
+    return FixedDataGenerator{view};
+}
+
+} // namespace playground
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "dataset.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace playground {
+
+/**
+ * On-disk layout of a binary dataset file (all fields little-endian):
+ *
+ *   DatasetFileHeader                      (64 bytes)
+ *   float32 column[numRows]  x numFeatures (each starts on a 64-byte boundary)
+ *                                          (1 or more features; 2 for the
+ *                                           synthetic generators)
+ *   label column[numRows]                  (int8 for classification, float32
+ *                                           for regression; 64-byte aligned)
+ *
+ * Columns are stored back to back (struct-of-arrays), so a mapped file can be
+ * read in place without any parsing.
+ */
+struct DatasetFileHeader {
+    char magic[4];        // "NNPD"
+    uint32_t version;     // DATASET_FILE_VERSION
+    uint64_t numRows;
+    uint32_t numFeatures;
+    uint32_t labelType;   // DatasetLabelType
+    uint64_t reserved[5];
+};
+
+enum DatasetLabelType : uint32_t {
+    LABELS_FLOAT32 = 0, // Regression targets.
+    LABELS_INT8 = 1,    // Classification labels, -1 or +1.
+};
+
+constexpr uint32_t DATASET_FILE_VERSION = 1;
+
+/**
+ * A dataset file mapped read-only into memory. Opening is O(1) in the number
+ * of rows; pages are faulted in lazily as the columns are read.
+ */
+class MappedDataset {
+public:
+    /**
+     * Maps the file at `path`. Throws std::runtime_error if the file cannot be
+     * opened or is not a valid dataset file.
+     */
+    explicit MappedDataset(const std::string& path);
+    ~MappedDataset();
+
+    MappedDataset(const MappedDataset&) = delete;
+    MappedDataset& operator=(const MappedDataset&) = delete;
+
+    size_t size() const { return header->numRows; }
+    size_t numFeatures() const { return header->numFeatures; }
+    bool isClassification() const { return header->labelType == LABELS_INT8; }
+
+    /**
+     * Returns the float32 column of feature `f`.
+     */
+    const float* column(size_t f) const;
+
+    /**
+     * Returns the label of row `i` as a double.
+     */
+    double label(size_t i) const;
+
+    const int8_t* classLabels() const;
+    const float* regressionLabels() const;
+
+private:
+    const DatasetFileHeader* header = nullptr;
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+};
+
+/**
+ * Returns the byte offset of column `c` (features first, then labels) in a
+ * file with `numRows` rows.
+ */
+size_t datasetColumnOffset(uint64_t numRows, size_t c);
+
+/**
+ * Writes a dataset file with `numFeatures` columns of `numRows` values each.
+ * Labels are stored as int8 when `classification` is set, as float32
+ * otherwise. Throws std::runtime_error on I/O errors.
+ */
+void writeDatasetFile(const std::string& path, const float* const* columns, size_t numFeatures,
+                      const double* labels, size_t numRows, bool classification);
+
+/**
+ * Converts a CSV file with f1,...,fN,label rows (an optional header line is
+ * skipped) into a binary dataset file; the label is the last column. The data
+ * is treated as classification when every label is -1/+1 or 0/1 (0 maps to
+ * -1). Returns the number of rows written. Throws std::runtime_error on I/O or
+ * parse errors.
+ */
+size_t convertCsvToDataset(const std::string& csvPath, const std::string& datasetPath);
+
+/**
+ * Wraps a mapped dataset as a FixedDataGenerator so it can be listed next to
+ * the synthetic generators. makeDataset() on it views the mapped columns
+ * without copying.
+ */
+DataGenerator makeFileGenerator(std::shared_ptr<const MappedDataset> dataset);
+
+} // namespace playground
@@ -84,13 +84,20 @@ void HeatMap::draw(ImDrawList* drawList, ImVec2 canvas_p0, ImVec2 canvas_sz) {
     }
 }
 
-void HeatMap::drawDataPoints(ImDrawList* drawList, ImVec2 canvas_p0, ImVec2 canvas_sz, const std::vector<playground::Example2D>& dataPoints) {
+void HeatMap::drawDataPoints(ImDrawList* drawList, ImVec2 canvas_p0, ImVec2 canvas_sz, const playground::Dataset& dataPoints,
+                             size_t axisX, size_t axisY) {
     ImVec2 canvas_p1 = ImVec2(canvas_p0.x + canvas_sz.x, canvas_p0.y + canvas_sz.y);
     float pointRadius = 4.5f;
 
     //std::cout << "HeatMap::drawDataPoints called with " << dataPoints.size() << " data points." << std::endl;
 
-    for (const auto& point : dataPoints) {
+    // Large datasets are drawn as an evenly strided subsample.
+    const size_t maxDrawnPoints = 5000;
+    const size_t step = std::max<size_t>(1, dataPoints.size() / maxDrawnPoints);
+    // Higher-dimensional data is projected onto the two plotted axes; a
+    // missing axis (a one-feature file) reads as 0.
+    for (size_t i = 0; i < dataPoints.size(); i += step) {
+        playground::Example2D point = dataPoints.example(i, axisX, axisY);
         ImVec2 screenPos = scale(point.x, point.y, canvas_p0, canvas_p1);
         ImU32 color = getColor(point.label, true); // Use opaque color for data points
         drawList->AddCircleFilled(screenPos, pointRadius, color);
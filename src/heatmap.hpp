@@ -10,7 +10,8 @@ public:
 
     void updateBackground(const std::vector<std::vector<double>>& data, bool discretize);
     void draw(ImDrawList* drawList, ImVec2 canvas_p0, ImVec2 canvas_sz);
-    void drawDataPoints(ImDrawList* drawList, ImVec2 canvas_p0, ImVec2 canvas_sz, const std::vector<playground::Example2D>& dataPoints);
+    void drawDataPoints(ImDrawList* drawList, ImVec2 canvas_p0, ImVec2 canvas_sz, const playground::Dataset& dataPoints,
+                        size_t axisX = 0, size_t axisY = 1);
 
 public:
     ImU32 getColor(double value, bool opaque = false);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "nn.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace nn {
+
+// Approximations of the transcendentals for the FAST_ activation kinds.
+// They have no branches or calls, so loops over them vectorize. codegen.cpp
+// writes a copy of fastExp, fastTanh and fastSigmoid into exported headers.
+
+// e^x for |x| <= 708: x = k ln 2 + r with |r| <= ln(2) / 2, e^r by its
+// degree-7 Taylor polynomial and 2^k by writing the exponent bits. The
+// relative error is below 1e-8.
+inline double fastExp(double x) {
+    const double LOG2E = 1.4426950408889634;
+    const double LN2_HI = 6.93147180369123816490e-01, LN2_LO = 1.90821492927058770002e-10;
+    const double SHIFT = 6755399441055744.0; // 1.5 * 2^52: adding it rounds to an integer.
+    double t = x * LOG2E + SHIFT;
+    double k = t - SHIFT;
+    double r = (x - k * LN2_HI) - k * LN2_LO;
+    double p = 1.0 / 5040;
+    p = p * r + 1.0 / 720;
+    p = p * r + 1.0 / 120;
+    p = p * r + 1.0 / 24;
+    p = p * r + 1.0 / 6;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+    int64_t bits, shiftBits;
+    std::memcpy(&bits, &t, sizeof bits);
+    std::memcpy(&shiftBits, &SHIFT, sizeof shiftBits);
+    uint64_t scaleBits = static_cast<uint64_t>(bits - shiftBits + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &scaleBits, sizeof scale);
+    return p * scale;
+}
+
+// Clamps x to [-limit, limit] with arithmetic only: a comparison here keeps
+// GCC from vectorizing the loops that call fastExp. The rounding error is
+// far below the accuracy of the callers.
+inline double clampAbs(double x, double limit) {
+    return 0.5 * (std::abs(x + limit) - std::abs(x - limit));
+}
+
+// tanh within 4e-9 (absolute) everywhere.
+inline double fastTanh(double x) {
+    return 1 - 2 / (fastExp(2 * clampAbs(x, 20.0)) + 1);
+}
+
+// The logistic sigmoid within 2e-9 (absolute) everywhere.
+inline double fastSigmoid(double x) {
+    return 1 / (1 + fastExp(-clampAbs(x, 700.0)));
+}
+
+// Activation loops shared by the flat-array engines (Population, the fixed
+// shape kernels). They compute exactly what Activations computes through
+// std::function, with the kind switch outside the loop over `count` values.
+
+inline void activate(ActivationKind kind, const double* total, double* out, size_t count) {
+    switch (kind) {
+    case ActivationKind::TANH:
+        for (size_t k = 0; k < count; ++k) out[k] = std::tanh(total[k]);
+        break;
+    case ActivationKind::RELU:
+        for (size_t k = 0; k < count; ++k) out[k] = std::max(0.0, total[k]);
+        break;
+    case ActivationKind::SIGMOID:
+        for (size_t k = 0; k < count; ++k) out[k] = 1.0 / (1.0 + std::exp(-total[k]));
+        break;
+    case ActivationKind::LINEAR:
+        for (size_t k = 0; k < count; ++k) out[k] = total[k];
+        break;
+    case ActivationKind::FAST_TANH:
+        for (size_t k = 0; k < count; ++k) out[k] = fastTanh(total[k]);
+        break;
+    case ActivationKind::FAST_SIGMOID:
+        for (size_t k = 0; k < count; ++k) out[k] = fastSigmoid(total[k]);
+        break;
+    }
+}
+
+// inputDer = outputDer * f'(totalInput), with f' written in terms of the
+// output where that matches Activations exactly.
+inline void activationDer(ActivationKind kind, const double* total, const double* out, const double* outputDer,
+                          double* inputDer, size_t count) {
+    switch (kind) {
+    case ActivationKind::TANH:
+    case ActivationKind::FAST_TANH:
+        for (size_t k = 0; k < count; ++k) inputDer[k] = outputDer[k] * (1 - out[k] * out[k]);
+        break;
+    case ActivationKind::RELU:
+        for (size_t k = 0; k < count; ++k) inputDer[k] = outputDer[k] * (total[k] <= 0 ? 0.0 : 1.0);
+        break;
+    case ActivationKind::SIGMOID:
+    case ActivationKind::FAST_SIGMOID:
+        for (size_t k = 0; k < count; ++k) inputDer[k] = outputDer[k] * (out[k] * (1.0 - out[k]));
+        break;
+    case ActivationKind::LINEAR:
+        for (size_t k = 0; k < count; ++k) inputDer[k] = outputDer[k];
+        break;
+    }
+}
+
+// RegularizationFunctions::der for `kind`; 0 for NONE.
+inline double regularizationDer(RegularizationKind kind, double w) {
+    switch (kind) {
+    case RegularizationKind::L1: return w < 0 ? -1.0 : (w > 0 ? 1.0 : 0.0);
+    case RegularizationKind::L2: return w;
+    default: return 0.0;
+    }
+}
+
+} // namespace nn
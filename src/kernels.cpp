@@ -0,0 +1,541 @@
+#include "kernels.hpp"
+#include "kernel_math.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+namespace nn {
+
+namespace {
+
+// State and the per-batch work shared by every shape: loading, storing and
+// updating run once per batch or epoch, so runtime sizes are fine there.
+class FlatKernel : public Kernel {
+public:
+    FlatKernel(const std::vector<int>& shape, ActivationKind activation, ActivationKind outputActivation,
+               RegularizationKind regularization)
+        : numInputs(shape[0]), activation(activation), outputActivation(outputActivation),
+          regularization(regularization) {
+        size_t numNodes = 0, numLinks = 0;
+        for (size_t l = 0; l < shape.size(); ++l) {
+            numNodes += shape[l];
+            if (l > 0) numLinks += static_cast<size_t>(shape[l - 1]) * shape[l];
+        }
+        bias.assign(numNodes, 0.0);
+        accInputDer.assign(numNodes, 0.0);
+        weights.assign(numLinks, 0.0);
+        accErrorDer.assign(numLinks, 0.0);
+        dead.assign(numLinks, 0);
+    }
+
+    size_t inputSize() const override { return numInputs; }
+
+    void load(const Network& network) override {
+        size_t node = 0, link = 0;
+        for (const auto& layer : network) {
+            for (const Node* n : layer) {
+                bias[node] = n->bias;
+                accInputDer[node] = n->accInputDer;
+                node++;
+                for (const Link* in : n->inputLinks) {
+                    weights[link] = in->weight;
+                    accErrorDer[link] = in->accErrorDer;
+                    dead[link] = in->isDead;
+                    link++;
+                }
+            }
+        }
+        numAccumulated = network.back()[0]->numAccumulatedDers;
+    }
+
+    void store(Network& network) const override {
+        size_t node = 0, link = 0;
+        for (auto& layer : network) {
+            for (Node* n : layer) {
+                n->bias = bias[node];
+                n->accInputDer = accInputDer[node];
+                if (node >= numInputs) n->numAccumulatedDers = numAccumulated;
+                node++;
+                for (Link* in : n->inputLinks) {
+                    in->weight = weights[link];
+                    in->accErrorDer = accErrorDer[link];
+                    in->isDead = dead[link];
+                    in->numAccumulatedDers = dead[link] ? 0 : numAccumulated;
+                    link++;
+                }
+            }
+        }
+    }
+
+    void update(double learningRate, double regularizationRate) override {
+        if (numAccumulated == 0) {
+            return;
+        }
+        const double n = numAccumulated;
+        for (size_t node = numInputs; node < bias.size(); ++node) {
+            bias[node] -= learningRate * accInputDer[node] / n;
+            accInputDer[node] = 0;
+        }
+        for (size_t link = 0; link < weights.size(); ++link) {
+            if (dead[link]) continue;
+            weights[link] -= (learningRate / n) * accErrorDer[link];
+            regularize(link, learningRate, regularizationRate);
+            accErrorDer[link] = 0;
+        }
+        numAccumulated = 0;
+        weightsChanged();
+    }
+
+    void update(double learningRate, double regularizationRate, Optimizer& optimizer) override {
+        if (numAccumulated == 0) {
+            return;
+        }
+        switch (optimizer.kind) {
+        case OptimizerKind::SGD: update(learningRate, regularizationRate); return;
+        case OptimizerKind::MOMENTUM: applyOptimizer<OptimizerKind::MOMENTUM>(learningRate, regularizationRate, optimizer); break;
+        case OptimizerKind::NESTEROV: applyOptimizer<OptimizerKind::NESTEROV>(learningRate, regularizationRate, optimizer); break;
+        case OptimizerKind::RMSPROP: applyOptimizer<OptimizerKind::RMSPROP>(learningRate, regularizationRate, optimizer); break;
+        case OptimizerKind::ADAM: applyOptimizer<OptimizerKind::ADAM>(learningRate, regularizationRate, optimizer); break;
+        }
+        numAccumulated = 0;
+        weightsChanged();
+    }
+
+protected:
+    // Called after an update changed the weights.
+    virtual void weightsChanged() {}
+
+    // The regularization step of a link after its gradient step.
+    void regularize(size_t link, double learningRate, double regularizationRate) {
+        double& w = weights[link];
+        double regulDer = regularizationDer(regularization, w);
+        double newWeight = w - (learningRate * regularizationRate) * regulDer;
+        if (regularization == RegularizationKind::L1 && w * newWeight < 0) {
+            // The weight crossed 0 due to L1 regularization. Set it to 0.
+            w = 0;
+            dead[link] = 1;
+        } else {
+            w = newWeight;
+        }
+    }
+
+    // Averaging, the update rule, regularization and clearing the
+    // accumulators in one pass over each array, with the rule inlined.
+    template <OptimizerKind K>
+    void applyOptimizer(double learningRate, double regularizationRate, Optimizer& optimizer) {
+        optimizer.beginUpdate();
+        const double n = numAccumulated;
+        const size_t biasOffset = optimizer.numLinks();
+        for (size_t node = numInputs; node < bias.size(); ++node) {
+            bias[node] -= optimizer.delta<K>(biasOffset + node, accInputDer[node] / n, learningRate);
+            accInputDer[node] = 0;
+        }
+        for (size_t link = 0; link < weights.size(); ++link) {
+            if (dead[link]) continue;
+            weights[link] -= optimizer.delta<K>(link, accErrorDer[link] / n, learningRate);
+            regularize(link, learningRate, regularizationRate);
+            accErrorDer[link] = 0;
+        }
+    }
+
+    size_t numInputs;
+    ActivationKind activation;
+    ActivationKind outputActivation;
+    RegularizationKind regularization;
+
+    // Nodes and links in graph order: layer by layer, and the links into a
+    // node in the order of its inputLinks.
+    std::vector<double> bias, accInputDer;
+    std::vector<double> weights, accErrorDer;
+    std::vector<uint8_t> dead;
+    int numAccumulated = 0;
+};
+
+// The per-example work. Every hidden width is a compile time constant; the
+// number of inputs is not, so that one instantiation serves every
+// combination of input features.
+template <int... Hidden>
+class FixedKernel final : public FlatKernel {
+    static constexpr int L = sizeof...(Hidden) + 2;
+    static constexpr std::array<int, L> W = {0, Hidden..., 1}; // W[0] is numInputs.
+
+    // Nodes of layers 1 to l - 1, and links into layers 2 to l - 1.
+    static constexpr int hiddenNodesBefore(int l) {
+        int count = 0;
+        for (int i = 1; i < l; ++i) count += W[i];
+        return count;
+    }
+    static constexpr int hiddenLinksBefore(int l) {
+        int count = 0;
+        for (int i = 2; i < l; ++i) count += W[i - 1] * W[i];
+        return count;
+    }
+
+    // Node n of layer l (l >= 1) is nodeOffset(l) + n; the links into it
+    // start at linkOffset(l) + n * (fan-in of l).
+    int nodeOffset(int l) const { return static_cast<int>(numInputs) + hiddenNodesBefore(l); }
+    int linkOffset(int l) const { return l == 1 ? 0 : static_cast<int>(numInputs) * W[1] + hiddenLinksBefore(l); }
+
+public:
+    FixedKernel(size_t numInputs, ActivationKind activation, ActivationKind outputActivation,
+                RegularizationKind regularization)
+        : FlatKernel({static_cast<int>(numInputs), Hidden..., 1}, activation, outputActivation, regularization) {
+        size_t numNodes = bias.size();
+        totalInput.assign(numNodes, 0.0);
+        output.assign(numNodes, 0.0);
+        inputDer.assign(numNodes, 0.0);
+        outputDer.assign(numNodes, 0.0);
+    }
+
+    double forward(const double* input) override {
+        for (size_t i = 0; i < numInputs; ++i) output[i] = input[i];
+        forwardLayers(std::make_index_sequence<L - 1>());
+        return output.back();
+    }
+
+    void backward(double target) override {
+        outputDer.back() = output.back() - target; // Errors::SQUARE.der
+        numAccumulated++;
+        backwardLayers(std::make_index_sequence<L - 1>());
+    }
+
+private:
+    template <int l>
+    void forwardLayer() {
+        constexpr int out = W[l];
+        const int in = l == 1 ? static_cast<int>(numInputs) : W[l - 1];
+        const int first = nodeOffset(l);
+        const double* w = weights.data() + linkOffset(l);
+        const double* src = output.data() + (l == 1 ? 0 : nodeOffset(l - 1));
+        for (int n = 0; n < out; ++n) {
+            double total = bias[first + n];
+            for (int i = 0; i < in; ++i) total += w[n * in + i] * src[i];
+            totalInput[first + n] = total;
+        }
+        activate(l == L - 1 ? outputActivation : activation, &totalInput[first], &output[first], out);
+    }
+
+    template <int l>
+    void backwardLayer() {
+        constexpr int out = W[l];
+        const int in = l == 1 ? static_cast<int>(numInputs) : W[l - 1];
+        const int first = nodeOffset(l);
+        activationDer(l == L - 1 ? outputActivation : activation, &totalInput[first], &output[first],
+                      &outputDer[first], &inputDer[first], out);
+        const double* der = inputDer.data() + first;
+        const double* src = output.data() + (l == 1 ? 0 : nodeOffset(l - 1));
+        const double* w = weights.data() + linkOffset(l);
+        double* acc = accErrorDer.data() + linkOffset(l);
+        const uint8_t* isDead = dead.data() + linkOffset(l);
+        for (int n = 0; n < out; ++n) {
+            accInputDer[first + n] += der[n];
+            for (int i = 0; i < in; ++i) {
+                if (!isDead[n * in + i]) acc[n * in + i] += der[n] * src[i];
+            }
+        }
+        if constexpr (l > 1) {
+            // Summed over destination nodes in the same order as backProp.
+            double* prevDer = outputDer.data() + nodeOffset(l - 1);
+            for (int i = 0; i < in; ++i) prevDer[i] = 0;
+            for (int n = 0; n < out; ++n) {
+                for (int i = 0; i < in; ++i) prevDer[i] += w[n * in + i] * der[n];
+            }
+        }
+    }
+
+    template <size_t... Is>
+    void forwardLayers(std::index_sequence<Is...>) {
+        (forwardLayer<Is + 1>(), ...);
+    }
+
+    template <size_t... Is>
+    void backwardLayers(std::index_sequence<Is...>) {
+        (backwardLayer<L - 1 - Is>(), ...);
+    }
+
+    std::vector<double> totalInput, output, inputDer, outputDer;
+};
+
+// --- Blocked dense layers ---
+//
+// Matrices are row-major: a layer's weights are w[n * in + i] (graph order)
+// and a block of examples is x[b * width + i]. The tiles below only reorder
+// which elements are computed when; every single element is still summed in
+// the same order as forwardProp/backProp, so results match the graph engine.
+
+constexpr int TILE = 4;       // Register tile edge.
+constexpr int K_BLOCK = 256;  // Summation block, so tile operands stay in L1.
+
+// z[b][n] += sum over i in [i0, i1) of w[n][i] * x[b][i], for a full tile.
+static void forwardTile(const double* w, const double* x, double* z, int in, int out, int i0, int i1) {
+    double acc[TILE][TILE];
+    for (int r = 0; r < TILE; ++r)
+        for (int c = 0; c < TILE; ++c) acc[r][c] = z[r * out + c];
+    for (int i = i0; i < i1; ++i) {
+        for (int r = 0; r < TILE; ++r)
+            for (int c = 0; c < TILE; ++c) acc[r][c] += w[c * in + i] * x[r * in + i];
+    }
+    for (int r = 0; r < TILE; ++r)
+        for (int c = 0; c < TILE; ++c) z[r * out + c] = acc[r][c];
+}
+
+// z = bias + x * w^T for `rows` examples.
+static void denseForward(const double* w, const double* bias, const double* x, double* z, int rows, int in,
+                         int out) {
+    for (int b = 0; b < rows; ++b)
+        for (int n = 0; n < out; ++n) z[b * out + n] = bias[n];
+    for (int i0 = 0; i0 < in; i0 += K_BLOCK) {
+        int i1 = std::min(in, i0 + K_BLOCK);
+        for (int n0 = 0; n0 < out; n0 += TILE) {
+            for (int b0 = 0; b0 < rows; b0 += TILE) {
+                if (n0 + TILE <= out && b0 + TILE <= rows) {
+                    forwardTile(w + n0 * in, x + b0 * in, z + b0 * out + n0, in, out, i0, i1);
+                    continue;
+                }
+                for (int b = b0; b < std::min(rows, b0 + TILE); ++b) {
+                    for (int n = n0; n < std::min(out, n0 + TILE); ++n) {
+                        double total = z[b * out + n];
+                        for (int i = i0; i < i1; ++i) total += w[n * in + i] * x[b * in + i];
+                        z[b * out + n] = total;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// acc[n][i] += sum over b of der[b][n] * x[b][i], skipping dead links: the
+// outer product of one block, summed example by example.
+static void denseGradient(const double* der, const double* x, const uint8_t* dead, double* acc, int rows, int in,
+                          int out) {
+    for (int n0 = 0; n0 < out; n0 += TILE) {
+        for (int i0 = 0; i0 < in; i0 += TILE) {
+            if (n0 + TILE <= out && i0 + TILE <= in) {
+                double tile[TILE][TILE];
+                for (int r = 0; r < TILE; ++r)
+                    for (int c = 0; c < TILE; ++c) tile[r][c] = acc[(n0 + r) * in + i0 + c];
+                for (int b = 0; b < rows; ++b) {
+                    for (int r = 0; r < TILE; ++r)
+                        for (int c = 0; c < TILE; ++c) tile[r][c] += der[b * out + n0 + r] * x[b * in + i0 + c];
+                }
+                for (int r = 0; r < TILE; ++r) {
+                    for (int c = 0; c < TILE; ++c) {
+                        size_t link = (n0 + r) * in + i0 + c;
+                        if (!dead[link]) acc[link] = tile[r][c];
+                    }
+                }
+                continue;
+            }
+            for (int n = n0; n < std::min(out, n0 + TILE); ++n) {
+                for (int i = i0; i < std::min(in, i0 + TILE); ++i) {
+                    size_t link = n * in + i;
+                    if (dead[link]) continue;
+                    for (int b = 0; b < rows; ++b) acc[link] += der[b * out + n] * x[b * in + i];
+                }
+            }
+        }
+    }
+}
+
+// t[i][n] = w[n][i], in square blocks so that both sides stay in cache.
+static void transpose(const double* w, double* t, int in, int out) {
+    const int BLOCK = 16;
+    for (int n0 = 0; n0 < out; n0 += BLOCK) {
+        for (int i0 = 0; i0 < in; i0 += BLOCK) {
+            for (int n = n0; n < std::min(out, n0 + BLOCK); ++n)
+                for (int i = i0; i < std::min(in, i0 + BLOCK); ++i) t[i * out + n] = w[n * in + i];
+        }
+    }
+}
+
+// Any shape, with runtime sizes. Examples go through in blocks of up to
+// CHUNK, so each layer is a small matrix product instead of one
+// matrix-vector product per example.
+class DenseKernel final : public FlatKernel {
+    static constexpr int CHUNK = 32;
+
+public:
+    DenseKernel(const std::vector<int>& shape, ActivationKind activation, ActivationKind outputActivation,
+                RegularizationKind regularization)
+        : FlatKernel(shape, activation, outputActivation, regularization), shape(shape) {
+        size_t offset = 0, links = 0;
+        for (size_t l = 0; l < shape.size(); ++l) {
+            rowOffset.push_back(offset);
+            linkOffset.push_back(links);
+            offset += static_cast<size_t>(CHUNK) * shape[l];
+            if (l + 1 < shape.size()) links += static_cast<size_t>(shape[l]) * shape[l + 1];
+        }
+        totalInput.assign(offset, 0.0);
+        output.assign(offset, 0.0);
+        inputDer.assign(offset, 0.0);
+        outputDer.assign(offset, 0.0);
+        transposed.assign(weights.size(), 0.0);
+        zeros.assign(*std::max_element(shape.begin(), shape.end()), 0.0);
+    }
+
+    void load(const Network& network) override {
+        FlatKernel::load(network);
+        updateTransposed();
+    }
+
+    double forward(const double* input) override {
+        forwardRows(input, 1);
+        return output[rowOffset.back()];
+    }
+
+    void backward(double target) override {
+        backwardRows(&target, 1);
+    }
+
+    void train(const double* inputs, const double* targets, size_t count, double* outputs) override {
+        for (size_t first = 0; first < count; first += CHUNK) {
+            int rows = static_cast<int>(std::min<size_t>(CHUNK, count - first));
+            forwardRows(inputs + first * numInputs, rows);
+            if (outputs) std::copy_n(&output[rowOffset.back()], rows, outputs + first);
+            backwardRows(targets + first, rows);
+        }
+    }
+
+    void predict(const double* inputs, size_t count, double* outputs) override {
+        for (size_t first = 0; first < count; first += CHUNK) {
+            int rows = static_cast<int>(std::min<size_t>(CHUNK, count - first));
+            forwardRows(inputs + first * numInputs, rows);
+            std::copy_n(&output[rowOffset.back()], rows, outputs + first);
+        }
+    }
+
+private:
+    void weightsChanged() override {
+        updateTransposed();
+    }
+
+    size_t nodeOffset(size_t l) const {
+        size_t offset = 0;
+        for (size_t i = 0; i < l; ++i) offset += shape[i];
+        return offset;
+    }
+
+    void forwardRows(const double* inputs, int rows) {
+        std::copy_n(inputs, static_cast<size_t>(rows) * numInputs, &output[0]);
+        for (size_t l = 1; l < shape.size(); ++l) {
+            denseForward(&weights[linkOffset[l - 1]], &bias[nodeOffset(l)], &output[rowOffset[l - 1]],
+                         &totalInput[rowOffset[l]], rows, shape[l - 1], shape[l]);
+            activate(l + 1 == shape.size() ? outputActivation : activation, &totalInput[rowOffset[l]],
+                     &output[rowOffset[l]], static_cast<size_t>(rows) * shape[l]);
+        }
+    }
+
+    // Backward pass for the `rows` examples of the last forwardRows().
+    void backwardRows(const double* targets, int rows) {
+        size_t last = rowOffset.back();
+        for (int b = 0; b < rows; ++b) outputDer[last + b] = output[last + b] - targets[b]; // Errors::SQUARE.der
+        numAccumulated += rows;
+        for (size_t l = shape.size() - 1; l >= 1; --l) {
+            int in = shape[l - 1], out = shape[l];
+            size_t row = rowOffset[l], first = nodeOffset(l);
+            activationDer(l + 1 == shape.size() ? outputActivation : activation, &totalInput[row], &output[row],
+                          &outputDer[row], &inputDer[row], static_cast<size_t>(rows) * out);
+            for (int b = 0; b < rows; ++b)
+                for (int n = 0; n < out; ++n) accInputDer[first + n] += inputDer[row + b * out + n];
+            denseGradient(&inputDer[row], &output[rowOffset[l - 1]], &dead[linkOffset[l - 1]],
+                          &accErrorDer[linkOffset[l - 1]], rows, in, out);
+            if (l == 1) break;
+            // prev[b][i] = 0 + sum over n of w[n][i] * der[b][n]: with the
+            // transposed weights this is the forward product again, reading
+            // both operands contiguously.
+            denseForward(&transposed[linkOffset[l - 1]], zeros.data(), &inputDer[row], &outputDer[rowOffset[l - 1]],
+                         rows, out, in);
+        }
+    }
+
+    void updateTransposed() {
+        for (size_t l = 1; l < shape.size(); ++l) {
+            transpose(&weights[linkOffset[l - 1]], &transposed[linkOffset[l - 1]], shape[l - 1], shape[l]);
+        }
+    }
+
+    std::vector<int> shape;
+    // Layer l of the current block starts at rowOffset[l] in the per-example
+    // arrays below; its incoming weights start at linkOffset[l - 1].
+    std::vector<size_t> rowOffset, linkOffset;
+    std::vector<double> totalInput, output, inputDer, outputDer;
+    // Per layer, the weights as [i][n]: the matrix the backward pass reads.
+    // Refreshed whenever the weights change.
+    std::vector<double> transposed;
+    std::vector<double> zeros;
+};
+
+using KernelFactory = std::unique_ptr<Kernel> (*)(size_t, ActivationKind, ActivationKind, RegularizationKind);
+// Keyed by the hidden layer widths.
+using Registry = std::map<std::vector<int>, KernelFactory>;
+
+constexpr int MAX_WIDTH = 8;
+
+template <int... Hidden>
+std::unique_ptr<Kernel> create(size_t numInputs, ActivationKind activation, ActivationKind outputActivation,
+                               RegularizationKind regularization) {
+    return std::make_unique<FixedKernel<Hidden...>>(numInputs, activation, outputActivation, regularization);
+}
+
+template <int... Hidden>
+void add(Registry& registry) {
+    registry[{Hidden...}] = &create<Hidden...>;
+}
+
+template <int A, size_t... B>
+void addSecondLayer(Registry& registry, std::index_sequence<B...>) {
+    (add<A, B + 1>(registry), ...);
+}
+
+template <size_t... A>
+void addLayers(Registry& registry, std::index_sequence<A...>) {
+    add<>(registry);
+    (add<A + 1>(registry), ...);
+    (addSecondLayer<A + 1>(registry, std::make_index_sequence<MAX_WIDTH>()), ...);
+}
+
+const Registry& registry() {
+    static const Registry kernels = [] {
+        Registry r;
+        addLayers(r, std::make_index_sequence<MAX_WIDTH>());
+        return r;
+    }();
+    return kernels;
+}
+
+} // namespace
+
+void Kernel::train(const double* inputs, const double* targets, size_t count, double* outputs) {
+    size_t numInputs = inputSize();
+    for (size_t b = 0; b < count; ++b) {
+        double output = forward(inputs + b * numInputs);
+        if (outputs) outputs[b] = output;
+        backward(targets[b]);
+    }
+}
+
+void Kernel::predict(const double* inputs, size_t count, double* outputs) {
+    size_t numInputs = inputSize();
+    for (size_t b = 0; b < count; ++b) {
+        outputs[b] = forward(inputs + b * numInputs);
+    }
+}
+
+std::unique_ptr<Kernel> makeKernel(const std::vector<int>& shape, ActivationKind activation,
+                                   ActivationKind outputActivation, RegularizationKind regularization) {
+    if (shape.size() < 2 || shape[0] < 1 || shape.back() != 1) {
+        return nullptr;
+    }
+    if (std::find(shape.begin(), shape.end(), 0) != shape.end()) {
+        return nullptr;
+    }
+    auto it = registry().find(std::vector<int>(shape.begin() + 1, shape.end() - 1));
+    if (it == registry().end()) {
+        return std::make_unique<DenseKernel>(shape, activation, outputActivation, regularization);
+    }
+    return it->second(shape[0], activation, outputActivation, regularization);
+}
+
+} // namespace nn
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "nn.hpp"
+#include <memory>
+#include <vector>
+
+namespace nn {
+
+/**
+ * A training engine over flat arrays instead of the Node/Link graph. Small
+ * networks get a kernel specialized for their hidden layer widths, whose
+ * loops the compiler unrolls; any other shape gets a dense kernel that runs
+ * blocks of examples through cache-tiled matrix products. A kernel computes
+ * exactly what forwardProp, backProp(Errors::SQUARE) and updateWeights
+ * compute on the graph it was loaded from.
+ */
+class Kernel {
+public:
+    virtual ~Kernel() = default;
+
+    virtual size_t inputSize() const = 0;
+
+    /**
+     * Copies the weights, biases, dead links and pending accumulators of
+     * `network`, which must have the kernel's shape.
+     */
+    virtual void load(const Network& network) = 0;
+
+    /**
+     * Writes the state back, so that the graph can be drawn, saved or
+     * trained by the generic engine again.
+     */
+    virtual void store(Network& network) const = 0;
+
+    /**
+     * Runs `input` (one value per input node) forward and returns the output.
+     */
+    virtual double forward(const double* input) = 0;
+
+    /**
+     * Accumulates the square-error derivatives for `target` after forward().
+     */
+    virtual void backward(double target) = 0;
+
+    /**
+     * forward() and backward() for `count` examples, without updating in
+     * between. `inputs` holds one row of inputSize() values per example;
+     * the outputs are written to `outputs` unless it is null.
+     */
+    virtual void train(const double* inputs, const double* targets, size_t count, double* outputs);
+
+    /**
+     * Writes the outputs for `count` rows of inputs, like forward().
+     */
+    virtual void predict(const double* inputs, size_t count, double* outputs);
+
+    /**
+     * Applies the accumulated derivatives, like updateWeights.
+     */
+    virtual void update(double learningRate, double regularizationRate) = 0;
+
+    /**
+     * Same with the update rule of `optimizer`, whose state must be sized for
+     * the network (Optimizer::reset); computes what the updateWeights overload
+     * taking an optimizer computes.
+     */
+    virtual void update(double learningRate, double regularizationRate, Optimizer& optimizer) = 0;
+};
+
+/**
+ * Returns the kernel for `shape`: a specialized one for up to two hidden
+ * layers of 1 to 8 nodes, the dense one otherwise. Returns nullptr for shapes
+ * with an empty layer, which only the graph engine handles.
+ */
+std::unique_ptr<Kernel> makeKernel(const std::vector<int>& shape, ActivationKind activation,
+                                   ActivationKind outputActivation, RegularizationKind regularization);
+
+} // namespace nn
@@ -0,0 +1,158 @@
+#include "lbfgs.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace nn {
+
+static double dot(const double* a, const double* b, size_t n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+Lbfgs::Lbfgs(size_t numParams, int history)
+    : n(numParams), history(std::max(1, history)), position(n), gradient(n), direction(n), trial(n),
+      trialGradient(n), s(n * this->history), y(n * this->history), rho(this->history), alpha(this->history) {}
+
+void Lbfgs::reset(const double* x) {
+    std::copy_n(x, n, position.begin());
+    numPairs = 0;
+    newest = -1;
+    evaluated = false;
+    state = Status::RUNNING;
+}
+
+double Lbfgs::gradientNorm() const {
+    double norm = 0;
+    for (double g : gradient) norm = std::max(norm, std::abs(g));
+    return norm;
+}
+
+void Lbfgs::computeDirection() {
+    // Two-loop recursion (Nocedal & Wright, Algorithm 7.4).
+    for (size_t i = 0; i < n; ++i) direction[i] = -gradient[i];
+    for (int k = 0; k < numPairs; ++k) {
+        int j = (newest - k + history) % history;
+        alpha[j] = rho[j] * dot(&s[j * n], direction.data(), n);
+        for (size_t i = 0; i < n; ++i) direction[i] -= alpha[j] * y[j * n + i];
+    }
+    if (numPairs > 0) {
+        // Scale by s'y / y'y of the newest pair.
+        const double* yNewest = &y[newest * n];
+        double gamma = 1 / (rho[newest] * dot(yNewest, yNewest, n));
+        for (size_t i = 0; i < n; ++i) direction[i] *= gamma;
+    }
+    for (int k = numPairs - 1; k >= 0; --k) {
+        int j = (newest - k + history) % history;
+        double beta = rho[j] * dot(&y[j * n], direction.data(), n);
+        for (size_t i = 0; i < n; ++i) direction[i] += (alpha[j] - beta) * s[j * n + i];
+    }
+}
+
+double Lbfgs::evaluate(const Objective& objective, double step, double& slope) {
+    for (size_t i = 0; i < n; ++i) trial[i] = position[i] + step * direction[i];
+    double trialValue = objective(trial.data(), trialGradient.data());
+    numEvaluations++;
+    slope = dot(trialGradient.data(), direction.data(), n);
+    return std::isfinite(trialValue) ? trialValue : HUGE_VAL;
+}
+
+bool Lbfgs::lineSearch(const Objective& objective, double step, double slope, double& trialValue) {
+    // Strong Wolfe conditions (Nocedal & Wright, Algorithms 3.5 and 3.6),
+    // with bisection to zoom in. The curvature condition keeps the stored
+    // pairs informative; Armijo alone accepts steps that are far too short.
+    const double c1 = 1e-4, c2 = 0.9;
+    double lo = 0, loValue = value, hi = 0;
+    bool bracketed = false;
+    for (int attempt = 0; attempt < maxLineSearch; ++attempt) {
+        if (bracketed) {
+            step = 0.5 * (lo + hi);
+        }
+        double trialSlope;
+        trialValue = evaluate(objective, step, trialSlope);
+        if (trialValue > value + c1 * step * slope || trialValue >= loValue) {
+            hi = step;
+            bracketed = true;
+        } else {
+            if (std::abs(trialSlope) <= -c2 * slope) {
+                return true;
+            }
+            // Past the minimum along the line: it lies between the two.
+            if (bracketed ? trialSlope * (hi - lo) >= 0 : trialSlope >= 0) {
+                hi = lo;
+                bracketed = true;
+            }
+            lo = step;
+            loValue = trialValue;
+            if (!bracketed) {
+                step *= 2;
+            }
+        }
+    }
+    // Out of evaluations: settle for the best point with sufficient decrease.
+    if (lo == 0) {
+        return false;
+    }
+    double loSlope;
+    trialValue = evaluate(objective, lo, loSlope);
+    return true;
+}
+
+Lbfgs::Status Lbfgs::step(const Objective& objective) {
+    if (state != Status::RUNNING) {
+        return state;
+    }
+    if (!evaluated) {
+        value = objective(position.data(), gradient.data());
+        numEvaluations++;
+        evaluated = true;
+    }
+    if (gradientNorm() < gradientTolerance) {
+        return state = Status::CONVERGED;
+    }
+
+    computeDirection();
+    double slope = dot(direction.data(), gradient.data(), n);
+    if (slope >= 0) {
+        // The estimate went bad; fall back to steepest descent.
+        numPairs = 0;
+        for (size_t i = 0; i < n; ++i) direction[i] = -gradient[i];
+        slope = -dot(gradient.data(), gradient.data(), n);
+    }
+
+    // Without history the direction is the raw gradient, so the first step
+    // is kept short.
+    double step = numPairs > 0 ? 1.0 : std::min(1.0, 1.0 / std::sqrt(-slope));
+    double trialValue;
+    if (!lineSearch(objective, step, slope, trialValue)) {
+        return state = Status::STALLED;
+    }
+
+    // Store the pair unless the curvature is not positive, which would make
+    // the estimate indefinite.
+    int next = (newest + 1) % history;
+    double* sNext = &s[next * n];
+    double* yNext = &y[next * n];
+    for (size_t i = 0; i < n; ++i) {
+        sNext[i] = trial[i] - position[i];
+        yNext[i] = trialGradient[i] - gradient[i];
+    }
+    double curvature = dot(sNext, yNext, n);
+    if (curvature > 1e-12 * dot(yNext, yNext, n)) {
+        rho[next] = 1 / curvature;
+        newest = next;
+        numPairs = std::min(numPairs + 1, history);
+    } else {
+        // The slot held the oldest pair if the buffer was full.
+        numPairs = std::min(numPairs, history - 1);
+    }
+    position.swap(trial);
+    gradient.swap(trialGradient);
+    value = trialValue;
+    if (gradientNorm() < gradientTolerance) {
+        state = Status::CONVERGED;
+    }
+    return state;
+}
+
+} // namespace nn
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace nn {
+
+/**
+ * A limited-memory BFGS minimizer over a flat parameter vector, for
+ * full-batch training. Each iteration takes the quasi-Newton direction from
+ * the last `history` steps and a line search along it. All
+ * buffers are allocated up front, so iterating does not allocate.
+ */
+class Lbfgs {
+public:
+    /**
+     * Returns the objective at `x` and writes its gradient to `gradient`.
+     */
+    using Objective = std::function<double(const double* x, double* gradient)>;
+
+    enum class Status {
+        RUNNING,
+        CONVERGED, // The gradient norm is below the tolerance.
+        STALLED,   // The line search found no decrease.
+    };
+
+    Lbfgs(size_t numParams, int history);
+
+    // Stop once the largest gradient component is below this.
+    double gradientTolerance = 1e-6;
+    // Objective evaluations per line search before giving up.
+    int maxLineSearch = 20;
+
+    /**
+     * Starts over from `x`, dropping the history.
+     */
+    void reset(const double* x);
+
+    /**
+     * Runs one iteration and returns the status. The first call also
+     * evaluates the starting point. Afterwards x() is the accepted point,
+     * which need not be the last one passed to `objective`.
+     */
+    Status step(const Objective& objective);
+
+    const std::vector<double>& x() const { return position; }
+    double loss() const { return value; }
+    double gradientNorm() const;
+    Status status() const { return state; }
+    // Objective evaluations so far.
+    int evaluations() const { return numEvaluations; }
+
+private:
+    // Writes -H * gradient to `direction`, H being the inverse Hessian
+    // estimate from the stored pairs.
+    void computeDirection();
+    // Evaluates position + step * direction into trial and trialGradient;
+    // returns the objective (infinity if it is not finite) and sets `slope`
+    // to the directional derivative there.
+    double evaluate(const Objective& objective, double step, double& slope);
+    // Finds a step along `direction` that satisfies the strong Wolfe
+    // conditions, starting at `step`; leaves the point in trial. Returns
+    // false if no step decreases the objective.
+    bool lineSearch(const Objective& objective, double step, double slope, double& trialValue);
+
+    size_t n;
+    int history;
+    std::vector<double> position, gradient, direction;
+    std::vector<double> trial, trialGradient;
+    // Ring buffers of `history` position and gradient changes.
+    std::vector<double> s, y, rho, alpha;
+    int numPairs = 0, newest = -1;
+    double value = 0;
+    bool evaluated = false;
+    int numEvaluations = 0;
+    Status state = Status::RUNNING;
+};
+
+} // namespace nn
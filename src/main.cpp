@@ -4,7 +4,10 @@
 #include <implot.h>
 #include "glad.h"
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 #include "playground.hpp"
 
@@ -12,7 +15,7 @@ void glfw_error_callback(int error, const char* description) {
     fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
-int main() {
+int main(int argc, char** argv) {
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit())
         return 1;
@@ -46,6 +49,34 @@ int main() {
     ImGui_ImplOpenGL3_Init(glsl_version);
 
     PlaygroundApp app;
+    // Arguments are binary dataset files to list next to the generators, a
+    // .nnck checkpoint to resume from (after the datasets it may refer to), or
+    // --max-layers N / --max-width N to raise the limits of the shape controls.
+    std::string checkpoint;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--max-layers" || arg == "--max-width") && i + 1 < argc) {
+            int limit = std::max(1, std::atoi(argv[++i]));
+            (arg == "--max-layers" ? app.maxHiddenLayers : app.maxLayerWidth) = limit;
+            continue;
+        }
+        if (arg.size() > 5 && arg.compare(arg.size() - 5, 5, ".nnck") == 0) {
+            checkpoint = arg;
+            continue;
+        }
+        try {
+            app.loadDatasetFile(arg);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+    if (!checkpoint.empty()) {
+        try {
+            app.loadCheckpoint(checkpoint);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
 
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
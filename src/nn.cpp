@@ -1,9 +1,9 @@
 #include "nn.hpp"
-#include <random>
+#include "kernel_math.hpp"
+#include "random.hpp"
+#include <algorithm>
 #include <cmath>
 #include <stdexcept>
-#include <set>
-#include <chrono>
 
 namespace nn {
 
@@ -11,20 +11,9 @@ namespace nn {
 // UTILITY/HELPER FUNCTIONS
 // ==============================================================================
 
-// A helper to get a thread-safe random number generator, seeded once.
-static std::mt19937& getRandomEngine() {
-    static std::seed_seq ss{
-        static_cast<unsigned int>(std::chrono::high_resolution_clock::now().time_since_epoch().count()),
-        std::random_device{}(),
-    };
-    static std::mt19937 engine(ss);
-    return engine;
-}
-
-// Returns a random number in [-0.5, 0.5).
-static double randHalf() {
-    std::uniform_real_distribution<double> dist(-0.5, 0.5);
-    return dist(getRandomEngine());
+// Returns a random number in [-0.5, 0.5) for the link with the given index.
+static double randHalf(const rng::Stream& stream, uint64_t linkIndex) {
+    return stream.uniform(linkIndex) - 0.5;
 }
 
 // ==============================================================================
@@ -57,6 +46,22 @@ const ActivationFunction Activations::LINEAR = {
     [](double x) { return 1.0; }
 };
 
+const ActivationFunction Activations::FAST_TANH = {
+    [](double x) { return fastTanh(x); },
+    [](double x) {
+        double output = fastTanh(x);
+        return 1 - output * output;
+    }
+};
+
+const ActivationFunction Activations::FAST_SIGMOID = {
+    [](double x) { return fastSigmoid(x); },
+    [](double x) {
+        double output = fastSigmoid(x);
+        return output * (1.0 - output);
+    }
+};
+
 const RegularizationFunction RegularizationFunctions::L1 = {
     [](double w) { return std::abs(w); },
     [](double w) { return w < 0 ? -1.0 : (w > 0 ? 1.0 : 0.0); }
@@ -72,12 +77,31 @@ const ErrorFunction Errors::SQUARE = {
     [](double output, double target) { return output - target; }
 };
 
+bool activationKindOf(const ActivationFunction* activation, ActivationKind& kind) {
+    if (activation == &Activations::TANH) kind = ActivationKind::TANH;
+    else if (activation == &Activations::RELU) kind = ActivationKind::RELU;
+    else if (activation == &Activations::SIGMOID) kind = ActivationKind::SIGMOID;
+    else if (activation == &Activations::LINEAR) kind = ActivationKind::LINEAR;
+    else if (activation == &Activations::FAST_TANH) kind = ActivationKind::FAST_TANH;
+    else if (activation == &Activations::FAST_SIGMOID) kind = ActivationKind::FAST_SIGMOID;
+    else return false;
+    return true;
+}
+
+bool regularizationKindOf(const RegularizationFunction* regularization, RegularizationKind& kind) {
+    if (regularization == nullptr) kind = RegularizationKind::NONE;
+    else if (regularization == &RegularizationFunctions::L1) kind = RegularizationKind::L1;
+    else if (regularization == &RegularizationFunctions::L2) kind = RegularizationKind::L2;
+    else return false;
+    return true;
+}
+
 // ==============================================================================
 // CLASS IMPLEMENTATIONS
 // ==============================================================================
 
-Node::Node(std::string id, const ActivationFunction& activation, bool initZero)
-    : id(std::move(id)), activation(activation) {
+Node::Node(int id, const ActivationFunction& activation, bool initZero, std::string label)
+    : id(id), label(std::move(label)), activation(activation) {
     if (initZero) {
         this->bias = 0;
     }
@@ -92,11 +116,8 @@ double Node::updateOutput() {
     return output;
 }
 
-Link::Link(Node* source, Node* dest, const RegularizationFunction* regularization, bool initZero)
-    : source(source), dest(dest), regularization(regularization) {
-    this->id = source->id + "-" + dest->id;
-    this->weight = initZero ? 0 : randHalf();
-}
+Link::Link(int id, Node* source, Node* dest, const RegularizationFunction* regularization, double weight)
+    : id(id), source(source), dest(dest), weight(weight), regularization(regularization) {}
 
 // ==============================================================================
 // NETWORK FUNCTIONS
@@ -108,10 +129,13 @@ Network buildNetwork(
     const ActivationFunction& outputActivation,
     const RegularizationFunction* regularization,
     const std::vector<std::string>& inputIds,
-    bool initZero) {
+    bool initZero,
+    uint64_t seed) {
 
     int numLayers = networkShape.size();
-    int idCounter = 1;
+    int nodeCounter = 0;
+    uint64_t linkCounter = 0;
+    const rng::Stream weightStream(seed, rng::WEIGHTS);
     Network network;
 
     for (int layerIdx = 0; layerIdx < numLayers; ++layerIdx) {
@@ -123,15 +147,15 @@ Network buildNetwork(
 
         int numNodes = networkShape[layerIdx];
         for (int i = 0; i < numNodes; ++i) {
-            std::string nodeId = isInputLayer ? inputIds[i] : std::to_string(idCounter++);
-
-            Node* node = new Node(nodeId, isOutputLayer ? outputActivation : activation, initZero);
+            Node* node = new Node(nodeCounter++, isOutputLayer ? outputActivation : activation, initZero,
+                                  isInputLayer ? inputIds[i] : std::string());
             network[layerIdx].push_back(node);
 
             if (layerIdx >= 1) {
                 // Add links from nodes in the previous layer to this node.
                 for (Node* prevNode : network[layerIdx - 1]) {
-                    Link* link = new Link(prevNode, node, regularization, initZero);
+                    double weight = initZero ? 0 : randHalf(weightStream, linkCounter);
+                    Link* link = new Link(static_cast<int>(linkCounter++), prevNode, node, regularization, weight);
                     prevNode->outputs.push_back(link);
                     node->inputLinks.push_back(link);
                 }
@@ -142,19 +166,12 @@ Network buildNetwork(
 }
 
 void deleteNetwork(Network& network) {
-    std::set<Link*> allLinks;
+    // Every link is the input link of exactly one node.
     for (const auto& layer : network) {
         for (Node* node : layer) {
             for (Link* link : node->inputLinks) {
-                allLinks.insert(link);
+                delete link;
             }
-        }
-    }
-    for (Link* link : allLinks) {
-        delete link;
-    }
-    for (const auto& layer : network) {
-        for (Node* node : layer) {
             delete node;
         }
     }
@@ -179,6 +196,80 @@ double forwardProp(Network& network, const std::vector<double>& inputs) {
     return network.back()[0]->output;
 }
 
+// The kind of a node's copy of one of the Activations constants, told apart
+// by the type of its output lambda; false for any other function.
+static bool copiedActivationKind(const ActivationFunction& activation, ActivationKind& kind) {
+    const ActivationFunction* constants[] = {&Activations::TANH, &Activations::RELU, &Activations::SIGMOID,
+                                             &Activations::LINEAR, &Activations::FAST_TANH,
+                                             &Activations::FAST_SIGMOID};
+    for (const ActivationFunction* constant : constants) {
+        if (activation.output.target_type() == constant->output.target_type()) {
+            return activationKindOf(constant, kind);
+        }
+    }
+    return false;
+}
+
+void forwardPropBatch(const Network& network, const float* inputs, size_t count, size_t stride, float* outputs,
+                      float* hiddenActivations) {
+    const auto& inputLayer = network[0];
+    if (stride < inputLayer.size()) {
+        throw std::runtime_error("The stride must be at least the number of input nodes");
+    }
+    // Blocks of examples go through the layers together, node by node, so
+    // the loops over the block vectorize. values[id * BLOCK + row] is node
+    // id's output for a row of the block.
+    const size_t BLOCK = 64;
+    size_t numNodes = 0;
+    for (const auto& layer : network) numNodes += layer.size();
+    size_t numHidden = numNodes - inputLayer.size() - network.back().size();
+    std::vector<double> values(numNodes * BLOCK);
+    std::vector<ActivationKind> kinds(numNodes);
+    std::vector<char> known(numNodes);
+    for (size_t l = 1; l < network.size(); ++l) {
+        for (const Node* node : network[l]) known[node->id] = copiedActivationKind(node->activation, kinds[node->id]);
+    }
+
+    for (size_t first = 0; first < count; first += BLOCK) {
+        size_t rows = std::min(BLOCK, count - first);
+        const float* in = inputs + first * stride;
+        for (size_t k = 0; k < inputLayer.size(); ++k) {
+            double* value = &values[inputLayer[k]->id * BLOCK];
+            for (size_t row = 0; row < rows; ++row) value[row] = in[row * stride + k];
+        }
+        // Node::updateOutput for every row: the bias, then the links in order.
+        for (size_t l = 1; l < network.size(); ++l) {
+            for (const Node* node : network[l]) {
+                double* total = &values[node->id * BLOCK];
+                std::fill_n(total, rows, node->bias);
+                for (const Link* link : node->inputLinks) {
+                    const double* source = &values[link->source->id * BLOCK];
+                    double weight = link->weight;
+                    for (size_t row = 0; row < rows; ++row) total[row] += weight * source[row];
+                }
+                if (known[node->id]) {
+                    activate(kinds[node->id], total, total, rows);
+                } else {
+                    for (size_t row = 0; row < rows; ++row) total[row] = node->activation.output(total[row]);
+                }
+            }
+        }
+        const double* output = &values[network.back()[0]->id * BLOCK];
+        for (size_t row = 0; row < rows; ++row) outputs[first + row] = static_cast<float>(output[row]);
+        if (hiddenActivations) {
+            float* hidden = hiddenActivations + first * numHidden;
+            size_t h = 0;
+            for (size_t l = 1; l + 1 < network.size(); ++l) {
+                for (const Node* node : network[l]) {
+                    const double* value = &values[node->id * BLOCK];
+                    for (size_t row = 0; row < rows; ++row) hidden[row * numHidden + h] = static_cast<float>(value[row]);
+                    ++h;
+                }
+            }
+        }
+    }
+}
+
 void backProp(Network& network, double target, const ErrorFunction& errorFunc) {
     Node* outputNode = network.back()[0];
     outputNode->outputDer = errorFunc.der(outputNode->output, target);
@@ -206,17 +297,36 @@ void backProp(Network& network, double target, const ErrorFunction& errorFunc) {
 
         if (layerIdx == 1) continue;
 
-        // Compute output derivatives for the previous layer.
-        auto& prevLayer = network[layerIdx - 1];
-        for (Node* node : prevLayer) {
+        // Compute output derivatives for the previous layer. Walking the
+        // input links of this layer is the transpose of the forward pass, and
+        // reads each node's links contiguously instead of hopping from every
+        // output link to its destination. Every sum still runs over the
+        // destination nodes in order.
+        for (Node* node : network[layerIdx - 1]) {
             node->outputDer = 0;
-            for (Link* outputLink : node->outputs) {
-                node->outputDer += outputLink->weight * outputLink->dest->inputDer;
+        }
+        for (Node* node : currentLayer) {
+            for (Link* link : node->inputLinks) {
+                link->source->outputDer += link->weight * node->inputDer;
             }
         }
     }
 }
 
+// Applies the regularization step to a link after its gradient step.
+static void regularize(Link* link, double learningRate, double regularizationRate) {
+    double regulDer = link->regularization ? link->regularization->der(link->weight) : 0;
+    double newLinkWeight = link->weight - (learningRate * regularizationRate) * regulDer;
+
+    if (link->regularization == &RegularizationFunctions::L1 && link->weight * newLinkWeight < 0) {
+        // The weight crossed 0 due to L1 regularization. Set it to 0.
+        link->weight = 0;
+        link->isDead = true;
+    } else {
+        link->weight = newLinkWeight;
+    }
+}
+
 void updateWeights(Network& network, double learningRate, double regularizationRate) {
     for (size_t layerIdx = 1; layerIdx < network.size(); ++layerIdx) {
         for (Node* node : network[layerIdx]) {
@@ -235,16 +345,7 @@ void updateWeights(Network& network, double learningRate, double regularizationR
                     link->weight -= (learningRate / link->numAccumulatedDers) * link->accErrorDer;
 
                     // Further update the weight based on regularization.
-                    double regulDer = link->regularization ? link->regularization->der(link->weight) : 0;
-                    double newLinkWeight = link->weight - (learningRate * regularizationRate) * regulDer;
-
-                    if (link->regularization == &RegularizationFunctions::L1 && link->weight * newLinkWeight < 0) {
-                        // The weight crossed 0 due to L1 regularization. Set it to 0.
-                        link->weight = 0;
-                        link->isDead = true;
-                    } else {
-                        link->weight = newLinkWeight;
-                    }
+                    regularize(link, learningRate, regularizationRate);
 
                     link->accErrorDer = 0;
                     link->numAccumulatedDers = 0;
@@ -254,7 +355,37 @@ void updateWeights(Network& network, double learningRate, double regularizationR
     }
 }
 
-void forEachNode(Network& network, bool ignoreInputs, std::function<void(Node*)> accessor) {
+void updateWeights(Network& network, double learningRate, double regularizationRate, Optimizer& optimizer) {
+    if (optimizer.kind == OptimizerKind::SGD) {
+        updateWeights(network, learningRate, regularizationRate);
+        return;
+    }
+    if (getOutputNode(network)->numAccumulatedDers == 0) {
+        return;
+    }
+    optimizer.beginUpdate();
+    const size_t biasOffset = optimizer.numLinks();
+    for (size_t layerIdx = 1; layerIdx < network.size(); ++layerIdx) {
+        for (Node* node : network[layerIdx]) {
+            if (node->numAccumulatedDers > 0) {
+                double grad = node->accInputDer / node->numAccumulatedDers;
+                node->bias -= optimizer.delta(biasOffset + node->id, grad, learningRate);
+                node->accInputDer = 0;
+                node->numAccumulatedDers = 0;
+            }
+            for (Link* link : node->inputLinks) {
+                if (link->isDead || link->numAccumulatedDers == 0) continue;
+                double grad = link->accErrorDer / link->numAccumulatedDers;
+                link->weight -= optimizer.delta(link->id, grad, learningRate);
+                regularize(link, learningRate, regularizationRate);
+                link->accErrorDer = 0;
+                link->numAccumulatedDers = 0;
+            }
+        }
+    }
+}
+
+void forEachNode(Network& network, bool ignoreInputs, const std::function<void(Node*)>& accessor) {
     for (size_t layerIdx = ignoreInputs ? 1 : 0; layerIdx < network.size(); ++layerIdx) {
         for (Node* node : network[layerIdx]) {
             accessor(node);
@@ -266,6 +397,239 @@ Node* getOutputNode(Network& network) {
     return network.back()[0];
 }
 
+// ==============================================================================
+// FLAT PARAMETER VIEW
+// ==============================================================================
+
+static size_t countLinks(const Network& network) {
+    size_t links = 0;
+    for (size_t l = 1; l < network.size(); ++l) {
+        links += network[l - 1].size() * network[l].size();
+    }
+    return links;
+}
+
+size_t numParameters(const Network& network) {
+    return countLinks(network) + network.back().back()->id + 1;
+}
+
+void getParameters(const Network& network, double* params) {
+    double* biases = params + countLinks(network);
+    for (const auto& layer : network) {
+        for (const Node* node : layer) {
+            biases[node->id] = node->bias;
+            for (const Link* link : node->inputLinks) {
+                params[link->id] = link->weight;
+            }
+        }
+    }
+}
+
+void setParameters(Network& network, const double* params) {
+    const double* biases = params + countLinks(network);
+    for (auto& layer : network) {
+        for (Node* node : layer) {
+            node->bias = biases[node->id];
+            node->accInputDer = 0;
+            node->numAccumulatedDers = 0;
+            for (Link* link : node->inputLinks) {
+                link->weight = params[link->id];
+                link->accErrorDer = 0;
+                link->numAccumulatedDers = 0;
+            }
+        }
+    }
+}
+
+void collectGradient(Network& network, double* gradient) {
+    double* biases = gradient + countLinks(network);
+    for (auto& layer : network) {
+        for (Node* node : layer) {
+            biases[node->id] = node->numAccumulatedDers > 0 ? node->accInputDer / node->numAccumulatedDers : 0;
+            node->accInputDer = 0;
+            node->numAccumulatedDers = 0;
+            for (Link* link : node->inputLinks) {
+                gradient[link->id] = link->numAccumulatedDers > 0 ? link->accErrorDer / link->numAccumulatedDers : 0;
+                link->accErrorDer = 0;
+                link->numAccumulatedDers = 0;
+            }
+        }
+    }
+}
+
+// ==============================================================================
+// INCREMENTAL EDITS
+// ==============================================================================
+
+// Restores the id order of buildNetwork after an edit.
+static void renumber(Network& network) {
+    int nodeCounter = 0, linkCounter = 0;
+    for (auto& layer : network) {
+        for (Node* node : layer) {
+            node->id = nodeCounter++;
+            for (Link* link : node->inputLinks) {
+                link->id = linkCounter++;
+            }
+        }
+    }
+}
+
+// A link from `source` to `dest` that takes part in dest's pending batch
+// with a zero derivative. The caller puts it into the link lists.
+static Link* newLink(Node* source, Node* dest, const RegularizationFunction* regularization, double weight) {
+    Link* link = new Link(0, source, dest, regularization, weight);
+    link->numAccumulatedDers = dest->numAccumulatedDers;
+    return link;
+}
+
+static void eraseLink(std::vector<Link*>& links, const Link* link) {
+    links.erase(std::find(links.begin(), links.end(), link));
+}
+
+static void checkHiddenLayer(const Network& network, size_t layerIdx) {
+    if (layerIdx == 0 || layerIdx + 1 >= network.size()) {
+        throw std::runtime_error("Layer " + std::to_string(layerIdx) + " is not a hidden layer");
+    }
+}
+
+void addNode(Network& network, size_t layerIdx, uint64_t seed) {
+    checkHiddenLayer(network, layerIdx);
+    auto& layer = network[layerIdx];
+    if (layer.empty()) {
+        throw std::runtime_error("An empty layer has no node to split");
+    }
+    const rng::Stream stream(seed, rng::EDITS);
+    Node* original = layer[stream.below(layer.size(), layer.size())];
+
+    Node* node = new Node(0, original->activation, false, original->label);
+    node->bias = original->bias;
+    node->numAccumulatedDers = original->numAccumulatedDers;
+    for (Link* in : original->inputLinks) {
+        Link* link = newLink(in->source, node, in->regularization, in->weight);
+        link->isDead = in->isDead;
+        in->source->outputs.push_back(link);
+        node->inputLinks.push_back(link);
+    }
+    // The split node's share of every outgoing weight moves to the new node;
+    // unequal shares let the two nodes train apart.
+    for (size_t i = 0; i < original->outputs.size(); ++i) {
+        Link* out = original->outputs[i];
+        double share = stream.uniform(0.25, 0.75, layer.size(), static_cast<uint32_t>(i + 1));
+        Link* link = newLink(node, out->dest, out->regularization, out->weight * share);
+        link->isDead = out->isDead;
+        out->weight -= link->weight;
+        node->outputs.push_back(link);
+        out->dest->inputLinks.push_back(link);
+    }
+    layer.push_back(node);
+    renumber(network);
+}
+
+void addInput(Network& network, size_t index, const std::string& label, const RegularizationFunction* regularization) {
+    auto& inputs = network[0];
+    index = std::min(index, inputs.size());
+    Node* node = new Node(0, inputs.empty() ? network[1][0]->activation : inputs[0]->activation, false, label);
+    for (Node* dest : network[1]) {
+        Link* link = newLink(node, dest, regularization, 0);
+        node->outputs.push_back(link);
+        dest->inputLinks.insert(dest->inputLinks.begin() + index, link);
+    }
+    inputs.insert(inputs.begin() + index, node);
+    renumber(network);
+}
+
+void removeNode(Network& network, size_t layerIdx, size_t index) {
+    if (layerIdx + 1 >= network.size()) {
+        throw std::runtime_error("The output node cannot be removed");
+    }
+    auto& layer = network[layerIdx];
+    Node* node = layer.at(index);
+    for (Link* in : node->inputLinks) {
+        eraseLink(in->source->outputs, in);
+        delete in;
+    }
+    for (Link* out : node->outputs) {
+        eraseLink(out->dest->inputLinks, out);
+        delete out;
+    }
+    delete node;
+    layer.erase(layer.begin() + index);
+    renumber(network);
+}
+
+void insertLayer(Network& network, size_t layerIdx, const ActivationFunction& activation,
+                 const RegularizationFunction* regularization) {
+    if (layerIdx == 0 || layerIdx >= network.size()) {
+        throw std::runtime_error("A hidden layer goes between the input and the output layer");
+    }
+    const auto& prev = network[layerIdx - 1];
+    std::vector<Node*> layer;
+    for (size_t i = 0; i < prev.size(); ++i) {
+        Node* node = new Node(0, activation, true);
+        node->numAccumulatedDers = getOutputNode(network)->numAccumulatedDers;
+        for (size_t j = 0; j < prev.size(); ++j) {
+            Link* link = newLink(prev[j], node, regularization, i == j ? 1.0 : 0.0);
+            prev[j]->outputs.push_back(link);
+            node->inputLinks.push_back(link);
+        }
+        layer.push_back(node);
+    }
+    // The next layer's links move over from the previous layer to the
+    // matching new node.
+    for (Node* dest : network[layerIdx]) {
+        for (size_t j = 0; j < dest->inputLinks.size(); ++j) {
+            Link* link = dest->inputLinks[j];
+            eraseLink(link->source->outputs, link);
+            link->source = layer[j];
+            layer[j]->outputs.push_back(link);
+        }
+    }
+    network.insert(network.begin() + layerIdx, layer);
+    renumber(network);
+}
+
+void removeLayer(Network& network, size_t layerIdx) {
+    checkHiddenLayer(network, layerIdx);
+    const auto& prev = network[layerIdx - 1];
+    const auto& layer = network[layerIdx];
+    for (Node* dest : network[layerIdx + 1]) {
+        std::vector<double> weights(prev.size(), 0.0);
+        const RegularizationFunction* regularization = nullptr;
+        for (Link* out : dest->inputLinks) {
+            Node* node = out->source;
+            dest->bias += out->weight * node->bias;
+            for (size_t i = 0; i < prev.size(); ++i) {
+                weights[i] += out->weight * node->inputLinks[i]->weight;
+            }
+            regularization = out->regularization;
+            delete out;
+        }
+        dest->inputLinks.clear();
+        for (size_t i = 0; i < prev.size(); ++i) {
+            Link* link = newLink(prev[i], dest, regularization, weights[i]);
+            prev[i]->outputs.push_back(link);
+            dest->inputLinks.push_back(link);
+        }
+    }
+    for (Node* node : layer) {
+        for (Link* in : node->inputLinks) {
+            eraseLink(in->source->outputs, in);
+            delete in;
+        }
+        delete node;
+    }
+    network.erase(network.begin() + layerIdx);
+    renumber(network);
+}
+
+void setActivation(Network& network, const ActivationFunction& activation) {
+    for (size_t layerIdx = 1; layerIdx + 1 < network.size(); ++layerIdx) {
+        for (Node* node : network[layerIdx]) {
+            node->activation = activation;
+        }
+    }
+}
+
 std::map<std::string, const RegularizationFunction*> regularizations = {
     {"none", nullptr},
     {"L1", &RegularizationFunctions::L1},
@@ -1,9 +1,11 @@
 #pragma once
 
+#include "optimizer.hpp"
 #include <vector>
 #include <string>
 #include <functional>
 #include <map>
+#include <cstdint>
 
 namespace nn {
 
@@ -33,6 +35,10 @@ struct Activations {
     static const ActivationFunction RELU;
     static const ActivationFunction SIGMOID;
     static const ActivationFunction LINEAR;
+    // TANH and SIGMOID through the approximations of kernel_math.hpp, within
+    // 4e-9 of the exact values; the derivatives reuse the approximation.
+    static const ActivationFunction FAST_TANH;
+    static const ActivationFunction FAST_SIGMOID;
 };
 
 struct RegularizationFunctions {
@@ -45,10 +51,30 @@ struct Errors {
 };
 
 /**
- * A node in a neural network.
+ * The built-in activation and regularization functions as plain enums, for
+ * engines that evaluate them in tight loops instead of through std::function.
+ */
+enum class ActivationKind { TANH, RELU, SIGMOID, LINEAR, FAST_TANH, FAST_SIGMOID };
+enum class RegularizationKind { NONE, L1, L2 };
+
+/**
+ * Sets `kind` to the kind of `activation` and returns true if it is one of the
+ * Activations constants; returns false otherwise.
+ */
+bool activationKindOf(const ActivationFunction* activation, ActivationKind& kind);
+
+/**
+ * Same as activationKindOf for regularizations; nullptr maps to NONE.
+ */
+bool regularizationKindOf(const RegularizationFunction* regularization, RegularizationKind& kind);
+
+/**
+ * A node in a neural network. `id` is the node's index in layer order, so
+ * per-node data can live in plain arrays indexed by it.
  */
 struct Node {
-    std::string id;
+    int id;
+    std::string label; // The input name for input nodes, empty otherwise.
     std::vector<Link*> inputLinks;
     std::vector<Link*> outputs;
     double bias = 0.1;
@@ -60,15 +86,16 @@ struct Node {
     int numAccumulatedDers = 0;
     ActivationFunction activation;
 
-    Node(std::string id, const ActivationFunction& activation, bool initZero = false);
+    Node(int id, const ActivationFunction& activation, bool initZero = false, std::string label = {});
     double updateOutput();
 };
 
 /**
- * A link in a neural network.
+ * A link in a neural network. `id` is the link's index in the order of
+ * buildNetwork: layer by layer, destination node by destination node.
  */
 struct Link {
-    std::string id;
+    int id;
     Node* source;
     Node* dest;
     double weight;
@@ -78,7 +105,7 @@ struct Link {
     int numAccumulatedDers = 0;
     const RegularizationFunction* regularization;
 
-    Link(Node* source, Node* dest, const RegularizationFunction* regularization, bool initZero = false);
+    Link(int id, Node* source, Node* dest, const RegularizationFunction* regularization, double weight = 0);
 };
 
 // Type alias for the network structure
@@ -87,7 +114,9 @@ using Network = std::vector<std::vector<Node*>>;
 // --- Core Network Functions ---
 
 /**
- * Builds a neural network.
+ * Builds a neural network. Link weights are drawn from the counter-based
+ * stream for `seed`, so the same seed always yields the same network.
+ * `inputIds` name the input nodes and become their labels.
  * IMPORTANT: The returned network must be freed using `deleteNetwork` to avoid memory leaks.
  */
 Network buildNetwork(
@@ -96,7 +125,8 @@ Network buildNetwork(
     const ActivationFunction& outputActivation,
     const RegularizationFunction* regularization,
     const std::vector<std::string>& inputIds,
-    bool initZero = false
+    bool initZero = false,
+    uint64_t seed = 0
 );
 
 /**
@@ -109,6 +139,20 @@ void deleteNetwork(Network& network);
  */
 double forwardProp(Network& network, const std::vector<double>& inputs);
 
+/**
+ * Runs `count` examples forward without touching the network, so any number
+ * of threads can score against one network at once (as long as none of
+ * them edits or trains it). Example i is read from `inputs + i * stride`,
+ * one value per input node, and its output is written to `outputs[i]`.
+ * Unless `hiddenActivations` is null, it receives the outputs of the hidden
+ * nodes: for each example, one value per hidden node in node id order.
+ *
+ * The arithmetic is forwardProp's, in double, so the outputs are the ones
+ * forwardProp returns rounded to float. The scratch space is per call.
+ */
+void forwardPropBatch(const Network& network, const float* inputs, size_t count, size_t stride, float* outputs,
+                      float* hiddenActivations = nullptr);
+
 /**
  * Runs a backward propagation using the provided target.
  */
@@ -119,19 +163,90 @@ void backProp(Network& network, double target, const ErrorFunction& errorFunc);
  */
 void updateWeights(Network& network, double learningRate, double regularizationRate);
 
+/**
+ * Same with the update rule of `optimizer`, whose state must be sized for the
+ * network (Optimizer::reset). SGD is exactly the overload above.
+ */
+void updateWeights(Network& network, double learningRate, double regularizationRate, Optimizer& optimizer);
+
 
 // --- Utility Functions ---
 
 /**
  * Iterates over every node in the network.
  */
-void forEachNode(Network& network, bool ignoreInputs, std::function<void(Node*)> accessor);
+void forEachNode(Network& network, bool ignoreInputs, const std::function<void(Node*)>& accessor);
 
 /**
  * Returns the output node in the network.
  */
 Node* getOutputNode(Network& network);
 
+// --- Flat Parameter View ---
+// The weights by link id, then the biases at numLinks + node id: the layout
+// of Optimizer's state. Input nodes have a bias slot that is never used.
+
+size_t numParameters(const Network& network);
+void getParameters(const Network& network, double* params);
+// Also clears the accumulated derivatives.
+void setParameters(Network& network, const double* params);
+
+/**
+ * Writes the accumulated derivatives, averaged over the examples that
+ * backProp accumulated, in the same layout and clears them. Dead links and
+ * input biases get 0.
+ */
+void collectGradient(Network& network, double* gradient);
+
+// --- Incremental Edits ---
+// These change the architecture of a trained network in place: only the
+// edited layer and the links touching it are reallocated. Node and link ids
+// are renumbered afterwards, so they stay dense. New links join the pending
+// batch of their destination node with a zero derivative.
+
+/**
+ * Adds a node at the end of hidden layer `layerIdx` by splitting one of its
+ * nodes (Net2WiderNet): the new node copies the bias and incoming weights of
+ * a node drawn from `seed`, and the two share that node's outgoing weights at
+ * a random ratio, so the network computes the same function. Throws
+ * std::runtime_error if the layer is not a non-empty hidden layer.
+ */
+void addNode(Network& network, size_t layerIdx, uint64_t seed);
+
+/**
+ * Adds an input node labeled `label` at position `index` of the input layer.
+ * Its outgoing weights start at zero, so the function is unchanged.
+ */
+void addInput(Network& network, size_t index, const std::string& label, const RegularizationFunction* regularization);
+
+/**
+ * Removes node `index` of an input or hidden layer along with its links.
+ * Throws std::runtime_error for the output node.
+ */
+void removeNode(Network& network, size_t layerIdx, size_t index);
+
+/**
+ * Inserts a hidden layer at `layerIdx` that passes the previous layer through
+ * (Net2DeeperNet): one node per previous node, linked to it with weight 1 and
+ * to the others with weight 0, and zero biases. The function is unchanged if
+ * `activation` is the identity on the previous layer's outputs (LINEAR, or
+ * RELU after a RELU layer); otherwise the outputs are squashed once more.
+ */
+void insertLayer(Network& network, size_t layerIdx, const ActivationFunction& activation,
+                 const RegularizationFunction* regularization);
+
+/**
+ * Removes hidden layer `layerIdx` and links its neighbours with the product
+ * of its incoming and outgoing weights; the biases fold into the next layer.
+ * The function is unchanged if the removed layer was linear.
+ */
+void removeLayer(Network& network, size_t layerIdx);
+
+/**
+ * Sets the activation of every hidden node; weights are kept.
+ */
+void setActivation(Network& network, const ActivationFunction& activation);
+
 /**
  * A map to retrieve regularization functions by name.
  * "none" maps to nullptr.
@@ -0,0 +1,273 @@
+#include "nnplayground.h"
+#include "checkpoint.hpp"
+#include "kernels.hpp"
+#include "session.hpp"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+struct nnp_network {
+    nn::Network network;
+    // Null for shapes with an empty layer, which train on the graph.
+    std::unique_ptr<nn::Kernel> kernel;
+    const nn::RegularizationFunction* regularization = nullptr;
+    std::vector<std::string> inputIds;
+    std::map<std::string, std::string> metadata;
+    uint64_t iteration = 0;
+    // Set when the kernel has trained past the graph's weights.
+    bool graphStale = false;
+    // Scratch for the outputs of a minibatch and for one graph input row.
+    std::vector<double> outputs;
+    std::vector<double> row;
+
+    ~nnp_network() { nn::deleteNetwork(network); }
+};
+
+namespace {
+
+thread_local std::string lastError;
+
+struct ActivationEntry {
+    nnp_activation value;
+    const nn::ActivationFunction* function;
+    const char* key; // The playground's setting, without fastActivations.
+};
+
+const ActivationEntry ACTIVATIONS[] = {
+    {NNP_TANH, &nn::Activations::TANH, "tanh"},
+    {NNP_RELU, &nn::Activations::RELU, "relu"},
+    {NNP_SIGMOID, &nn::Activations::SIGMOID, "sigmoid"},
+    {NNP_LINEAR, &nn::Activations::LINEAR, "linear"},
+    {NNP_FAST_TANH, &nn::Activations::FAST_TANH, "tanh"},
+    {NNP_FAST_SIGMOID, &nn::Activations::FAST_SIGMOID, "sigmoid"},
+};
+
+const ActivationEntry& activationEntry(nnp_activation value) {
+    for (const ActivationEntry& entry : ACTIVATIONS) {
+        if (entry.value == value) return entry;
+    }
+    throw std::runtime_error("Unknown activation " + std::to_string(value));
+}
+
+const nn::RegularizationFunction* regularizationFunction(nnp_regularization value) {
+    switch (value) {
+        case NNP_REGULARIZATION_NONE: return nullptr;
+        case NNP_REGULARIZATION_L1: return &nn::RegularizationFunctions::L1;
+        case NNP_REGULARIZATION_L2: return &nn::RegularizationFunctions::L2;
+    }
+    throw std::runtime_error("Unknown regularization " + std::to_string(value));
+}
+
+// Runs `body`, turning an exception into -1 and the thread's last error.
+template <typename Body>
+int guarded(Body&& body) {
+    try {
+        body();
+        return 0;
+    } catch (const std::exception& e) {
+        lastError = e.what();
+        return -1;
+    }
+}
+
+void require(const void* pointer, const char* what) {
+    if (!pointer) throw std::runtime_error(std::string(what) + " is NULL");
+}
+
+std::vector<int> shapeOf(const nn::Network& network) {
+    std::vector<int> shape;
+    for (const auto& layer : network) shape.push_back(static_cast<int>(layer.size()));
+    return shape;
+}
+
+void attachKernel(nnp_network& net, const nn::ActivationFunction& activation,
+                  const nn::ActivationFunction& outputActivation) {
+    nn::ActivationKind activationKind, outputKind;
+    nn::RegularizationKind regularizationKind;
+    nn::activationKindOf(&activation, activationKind);
+    nn::activationKindOf(&outputActivation, outputKind);
+    nn::regularizationKindOf(net.regularization, regularizationKind);
+    net.kernel = nn::makeKernel(shapeOf(net.network), activationKind, outputKind, regularizationKind);
+    if (net.kernel) net.kernel->load(net.network);
+}
+
+void syncGraph(nnp_network& net) {
+    if (net.graphStale) net.kernel->store(net.network);
+    net.graphStale = false;
+}
+
+void predictRows(nnp_network& net, const double* inputs, size_t count, double* outputs) {
+    if (net.kernel) {
+        net.kernel->predict(inputs, count, outputs);
+        return;
+    }
+    size_t width = net.network[0].size();
+    for (size_t i = 0; i < count; ++i) {
+        net.row.assign(inputs + i * width, inputs + (i + 1) * width);
+        outputs[i] = nn::forwardProp(net.network, net.row);
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+int nnp_api_version(void) {
+    return NNP_API_VERSION;
+}
+
+const char* nnp_last_error(void) {
+    return lastError.c_str();
+}
+
+nnp_network* nnp_create(const int* shape, size_t num_layers, nnp_activation activation,
+                        nnp_activation output_activation, nnp_regularization regularization, uint64_t seed) {
+    std::unique_ptr<nnp_network> net;
+    int status = guarded([&] {
+        require(shape, "shape");
+        if (num_layers < 2 || shape[0] < 1 || shape[num_layers - 1] != 1) {
+            throw std::runtime_error("A network needs at least one input and exactly one output");
+        }
+        const ActivationEntry& hidden = activationEntry(activation);
+        const ActivationEntry& output = activationEntry(output_activation);
+        net = std::make_unique<nnp_network>();
+        net->regularization = regularizationFunction(regularization);
+        for (int i = 0; i < shape[0]; ++i) net->inputIds.push_back("x" + std::to_string(i + 1));
+        std::vector<int> layers(shape, shape + num_layers);
+        for (int width : layers) {
+            if (width < 0) throw std::runtime_error("Layer widths must not be negative");
+        }
+        net->network = nn::buildNetwork(layers, *hidden.function, *output.function, net->regularization,
+                                        net->inputIds, false, seed);
+
+        std::string hiddenLayers;
+        for (size_t l = 1; l + 1 < num_layers; ++l) {
+            hiddenLayers += (l > 1 ? "," : "") + std::to_string(shape[l]);
+        }
+        net->metadata = {
+            {"activation", hidden.key},
+            {"fastActivations", hidden.value == NNP_FAST_TANH || hidden.value == NNP_FAST_SIGMOID ? "1" : "0"},
+            {"problem", output.value == NNP_LINEAR ? "regression" : "classification"},
+            {"regularization", getKeyFromValue(regularizations, net->regularization)},
+            {"networkShape", hiddenLayers},
+        };
+        attachKernel(*net, *hidden.function, *output.function);
+    });
+    return status == 0 ? net.release() : nullptr;
+}
+
+nnp_network* nnp_load_checkpoint(const char* path) {
+    std::unique_ptr<nnp_network> net;
+    int status = guarded([&] {
+        require(path, "path");
+        nn::MappedCheckpoint checkpoint(path);
+        // Only the settings that decide the functions; the rest describe
+        // the playground's data and training, which are the caller's.
+        std::map<std::string, std::string> settings;
+        for (const char* key : {"activation", "fastActivations", "problem", "regularization"}) {
+            auto it = checkpoint.metadata().find(key);
+            if (it != checkpoint.metadata().end()) settings[key] = it->second;
+        }
+        Session session;
+        session.state = applySettings(session.state, settings);
+
+        net = std::make_unique<nnp_network>();
+        net->regularization = session.state.regularization;
+        net->inputIds = checkpoint.inputIds();
+        net->metadata = checkpoint.metadata();
+        net->iteration = checkpoint.iteration();
+        net->network = nn::restoreNetwork(checkpoint, session.hiddenActivation(), session.outputActivation(),
+                                          net->regularization);
+        attachKernel(*net, session.hiddenActivation(), session.outputActivation());
+    });
+    return status == 0 ? net.release() : nullptr;
+}
+
+int nnp_save_checkpoint(nnp_network* network, const char* path) {
+    return guarded([&] {
+        require(network, "network");
+        require(path, "path");
+        syncGraph(*network);
+        nn::saveCheckpoint(path, network->network, network->iteration, network->metadata);
+    });
+}
+
+void nnp_destroy(nnp_network* network) {
+    delete network;
+}
+
+size_t nnp_num_inputs(const nnp_network* network) {
+    return network ? network->network[0].size() : 0;
+}
+
+size_t nnp_num_parameters(const nnp_network* network) {
+    return network ? nn::numParameters(network->network) : 0;
+}
+
+int nnp_predict(nnp_network* network, const double* inputs, size_t count, double* outputs) {
+    return guarded([&] {
+        require(network, "network");
+        if (count == 0) return;
+        require(inputs, "inputs");
+        require(outputs, "outputs");
+        predictRows(*network, inputs, count, outputs);
+    });
+}
+
+int nnp_train(nnp_network* network, const double* inputs, const double* targets, size_t count,
+              size_t batch_size, double learning_rate, double regularization_rate, double* loss) {
+    return guarded([&] {
+        require(network, "network");
+        if (batch_size == 0) throw std::runtime_error("batch_size must be at least 1");
+        if (count > 0) {
+            require(inputs, "inputs");
+            require(targets, "targets");
+        }
+        nnp_network& net = *network;
+        size_t width = net.network[0].size();
+        double total = 0;
+        for (size_t first = 0; first < count; first += batch_size) {
+            size_t rows = std::min(batch_size, count - first);
+            const double* in = inputs + first * width;
+            const double* target = targets + first;
+            if (net.outputs.size() < rows) net.outputs.resize(rows);
+            if (net.kernel) {
+                net.kernel->train(in, target, rows, net.outputs.data());
+                net.kernel->update(learning_rate, regularization_rate);
+                net.graphStale = true;
+            } else {
+                for (size_t i = 0; i < rows; ++i) {
+                    net.row.assign(in + i * width, in + (i + 1) * width);
+                    net.outputs[i] = nn::forwardProp(net.network, net.row);
+                    nn::backProp(net.network, target[i], nn::Errors::SQUARE);
+                }
+                nn::updateWeights(net.network, learning_rate, regularization_rate);
+            }
+            for (size_t i = 0; i < rows; ++i) total += nn::Errors::SQUARE.error(net.outputs[i], target[i]);
+        }
+        net.iteration++;
+        if (loss) *loss = count > 0 ? total / count : 0.0;
+    });
+}
+
+int nnp_get_parameters(nnp_network* network, double* parameters) {
+    return guarded([&] {
+        require(network, "network");
+        require(parameters, "parameters");
+        syncGraph(*network);
+        nn::getParameters(network->network, parameters);
+    });
+}
+
+int nnp_set_parameters(nnp_network* network, const double* parameters) {
+    return guarded([&] {
+        require(network, "network");
+        require(parameters, "parameters");
+        syncGraph(*network);
+        nn::setParameters(network->network, parameters);
+        if (network->kernel) network->kernel->load(network->network);
+    });
+}
+
+} // extern "C"
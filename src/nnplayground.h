@@ -0,0 +1,118 @@
+#ifndef NNPLAYGROUND_H
+#define NNPLAYGROUND_H
+
+/*
+ * C API of the playground's network engine, for embedding it in other
+ * programs. A network is an opaque handle; it is trained on the same
+ * kernels as the playground and reads and writes the same checkpoints.
+ *
+ * Batch functions take caller-owned row-major buffers and work on them in
+ * place, without copies. Functions that can fail return 0 on success and
+ * -1 on failure (NULL for constructors); nnp_last_error() then describes
+ * the failure. Handles are not thread-safe, but distinct handles can be
+ * used from different threads.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(NNPLAYGROUND_SHARED)
+#  ifdef NNPLAYGROUND_BUILDING
+#    define NNP_API __declspec(dllexport)
+#  else
+#    define NNP_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define NNP_API __attribute__((visibility("default")))
+#else
+#  define NNP_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Incremented when a function is removed or changes meaning. */
+#define NNP_API_VERSION 1
+
+typedef struct nnp_network nnp_network;
+
+typedef enum {
+    NNP_TANH = 0,
+    NNP_RELU = 1,
+    NNP_SIGMOID = 2,
+    NNP_LINEAR = 3,
+    NNP_FAST_TANH = 4,
+    NNP_FAST_SIGMOID = 5
+} nnp_activation;
+
+typedef enum {
+    NNP_REGULARIZATION_NONE = 0,
+    NNP_REGULARIZATION_L1 = 1,
+    NNP_REGULARIZATION_L2 = 2
+} nnp_regularization;
+
+/* NNP_API_VERSION of the library, to check against the header. */
+NNP_API int nnp_api_version(void);
+
+/* Message of the last failure on this thread; empty if there was none. */
+NNP_API const char* nnp_last_error(void);
+
+/*
+ * Creates a fully connected network. shape[0] is the number of inputs and
+ * shape[num_layers - 1] must be 1. The weights are initialized as the
+ * playground does for `seed`.
+ */
+NNP_API nnp_network* nnp_create(const int* shape, size_t num_layers, nnp_activation activation,
+                                nnp_activation output_activation, nnp_regularization regularization,
+                                uint64_t seed);
+
+/*
+ * Loads a checkpoint written by the playground, playground_cli or
+ * nnp_save_checkpoint. The activations and the regularization come from the
+ * settings stored in it.
+ */
+NNP_API nnp_network* nnp_load_checkpoint(const char* path);
+
+/*
+ * Writes the network in the checkpoint format. A loaded network keeps the
+ * input names and settings of its checkpoint, so the playground can resume
+ * it; a created one stores its activations and shape.
+ */
+NNP_API int nnp_save_checkpoint(nnp_network* network, const char* path);
+
+/* Frees the network; NULL is ignored. */
+NNP_API void nnp_destroy(nnp_network* network);
+
+NNP_API size_t nnp_num_inputs(const nnp_network* network);
+
+/* Number of weights plus biases, the length of a parameter vector. */
+NNP_API size_t nnp_num_parameters(const nnp_network* network);
+
+/*
+ * Writes the outputs for `count` rows of nnp_num_inputs() values in
+ * `inputs` to `outputs`.
+ */
+NNP_API int nnp_predict(nnp_network* network, const double* inputs, size_t count, double* outputs);
+
+/*
+ * Trains one pass over `count` rows: a minibatch of `batch_size` rows at a
+ * time, each followed by one SGD update. Writes the mean square error of
+ * the outputs seen during the pass to `loss` unless it is NULL.
+ */
+NNP_API int nnp_train(nnp_network* network, const double* inputs, const double* targets, size_t count,
+                      size_t batch_size, double learning_rate, double regularization_rate, double* loss);
+
+/*
+ * Copies the weights (by link id) and then the biases (by node id, input
+ * nodes included) to or from `parameters`, which holds
+ * nnp_num_parameters() values.
+ */
+NNP_API int nnp_get_parameters(nnp_network* network, double* parameters);
+NNP_API int nnp_set_parameters(nnp_network* network, const double* parameters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NNPLAYGROUND_H */
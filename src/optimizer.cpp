@@ -0,0 +1,29 @@
+#include "optimizer.hpp"
+
+namespace nn {
+
+void Optimizer::reset(size_t numLinks, size_t numNodes) {
+    links = numLinks;
+    first.assign(numLinks + numNodes, 0.0);
+    second.assign(numLinks + numNodes, 0.0);
+    steps = 0;
+}
+
+void Optimizer::beginUpdate() {
+    steps++;
+    correction1 = 1 / (1 - std::pow(beta1, steps));
+    correction2 = 1 / (1 - std::pow(beta2, steps));
+}
+
+double Optimizer::delta(size_t i, double grad, double learningRate) {
+    switch (kind) {
+    case OptimizerKind::SGD: return delta<OptimizerKind::SGD>(i, grad, learningRate);
+    case OptimizerKind::MOMENTUM: return delta<OptimizerKind::MOMENTUM>(i, grad, learningRate);
+    case OptimizerKind::NESTEROV: return delta<OptimizerKind::NESTEROV>(i, grad, learningRate);
+    case OptimizerKind::RMSPROP: return delta<OptimizerKind::RMSPROP>(i, grad, learningRate);
+    case OptimizerKind::ADAM: return delta<OptimizerKind::ADAM>(i, grad, learningRate);
+    }
+    return 0;
+}
+
+} // namespace nn
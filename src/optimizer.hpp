@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace nn {
+
+/**
+ * Update rules for the accumulated derivatives. SGD is the plain averaged
+ * step of updateWeights; the others keep per-parameter state.
+ */
+enum class OptimizerKind { SGD, MOMENTUM, NESTEROV, RMSPROP, ADAM };
+
+/**
+ * An update rule and its state. The state is two flat arrays with one entry
+ * per parameter: first the weights by link id, then the biases at
+ * numLinks + node id. The graph engine and the kernels lay out their
+ * parameters the same way, so either can continue from the other's state.
+ */
+class Optimizer {
+public:
+    explicit Optimizer(OptimizerKind kind = OptimizerKind::SGD) : kind(kind) {}
+
+    OptimizerKind kind;
+    double momentum = 0.9; // MOMENTUM and NESTEROV
+    double decay = 0.9;    // RMSPROP's average of squared gradients
+    double beta1 = 0.9;    // ADAM
+    double beta2 = 0.999;  // ADAM
+    double epsilon = 1e-8;
+
+    /**
+     * Zeroes the state for a network with `numLinks` links and `numNodes`
+     * nodes.
+     */
+    void reset(size_t numLinks, size_t numNodes);
+
+    // Offset of the bias state.
+    size_t numLinks() const { return links; }
+
+    /**
+     * Advances the step count; call once per update, before delta().
+     */
+    void beginUpdate();
+
+    /**
+     * Returns the amount to subtract from parameter `i` whose batch-averaged
+     * derivative is `grad`, and advances the parameter's state.
+     */
+    template <OptimizerKind K>
+    double delta(size_t i, double grad, double learningRate) {
+        if constexpr (K == OptimizerKind::SGD) {
+            return learningRate * grad;
+        } else if constexpr (K == OptimizerKind::MOMENTUM) {
+            first[i] = momentum * first[i] + grad;
+            return learningRate * first[i];
+        } else if constexpr (K == OptimizerKind::NESTEROV) {
+            first[i] = momentum * first[i] + grad;
+            return learningRate * (grad + momentum * first[i]);
+        } else if constexpr (K == OptimizerKind::RMSPROP) {
+            second[i] = decay * second[i] + (1 - decay) * grad * grad;
+            return learningRate * grad / (std::sqrt(second[i]) + epsilon);
+        } else {
+            first[i] = beta1 * first[i] + (1 - beta1) * grad;
+            second[i] = beta2 * second[i] + (1 - beta2) * grad * grad;
+            return learningRate * (first[i] * correction1) / (std::sqrt(second[i] * correction2) + epsilon);
+        }
+    }
+
+    // Same as delta<K> with the kind chosen at runtime.
+    double delta(size_t i, double grad, double learningRate);
+
+private:
+    std::vector<double> first, second; // Velocity or first moment; second moment.
+    size_t links = 0;
+    int steps = 0;
+    // ADAM's bias corrections 1 / (1 - beta^steps).
+    double correction1 = 1, correction2 = 1;
+};
+
+} // namespace nn
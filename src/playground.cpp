@@ -6,53 +6,8 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
-
-
-// Initialize static maps from state.hpp
-std::map<std::string, nn::ActivationFunction> activations = {
-    {"relu", nn::Activations::RELU},
-    {"tanh", nn::Activations::TANH},
-    {"sigmoid", nn::Activations::SIGMOID},
-    {"linear", nn::Activations::LINEAR}
-};
-std::map<std::string, const nn::RegularizationFunction*> regularizations = {
-    {"none", nullptr},
-    {"L1", &nn::RegularizationFunctions::L1},
-    {"L2", &nn::RegularizationFunctions::L2}
-};
-std::map<std::string, playground::DataGenerator> datasets = {
-    {"circle", playground::classifyCircleData},
-    {"xor", playground::classifyXORData},
-    {"gauss", playground::classifyTwoGaussData},
-    {"spiral", playground::classifySpiralData},
-    {"star", playground::classifyStarData},
-    {"sine", playground::classifySineData},
-    {"checkerboard", playground::classifyCheckerboardData},
-    {"moons", playground::classifyMoonsData},
-    {"heart", playground::classifyHeartData},
-};
-std::map<std::string, playground::DataGenerator> regDatasets = {
-    {"reg-plane", playground::regressPlane},
-    {"reg-gauss", playground::regressGaussian}
-};
-std::map<std::string, Problem> problems = {
-    {"classification", Problem::CLASSIFICATION},
-    {"regression", Problem::REGRESSION}
-};
-
-// --- Feature Definitions ---
-struct InputFeature {
-    std::function<double(double, double)> f;
-    std::string label;
-};
-std::map<std::string, InputFeature> INPUTS = {
-    {"x", {[](double x, double y) { return x; }, "X_1"}},
-    {"y", {[](double x, double y) { return y; }, "X_2"}},
-    {"xSquared", {[](double x, double y) { return x * x; }, "X_1^2"}},
-    {"ySquared", {[](double x, double y) { return y * y; }, "X_2^2"}},
-    {"xTimesY", {[](double x, double y) { return x * y; }, "X_1X_2"}},
-    {"sinX", {[](double x, double y) { return std::sin(x); }, "sin(X_1)"}},
-};
+#include <cmath>
+#include <cstdio>
 
 // --- PlaygroundApp Implementation ---
 
@@ -60,12 +15,24 @@ PlaygroundApp::PlaygroundApp() : mainHeatMap(DENSITY, xDomain, yDomain) {
     reset(true);
 }
 
-PlaygroundApp::~PlaygroundApp() {
-    if (!network.empty()) {
-        nn::deleteNetwork(network);
-    }
+void PlaygroundApp::loadDatasetFile(const std::string& path) {
+    session.loadDatasetFile(path);
 }
 
+void PlaygroundApp::saveCheckpoint(const std::string& path) {
+    session.saveCheckpoint(path);
+}
+
+void PlaygroundApp::loadCheckpoint(const std::string& path) {
+    isPlaying = false;
+    try {
+        session.loadCheckpoint(path);
+    } catch (const std::exception&) {
+        onSessionReset();
+        throw;
+    }
+    onSessionReset();
+}
 
 void PlaygroundApp::runFrame() {
     if (isPlaying) {
@@ -102,7 +69,44 @@ void PlaygroundApp::drawControls() {
     ImGui::SameLine();
     if (ImGui::Button("Reset")) { reset(); }
     ImGui::SameLine();
-    ImGui::Text("Epoch: %s", std::to_string(iter).c_str());
+    ImGui::Text("Epoch: %s", std::to_string(session.iteration()).c_str());
+
+    char seedBuffer[32];
+    std::snprintf(seedBuffer, sizeof(seedBuffer), "%s", state.seed.c_str());
+    if (ImGui::InputText("Seed", seedBuffer, sizeof(seedBuffer))) {
+        state.seed = seedBuffer;
+    }
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        parametersChanged = true;
+        reset(true); // Keep the seed that was typed in.
+    }
+
+    char checkpointBuffer[256];
+    std::snprintf(checkpointBuffer, sizeof(checkpointBuffer), "%s", checkpointPath.c_str());
+    if (ImGui::InputText("Checkpoint", checkpointBuffer, sizeof(checkpointBuffer))) {
+        checkpointPath = checkpointBuffer;
+    }
+    if (ImGui::Button("Save")) {
+        try {
+            saveCheckpoint(checkpointPath);
+            checkpointStatus = "Saved epoch " + std::to_string(session.iteration());
+        } catch (const std::exception& e) {
+            checkpointStatus = e.what();
+        }
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Load")) {
+        try {
+            loadCheckpoint(checkpointPath);
+            checkpointStatus = "Resumed at epoch " + std::to_string(session.iteration());
+        } catch (const std::exception& e) {
+            checkpointStatus = e.what();
+        }
+    }
+    if (!checkpointStatus.empty()) {
+        ImGui::SameLine();
+        ImGui::TextWrapped("%s", checkpointStatus.c_str());
+    }
 
     ImGui::Separator();
 
@@ -118,19 +122,27 @@ void PlaygroundApp::drawControls() {
 
         if (state.problem == Problem::CLASSIFICATION) {
             ImGui::Text("Dataset:"); ImGui::SameLine();
-            if (ImGui::Button("Circle")) { state.dataset = playground::classifyCircleData; parametersChanged = true; reset(); } ImGui::SameLine();
-            if (ImGui::Button("XOR")) { state.dataset = playground::classifyXORData; parametersChanged = true; reset(); } ImGui::SameLine();
-            if (ImGui::Button("Gauss")) { state.dataset = playground::classifyTwoGaussData; parametersChanged = true; reset(); } ImGui::SameLine();
-            if (ImGui::Button("Spiral")) { state.dataset = playground::classifySpiralData; parametersChanged = true; reset(); } ImGui::SameLine();
-            if (ImGui::Button("Star")) { state.dataset = playground::classifyStarData; parametersChanged = true; reset(); } ImGui::SameLine();
-            if (ImGui::Button("Sine")) { state.dataset = playground::classifySineData; parametersChanged = true; reset(); } ImGui::SameLine();
-            if (ImGui::Button("Checkerboard")) { state.dataset = playground::classifyCheckerboardData; parametersChanged = true; reset(); } ImGui::SameLine();
-            if (ImGui::Button("Moons")) { state.dataset = playground::classifyMoonsData; parametersChanged = true; reset(); } ImGui::SameLine();
-            if (ImGui::Button("Heart")) { state.dataset = playground::classifyHeartData; parametersChanged = true; reset(); }
+            if (ImGui::Button("Circle")) { session.selectDataset("circle"); parametersChanged = true; reset(); } ImGui::SameLine();
+            if (ImGui::Button("XOR")) { session.selectDataset("xor"); parametersChanged = true; reset(); } ImGui::SameLine();
+            if (ImGui::Button("Gauss")) { session.selectDataset("gauss"); parametersChanged = true; reset(); } ImGui::SameLine();
+            if (ImGui::Button("Spiral")) { session.selectDataset("spiral"); parametersChanged = true; reset(); } ImGui::SameLine();
+            if (ImGui::Button("Star")) { session.selectDataset("star"); parametersChanged = true; reset(); } ImGui::SameLine();
+            if (ImGui::Button("Sine")) { session.selectDataset("sine"); parametersChanged = true; reset(); } ImGui::SameLine();
+            if (ImGui::Button("Checkerboard")) { session.selectDataset("checkerboard"); parametersChanged = true; reset(); } ImGui::SameLine();
+            if (ImGui::Button("Moons")) { session.selectDataset("moons"); parametersChanged = true; reset(); } ImGui::SameLine();
+            if (ImGui::Button("Heart")) { session.selectDataset("heart"); parametersChanged = true; reset(); }
+            for (const auto& name : session.fileDatasets()) {
+                ImGui::SameLine();
+                if (ImGui::Button(name.c_str())) { session.selectDataset(name); parametersChanged = true; reset(); }
+            }
         } else {
             ImGui::Text("Dataset:"); ImGui::SameLine();
-            if (ImGui::Button("Plane")) { state.regDataset = playground::regressPlane; parametersChanged = true; reset(); } ImGui::SameLine();
-            if (ImGui::Button("Gauss")) { state.regDataset = playground::regressGaussian; parametersChanged = true; reset(); }
+            if (ImGui::Button("Plane")) { session.selectDataset("reg-plane"); parametersChanged = true; reset(); } ImGui::SameLine();
+            if (ImGui::Button("Gauss")) { session.selectDataset("reg-gauss"); parametersChanged = true; reset(); }
+            for (const auto& name : session.fileRegDatasets()) {
+                ImGui::SameLine();
+                if (ImGui::Button(name.c_str())) { session.selectDataset(name); parametersChanged = true; reset(); }
+            }
         }
 
         ImGui::SliderInt("Ratio of training data", &state.percTrainData, 10, 90, "%d%%");
@@ -139,12 +151,17 @@ void PlaygroundApp::drawControls() {
             reset();
         }
         ImGui::SliderFloat("Noise", &state.noise, 0.0f, 0.5f, "%.2f");
+        if (ImGui::Checkbox("Stream training data", &state.streaming)) {
+            parametersChanged = true;
+            reset();
+        }
+        ImGui::SliderInt("Shuffle block size", &state.shuffleBlockSize, 0, 256);
         ImGui::SliderInt("Batch size", &state.batchSize, 1, 30);
         if (ImGui::IsItemDeactivatedAfterEdit()) {
             parametersChanged = true;
             reset();
         }
-        ImGui::SliderInt("Number of samples", &state.numSamples, 100, 2000);
+        ImGui::SliderInt("Number of samples", &state.numSamples, 100, 1000000, "%d", ImGuiSliderFlags_Logarithmic);
         if (ImGui::IsItemDeactivatedAfterEdit()) {
             parametersChanged = true;
             reset();
@@ -155,13 +172,25 @@ void PlaygroundApp::drawControls() {
 
     // --- Features Section ---
     if (ImGui::CollapsingHeader("Features", ImGuiTreeNodeFlags_DefaultOpen)) {
-        ImGui::Text("Which features to use:");
-        if (ImGui::Checkbox("X1", &state.x)) { parametersChanged = true; reset(); }
-        if (ImGui::Checkbox("X2", &state.y)) { parametersChanged = true; reset(); }
-        if (ImGui::Checkbox("X1^2", &state.xSquared)) { parametersChanged = true; reset(); }
-        if (ImGui::Checkbox("X2^2", &state.ySquared)) { parametersChanged = true; reset(); }
-        if (ImGui::Checkbox("X1*X2", &state.xTimesY)) { parametersChanged = true; reset(); }
-        if (ImGui::Checkbox("sin(X1)", &state.sinX)) { parametersChanged = true; reset(); }
+        if (session.getData().numFeatures() > 2) {
+            int maxAxis = static_cast<int>(session.getData().numFeatures()) - 1;
+            ImGui::Text("Tabular data: all %zu columns are inputs.", session.getData().numFeatures());
+            bool axesChanged = ImGui::SliderInt("Plot X axis", &state.axisX, 0, maxAxis);
+            axesChanged |= ImGui::SliderInt("Plot Y axis", &state.axisY, 0, maxAxis);
+            if (axesChanged) {
+                updateDomains();
+                updateDecisionBoundary();
+                mainHeatMap.updateBackground(boundary[nn::getOutputNode(session.getNetwork())->id], state.discretize);
+            }
+        } else {
+            ImGui::Text("Which features to use:");
+            if (ImGui::Checkbox("X1", &state.x)) { session.setInput(INPUT_X, state.x); onNetworkEdited(); }
+            if (ImGui::Checkbox("X2", &state.y)) { session.setInput(INPUT_Y, state.y); onNetworkEdited(); }
+            if (ImGui::Checkbox("X1^2", &state.xSquared)) { session.setInput(INPUT_X_SQUARED, state.xSquared); onNetworkEdited(); }
+            if (ImGui::Checkbox("X2^2", &state.ySquared)) { session.setInput(INPUT_Y_SQUARED, state.ySquared); onNetworkEdited(); }
+            if (ImGui::Checkbox("X1*X2", &state.xTimesY)) { session.setInput(INPUT_X_TIMES_Y, state.xTimesY); onNetworkEdited(); }
+            if (ImGui::Checkbox("sin(X1)", &state.sinX)) { session.setInput(INPUT_SIN_X, state.sinX); onNetworkEdited(); }
+        }
     }
 
     ImGui::Separator();
@@ -170,26 +199,22 @@ void PlaygroundApp::drawControls() {
     if (ImGui::CollapsingHeader("Hidden Layers", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui::Text("Number of hidden layers");
         ImGui::SameLine();
-        if (ImGui::Button("+") && state.numHiddenLayers < 6) {
-            state.numHiddenLayers++;
-            state.networkShape.push_back(2);
-            parametersChanged = true;
-            reset();
+        if (ImGui::Button("+") && state.numHiddenLayers < maxHiddenLayers) {
+            session.addLayer();
+            onNetworkEdited();
         }
         ImGui::SameLine();
         if (ImGui::Button("-") && state.numHiddenLayers > 0) {
-            state.numHiddenLayers--;
-            state.networkShape.pop_back();
-            parametersChanged = true;
-            reset();
+            session.removeLayer();
+            onNetworkEdited();
         }
 
         for (int i = 0; i < state.numHiddenLayers; ++i) {
             std::string label = "Neurons in layer " + std::to_string(i + 1);
-            ImGui::SliderInt(label.c_str(), &state.networkShape[i], 1, 8);
+            ImGui::SliderInt(label.c_str(), &state.networkShape[i], 1, std::max(maxLayerWidth, state.networkShape[i]));
             if (ImGui::IsItemDeactivatedAfterEdit()) {
-                parametersChanged = true;
-                reset();
+                session.resizeLayer(i, state.networkShape[i]);
+                onNetworkEdited();
             }
         }
     }
@@ -202,17 +227,48 @@ void PlaygroundApp::drawControls() {
         if (ImGui::BeginCombo("Activation", current_act_key.c_str())) {
             for (auto const& [key, val] : activations) {
                 if (ImGui::Selectable(key.c_str(), key == current_act_key)) {
-                    state.activationKey = key;
-
-                    parametersChanged = true;
-                    reset();
+                    session.setActivation(key);
+                    onNetworkEdited();
                 }
             }
             ImGui::EndCombo();
         }
+        if (ImGui::Checkbox("Fast activations", &state.fastActivations)) {
+            session.setFastActivations(state.fastActivations);
+            onNetworkEdited();
+        }
 
         ImGui::SliderFloat("Learning rate", &state.learningRate, 0.001f, 0.3f, "%.3f", ImGuiSliderFlags_Logarithmic);
 
+        if (ImGui::BeginCombo("Optimizer", state.optimizerKey.c_str())) {
+            for (auto const& [key, val] : optimizers) {
+                if (ImGui::Selectable(key.c_str(), key == state.optimizerKey)) {
+                    session.setOptimizer(key);
+                    parametersChanged = true;
+                }
+            }
+            ImGui::EndCombo();
+        }
+        if (ImGui::Checkbox("Full-batch L-BFGS", &state.lbfgs)) {
+            session.setLbfgs(state.lbfgs, state.lbfgsHistory);
+            parametersChanged = true;
+        }
+        if (state.lbfgs) {
+            ImGui::SliderInt("L-BFGS history", &state.lbfgsHistory, 1, 50);
+            if (ImGui::IsItemDeactivatedAfterEdit()) {
+                session.setLbfgs(state.lbfgs, state.lbfgsHistory);
+                parametersChanged = true;
+            }
+            if (const nn::Lbfgs* lbfgs = session.lbfgsProgress()) {
+                const char* status = lbfgs->status() == nn::Lbfgs::Status::CONVERGED ? "converged"
+                                     : lbfgs->status() == nn::Lbfgs::Status::STALLED ? "stalled"
+                                                                                      : "running";
+                ImGui::Text("L-BFGS %s, gradient norm %.2e", status, lbfgs->gradientNorm());
+            } else {
+                ImGui::TextDisabled("L-BFGS needs a fixed training set; streaming uses minibatches.");
+            }
+        }
+
         std::string current_reg_key = getKeyFromValue(regularizations, state.regularization);
         if (ImGui::BeginCombo("Regularization", current_reg_key.c_str())) {
             for (auto const& [key, val] : regularizations) {
@@ -230,9 +286,11 @@ void PlaygroundApp::drawControls() {
         ImGui::Text("Model Information:");
         // Input Features
         std::string input_features_str = "Input Features: ";
-        auto input_ids = constructInputIds();
+        auto input_ids = session.constructInputIds();
         for (size_t i = 0; i < input_ids.size(); ++i) {
-            input_features_str += INPUTS[input_ids[i]].label;
+            auto feature = std::find_if(std::begin(INPUTS), std::end(INPUTS),
+                                        [&](const InputFeature& f) { return input_ids[i] == f.name; });
+            input_features_str += feature != std::end(INPUTS) ? feature->label : input_ids[i];
             if (i < input_ids.size() - 1) {
                 input_features_str += ", ";
             }
@@ -254,59 +312,71 @@ void PlaygroundApp::drawNetwork() {
     const float RECT_SIZE = 30.0f;
     const float PADDING = 20.0f;
 
+    nn::Network& network = session.getNetwork();
     ImDrawList* drawList = ImGui::GetWindowDrawList();
     ImVec2 p = ImGui::GetCursorScreenPos();
     ImVec2 size = ImGui::GetContentRegionAvail();
 
-    // Calculate node positions
-    node2coord.clear();
+    // Calculate node positions. A layer wider than MAX_DRAWN_NODES shows its
+    // first nodes, and the last slot counts the ones left out.
+    node2coord.assign(nn::getOutputNode(network)->id + 1, std::nullopt);
+    std::vector<std::pair<ImVec2, size_t>> hiddenCounts;
     int numLayers = network.size();
     float layer_x_step = (size.x - 2 * PADDING - RECT_SIZE) / (numLayers - 1);
-
-    // Input layer
-    auto input_ids = constructInputIds();
-    float node_y_step_input = (size.y - 2 * PADDING) / (input_ids.size() + 1);
-    for (size_t i = 0; i < input_ids.size(); ++i) {
-        node2coord[input_ids[i]] = ImVec2(p.x + PADDING, p.y + PADDING + (i + 1) * node_y_step_input);
-    }
-
-    // Hidden and output layers
-    for (int i = 1; i < numLayers; ++i) {
-        float node_y_step = (size.y - 2 * PADDING) / (network[i].size() + 1);
-        for (size_t j = 0; j < network[i].size(); ++j) {
-            node2coord[network[i][j]->id] = ImVec2(p.x + PADDING + i * layer_x_step, p.y + PADDING + (j + 1) * node_y_step);
+    for (int i = 0; i < numLayers; ++i) {
+        size_t layerSize = network[i].size();
+        size_t slots = std::min<size_t>(layerSize, MAX_DRAWN_NODES);
+        size_t drawn = slots < layerSize ? slots - 1 : slots;
+        float node_y_step = (size.y - 2 * PADDING) / (slots + 1);
+        for (size_t j = 0; j < slots; ++j) {
+            ImVec2 pos(p.x + PADDING + i * layer_x_step, p.y + PADDING + (j + 1) * node_y_step);
+            if (j < drawn) {
+                node2coord[network[i][j]->id] = pos;
+            } else {
+                hiddenCounts.push_back({pos, layerSize - drawn});
+            }
         }
     }
 
-    // Draw links
+    // Draw links between drawn nodes
     for (const auto& layer : network) {
         for (const auto& node : layer) {
+            const auto& dest = node2coord[node->id];
+            if (!dest) continue;
             for (const auto& link : node->inputLinks) {
-                ImVec2 p1 = node2coord[link->source->id];
-                ImVec2 p2 = node2coord[link->dest->id];
+                const auto& source = node2coord[link->source->id];
+                if (!source) continue;
                 float weight_abs = std::abs(link->weight);
                 ImU32 color = mainHeatMap.getColor(link->weight / 2.0); // Scale weight for color
-                drawList->AddLine(p1, p2, color, 1.0f + weight_abs * 1.5f);
+                drawList->AddLine(*source, *dest, color, 1.0f + weight_abs * 1.5f);
             }
         }
     }
 
     // Draw nodes
-    for (const auto& [id, pos] : node2coord) {
+    for (const auto& coord : node2coord) {
+        if (!coord) continue;
+        const ImVec2& pos = *coord;
         drawList->AddRectFilled(ImVec2(pos.x - RECT_SIZE/2, pos.y - RECT_SIZE/2), ImVec2(pos.x + RECT_SIZE/2, pos.y + RECT_SIZE/2), IM_COL32(255,255,255,255), 4.0f);
         drawList->AddRect(ImVec2(pos.x - RECT_SIZE/2, pos.y - RECT_SIZE/2), ImVec2(pos.x + RECT_SIZE/2, pos.y + RECT_SIZE/2), IM_COL32(0,0,0,255), 4.0f);
     }
+    for (const auto& [pos, count] : hiddenCounts) {
+        std::string label = "+" + std::to_string(count);
+        ImVec2 textSize = ImGui::CalcTextSize(label.c_str());
+        drawList->AddRect(ImVec2(pos.x - RECT_SIZE/2, pos.y - RECT_SIZE/2), ImVec2(pos.x + RECT_SIZE/2, pos.y + RECT_SIZE/2), IM_COL32(160,160,160,255), 4.0f);
+        drawList->AddText(ImVec2(pos.x - textSize.x / 2, pos.y - textSize.y / 2), IM_COL32(255,255,255,255), label.c_str());
+    }
 }
 
 #include <fstream>
 
 void PlaygroundApp::drawOutput() {
-    ImGui::Text("Test loss: %.3f", lossTest);
+    ImGui::Text("Test loss: %.3f", session.lossTest());
     ImGui::SameLine();
-    ImGui::Text("Train loss: %.3f", lossTrain);
+    ImGui::Text("Train loss: %.3f", session.lossTrain());
     if (state.showOverfit) {
         ImGui::SameLine();
-        ImGui::Text("Overfit: %.3f", lossTrain - lossTest);
+        ImGui::Text("Overfit: %.3f", session.lossTrain() - session.lossTest());
     }
 
     lineChart.draw();
@@ -320,9 +390,13 @@ void PlaygroundApp::drawOutput() {
     ImGui::Checkbox("Show potential overfit", &state.showOverfit);
 
     // Debugging: Display data sizes
-    ImGui::Text("Train Data Size: %zu", trainData.size());
+    if (session.isStreaming()) {
+        ImGui::Text("Train Data: streamed, %zu per epoch", session.streamedPerEpoch());
+    } else {
+        ImGui::Text("Train Data Size: %zu", session.trainData().size());
+    }
     ImGui::SameLine();
-    ImGui::Text("Test Data Size: %zu", testData.size());
+    ImGui::Text("Test Data Size: %zu", session.testData().size());
 
     ImVec2 canvas_p0 = ImGui::GetCursorScreenPos();
     ImVec2 canvas_sz = ImGui::GetContentRegionAvail();
@@ -336,128 +410,186 @@ void PlaygroundApp::drawOutput() {
     mainHeatMap.draw(drawList, canvas_p0, canvas_sz);
 
     if (state.showDataPoints) {
-        mainHeatMap.drawDataPoints(drawList, canvas_p0, canvas_sz, trainData);
+        mainHeatMap.drawDataPoints(drawList, canvas_p0, canvas_sz, session.trainData(), state.axisX, state.axisY);
         if (state.showTestData) {
-            mainHeatMap.drawDataPoints(drawList, canvas_p0, canvas_sz, testData);
+            mainHeatMap.drawDataPoints(drawList, canvas_p0, canvas_sz, session.testData(), state.axisX, state.axisY);
         }
     }
 }
 
 void PlaygroundApp::reset(bool onStartup) {
-    if (!onStartup) {
-        // Change seed
-    }
-
-    if (!network.empty()) {
-        nn::deleteNetwork(network);
-    }
+    session.reset(onStartup);
+    onSessionReset();
+}
 
+void PlaygroundApp::onSessionReset() {
     lineChart.reset();
-    iter = 0;
 
-    auto inputIds = constructInputIds();
-    std::vector<int> shape = { (int)inputIds.size() };
-    shape.insert(shape.end(), state.networkShape.begin(), state.networkShape.end());
-    shape.push_back(1);
-
-    nn::ActivationFunction outputActivation = (state.problem == Problem::REGRESSION) ?
-        nn::Activations::LINEAR : nn::Activations::TANH;
+    const playground::Dataset& data = session.getData();
+    featureMeans = data.means();
+    featureMeans.resize(std::max<size_t>(2, data.numFeatures()), 0.0);
+    updateDomains();
+    onNetworkChanged();
+}
 
-    network = nn::buildNetwork(shape, activations[state.activationKey], outputActivation, state.regularization, inputIds, state.initZero);
+void PlaygroundApp::onNetworkEdited() {
+    parametersChanged = true;
+    onNetworkChanged();
+}
 
+void PlaygroundApp::onNetworkChanged() {
     // ================== FIX START ==================
     // Clear the old boundary data and initialize it for the new network.
     boundary.clear();
-    nn::forEachNode(network, true, [this](nn::Node* node) {
-        // For each node, create a 2D vector of the correct size.
-        boundary[node->id] = std::vector<std::vector<double>>(DENSITY, std::vector<double>(DENSITY));
-    });
+    boundary.resize(nn::getOutputNode(session.getNetwork())->id + 1);
+    if (drawsEveryNode()) {
+        nn::forEachNode(session.getNetwork(), true, [this](nn::Node* node) {
+            // For each node, create a 2D vector of the correct size.
+            boundary[node->id] = std::vector<std::vector<double>>(DENSITY, std::vector<double>(DENSITY));
+        });
+    } else {
+        boundary[nn::getOutputNode(session.getNetwork())->id] =
+            std::vector<std::vector<double>>(DENSITY, std::vector<double>(DENSITY));
+    }
     // =================== FIX END ===================
 
-    generateData(onStartup);
-    updateUIState();
+    gridPoints.assign(DENSITY * DENSITY * featureMeans.size(), 0.0);
+    gridOutputs.assign(DENSITY * DENSITY, 0.0);
+    gridInput.assign(session.getNetwork()[0].size(), 0.0);
+
+    quantized.reset();
+    nn::ActivationKind activation, outputActivation;
+    if (nn::activationKindOf(&session.hiddenActivation(), activation) &&
+        nn::activationKindOf(&session.outputActivation(), outputActivation)) {
+        std::vector<int> shape;
+        for (const auto& layer : session.getNetwork()) shape.push_back(static_cast<int>(layer.size()));
+        quantized = std::make_unique<nn::QuantizedNetwork>(shape, activation, outputActivation);
+    }
+    gridRows.assign(DENSITY * session.getNetwork()[0].size(), 0.0);
+
+    updateUIState(false);
 }
 
 void PlaygroundApp::oneStep() {
-    iter++;
-    for (size_t i = 0; i < trainData.size(); ++i) {
-        auto& point = trainData[i];
-        auto input = constructInput(point.x, point.y);
-        nn::forwardProp(network, input);
-        nn::backProp(network, point.label, nn::Errors::SQUARE);
-        if ((i + 1) % state.batchSize == 0) {
-            nn::updateWeights(network, state.learningRate, state.regularizationRate);
-        }
-    }
+    session.step();
     updateUIState();
 }
 
-void PlaygroundApp::updateUIState() {
-    lossTrain = getLoss(network, trainData);
-    lossTest = getLoss(network, testData);
-    lineChart.addDataPoint(lossTrain, lossTest);
+void PlaygroundApp::updateUIState(bool recomputeLoss) {
+    if (recomputeLoss) {
+        session.updateLosses();
+    }
+    lineChart.addDataPoint(session.lossTrain(), session.lossTest());
 
     updateDecisionBoundary();
-    mainHeatMap.updateBackground(boundary[nn::getOutputNode(network)->id], state.discretize);
+    mainHeatMap.updateBackground(boundary[nn::getOutputNode(session.getNetwork())->id], state.discretize);
 }
 
-void PlaygroundApp::generateData(bool firstTime) {
-    int numSamples = state.numSamples;
-    auto generator = (state.problem == Problem::CLASSIFICATION) ? state.dataset : state.regDataset;
-    auto data = generator(numSamples, state.noise);
-
-    playground::shuffle(data);
-
-    int splitIndex = static_cast<int>(data.size() * state.percTrainData / 100.0);
-    trainData = std::vector<playground::Example2D>(data.begin(), data.begin() + splitIndex);
-    testData = std::vector<playground::Example2D>(data.begin() + splitIndex, data.end());
-}
-
-std::vector<std::string> PlaygroundApp::constructInputIds() {
-    std::vector<std::string> result;
-    if (state.x) result.push_back("x");
-    if (state.y) result.push_back("y");
-    if (state.xSquared) result.push_back("xSquared");
-    if (state.ySquared) result.push_back("ySquared");
-    if (state.xTimesY) result.push_back("xTimesY");
-    if (state.sinX) result.push_back("sinX");
-    return result;
+void PlaygroundApp::updateDomains() {
+    const playground::Dataset& data = session.getData();
+    int numFeatures = static_cast<int>(data.numFeatures());
+    if (numFeatures <= 2) {
+        state.axisX = 0;
+        state.axisY = 1;
+        xDomain = {-6.0, 6.0};
+        yDomain = {-6.0, 6.0};
+    } else {
+        state.axisX = std::min(std::max(state.axisX, 0), numFeatures - 1);
+        state.axisY = std::min(std::max(state.axisY, 0), numFeatures - 1);
+        auto padded = [](std::pair<float, float> range) {
+            double pad = std::max(1e-3, 0.05 * (range.second - range.first));
+            return std::make_pair(range.first - pad, range.second + pad);
+        };
+        xDomain = padded(data.range(state.axisX));
+        yDomain = padded(data.range(state.axisY));
+    }
+    mainHeatMap.xDomain = xDomain;
+    mainHeatMap.yDomain = yDomain;
 }
 
-std::vector<double> PlaygroundApp::constructInput(double x, double y) {
-    std::vector<double> input;
-    if (state.x) input.push_back(INPUTS["x"].f(x, y));
-    if (state.y) input.push_back(INPUTS["y"].f(x, y));
-    if (state.xSquared) input.push_back(INPUTS["xSquared"].f(x, y));
-    if (state.ySquared) input.push_back(INPUTS["ySquared"].f(x, y));
-    if (state.xTimesY) input.push_back(INPUTS["xTimesY"].f(x, y));
-    if (state.sinX) input.push_back(INPUTS["sinX"].f(x, y));
-    return input;
+bool PlaygroundApp::drawsEveryNode() {
+    for (const auto& layer : session.getNetwork()) {
+        if (layer.size() > MAX_DRAWN_NODES) return false;
+    }
+    return true;
 }
 
 void PlaygroundApp::updateDecisionBoundary() {
-
+    // The grid spans the two plotted axes; other features sit at their mean.
+    // gridPoints and gridOutputs are sized once per reset, so redrawing does
+    // not allocate.
+    size_t numFeatures = featureMeans.size();
     for (int i = 0; i < DENSITY; ++i) {
         for (int j = 0; j < DENSITY; ++j) {
-            double x = map_range(i, 0, DENSITY - 1, xDomain.first, xDomain.second);
-            double y = map_range(j, 0, DENSITY - 1, yDomain.first, yDomain.second);
-            auto input = constructInput(x, y);
-            nn::forwardProp(network, input);
-            nn::forEachNode(network, true, [this, i, j](nn::Node* node) {
-
-                boundary[node->id][i][j] = node->output;
-            });
+            double* gridPoint = &gridPoints[(i * DENSITY + j) * numFeatures];
+            std::copy(featureMeans.begin(), featureMeans.end(), gridPoint);
+            gridPoint[state.axisX] = map_range(i, 0, DENSITY - 1, xDomain.first, xDomain.second);
+            gridPoint[state.axisY] = map_range(j, 0, DENSITY - 1, yDomain.first, yDomain.second);
+        }
+    }
+    nn::Network& network = session.getNetwork();
+    if (!drawsEveryNode()) {
+        // Only the output is shown, so the whole grid goes through the
+        // session's batched kernel instead of the graph.
+        session.predict(gridPoints.data(), gridOutputs.size(), gridOutputs.data());
+        auto& grid = boundary[nn::getOutputNode(network)->id];
+        for (int i = 0; i < DENSITY; ++i) {
+            std::copy_n(gridOutputs.begin() + i * DENSITY, DENSITY, grid[i].begin());
+        }
+        return;
+    }
+    if (quantized && updateQuantizedBoundary()) {
+        return;
+    }
+    for (int i = 0; i < DENSITY; ++i) {
+        for (int j = 0; j < DENSITY; ++j) {
+            session.constructInput(&gridPoints[(i * DENSITY + j) * numFeatures], gridInput.data());
+            nn::forwardProp(network, gridInput);
+            for (size_t l = 1; l < network.size(); ++l) {
+                for (nn::Node* node : network[l]) {
+                    boundary[node->id][i][j] = node->output;
+                }
+            }
         }
     }
 }
 
-double PlaygroundApp::getLoss(nn::Network& net, const std::vector<playground::Example2D>& data) {
-    if (data.empty()) return 0.0;
-    double totalLoss = 0;
-    for (const auto& point : data) {
-        auto input = constructInput(point.x, point.y);
-        double output = nn::forwardProp(net, input);
-        totalLoss += nn::Errors::SQUARE.error(output, point.label);
+bool PlaygroundApp::updateQuantizedBoundary() {
+    // The grids only need to be right to a colour step, so they come from
+    // the fixed-point network, one grid column per batch. It beats the graph
+    // on every node but not the dense kernels on wide layers, which is why
+    // the output-only path above keeps the kernel.
+    nn::Network& network = session.getNetwork();
+    size_t numFeatures = featureMeans.size();
+    size_t numInputs = network[0].size();
+    quantized->load(network);
+    for (int i = 0; i < DENSITY; ++i) {
+        for (int j = 0; j < DENSITY; ++j) {
+            session.constructInput(&gridPoints[(i * DENSITY + j) * numFeatures], &gridRows[j * numInputs]);
+        }
+        quantized->forward(gridRows.data(), DENSITY);
+        for (size_t l = 1; l < network.size(); ++l) {
+            for (size_t n = 0; n < network[l].size(); ++n) {
+                auto& grid = boundary[network[l][n]->id];
+                if (!grid.empty()) {
+                    std::copy_n(quantized->nodeOutputs(l, n), DENSITY, grid[i].begin());
+                }
+            }
+        }
+    }
+
+    // Check the output against the graph at the corners and the centre.
+    auto& outputGrid = boundary[nn::getOutputNode(network)->id];
+    const std::pair<int, int> probes[] = {
+        {0, 0}, {0, DENSITY - 1}, {DENSITY - 1, 0}, {DENSITY - 1, DENSITY - 1}, {DENSITY / 2, DENSITY / 2},
+    };
+    for (auto [i, j] : probes) {
+        session.constructInput(&gridPoints[(i * DENSITY + j) * numFeatures], gridInput.data());
+        double exact = nn::forwardProp(network, gridInput);
+        if (std::abs(outputGrid[i][j] - exact) > MAX_QUANTIZATION_ERROR * std::max(1.0, std::abs(exact))) {
+            quantized.reset();
+            return false;
+        }
     }
-    return totalLoss / data.size();
+    return true;
 }
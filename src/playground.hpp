@@ -1,11 +1,12 @@
 #pragma once
 
-#include "state.hpp"
+#include "session.hpp"
 #include "heatmap.hpp"
 #include "linechart.hpp"
-#include "nn.hpp"
-#include "dataset.hpp"
+#include "quantized.hpp"
 #include <map>
+#include <memory>
+#include <optional>
 #include <string>
 #include <algorithm>
 
@@ -34,48 +35,101 @@ inline double map_range(double val, double in_min, double in_max, double out_min
 class PlaygroundApp {
 public:
     PlaygroundApp();
-    ~PlaygroundApp();
 
     void runFrame();
     void drawUI();
 
+    /**
+     * Maps a binary dataset file and lists it next to the built-in
+     * generators, under the file name without its extension. Throws
+     * std::runtime_error if the file is not a valid dataset.
+     */
+    void loadDatasetFile(const std::string& path);
+
+    /**
+     * Writes the network, the current epoch and the hyperparameters to a
+     * binary checkpoint. Throws std::runtime_error on I/O errors.
+     */
+    void saveCheckpoint(const std::string& path);
+
+    /**
+     * Restores a checkpoint written by saveCheckpoint and pauses training.
+     * Throws std::runtime_error if the file is invalid or names a dataset
+     * that is not loaded.
+     */
+    void loadCheckpoint(const std::string& path);
+
+    // Limits of the hidden layer controls (main() reads --max-layers and
+    // --max-width). Wider shapes can still come from a checkpoint.
+    int maxHiddenLayers = 6;
+    int maxLayerWidth = 8;
+
 private:
     void reset(bool onStartup = false);
+    // Rebuilds the charts and the boundary after the session was reset.
+    void onSessionReset();
+    // Resizes the boundary grids for a new network and redraws; the loss
+    // chart goes on.
+    void onNetworkChanged();
+    // Called after a Session edit from the controls.
+    void onNetworkEdited();
     void oneStep();
-    void generateData(bool firstTime = false);
-    void updateUIState();
+    void updateUIState(bool recomputeLoss = true);
 
     void drawControls();
     void drawNetwork();
     void drawOutput();
 
-    std::vector<std::string> constructInputIds();
-    std::vector<double> constructInput(double x, double y);
+    void updateDomains();
     void updateDecisionBoundary();
-    double getLoss(nn::Network& net, const std::vector<playground::Example2D>& data);
+    // True if no layer is wider than the diagram draws; otherwise only the
+    // output node gets a boundary grid.
+    bool drawsEveryNode();
+    // Fills the boundary grids from the fixed-point network. Returns false,
+    // and drops it, if it strays from the graph by more than a colour step.
+    bool updateQuantizedBoundary();
 
-    State state;
-    nn::Network network;
+    // Settings, data, network and training loop; everything here is view.
+    Session session;
+    State& state = session.state;
 
-    std::vector<playground::Example2D> trainData;
-    std::vector<playground::Example2D> testData;
+    // Feature means that the boundary grid uses for every non-plotted feature.
+    std::vector<double> featureMeans;
 
     static const int DENSITY = 50;
-    const std::pair<double, double> xDomain = {-6.0, 6.0};
-    const std::pair<double, double> yDomain = {-6.0, 6.0};
+    // Wider layers are drawn as their first nodes and a "+N" box.
+    static const int MAX_DRAWN_NODES = 10;
+    // Largest boundary error of the fixed-point network, relative to
+    // outputs above 1; about one colour step of the heatmap.
+    static constexpr double MAX_QUANTIZATION_ERROR = 5e-3;
+    // Plot ranges of the two visualized axes: fixed for the 2D generators,
+    // fitted to the data for higher-dimensional datasets.
+    std::pair<double, double> xDomain = {-6.0, 6.0};
+    std::pair<double, double> yDomain = {-6.0, 6.0};
 
     HeatMap mainHeatMap;
-    std::map<std::string, HeatMap> nodeHeatMaps;
+    std::map<int, HeatMap> nodeHeatMaps;
     LineChart lineChart;
 
     bool isPlaying = false;
     bool parametersChanged = false;
-    int iter = 0;
-    double lossTrain = 0;
-    double lossTest = 0;
-
-    std::map<std::string, ImVec2> node2coord;
-    std::string selectedNodeId;
 
-    std::map<std::string, std::vector<std::vector<double>>> boundary;
+    // Indexed by node id; empty for nodes the diagram leaves out.
+    std::vector<std::optional<ImVec2>> node2coord;
+    int selectedNode = -1;
+
+    // Indexed by node id; only the drawn nodes get a grid.
+    std::vector<std::vector<std::vector<double>>> boundary;
+    // Decision boundary scratch: the grid points (featureMeans.size() values
+    // each), their outputs, and one network input.
+    std::vector<double> gridPoints;
+    std::vector<double> gridOutputs;
+    std::vector<double> gridInput;
+    // Fixed-point copy of the network that draws the boundary grids, and its
+    // input rows for one column of the grid. Null for custom activations.
+    std::unique_ptr<nn::QuantizedNetwork> quantized;
+    std::vector<double> gridRows;
+
+    std::string checkpointPath = "playground.nnck";
+    std::string checkpointStatus;
 };
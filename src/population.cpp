@@ -0,0 +1,145 @@
+#include "population.hpp"
+#include "kernel_math.hpp"
+#include "random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace nn {
+
+// Every loop over k below is independent across networks and runs over
+// contiguous memory, so it compiles to packed SIMD arithmetic. The
+// activation switch sits outside those loops.
+
+Population::Population(const std::vector<int>& shape, ActivationKind activation, ActivationKind outputActivation,
+                       RegularizationKind regularization, const std::vector<uint64_t>& seeds, bool initZero)
+    : shape(shape), K(seeds.size()), activation(activation), outputActivation(outputActivation),
+      regularization(regularization) {
+    if (shape.size() < 2 || shape.back() != 1 || K == 0) {
+        throw std::runtime_error("A population needs at least one network with two layers and a single output");
+    }
+    size_t numNodes = 0, numLinks = 0;
+    for (size_t l = 0; l < shape.size(); ++l) {
+        nodeOffset.push_back(numNodes);
+        linkOffset.push_back(numLinks);
+        numNodes += shape[l];
+        if (l > 0) numLinks += static_cast<size_t>(shape[l - 1]) * shape[l];
+    }
+    outputNode = numNodes - 1;
+
+    biases.assign(numNodes * K, initZero ? 0.0 : 0.1);
+    totalInput.assign(numNodes * K, 0.0);
+    output.assign(numNodes * K, 0.0);
+    inputDer.assign(numNodes * K, 0.0);
+    outputDer.assign(numNodes * K, 0.0);
+    accInputDer.assign(numNodes * K, 0.0);
+    weights.assign(numLinks * K, 0.0);
+    accErrorDer.assign(numLinks * K, 0.0);
+    alive.assign(numLinks * K, 1.0);
+
+    // Links are numbered in buildNetwork's order, so the same seed draws the
+    // same weights.
+    if (!initZero) {
+        for (size_t k = 0; k < K; ++k) {
+            const rng::Stream stream(seeds[k], rng::WEIGHTS);
+            for (size_t link = 0; link < numLinks; ++link) {
+                weights[link * K + k] = stream.uniform(link) - 0.5;
+            }
+        }
+    }
+}
+
+const double* Population::forward(const double* input) {
+    for (int n = 0; n < shape[0]; ++n) {
+        for (size_t k = 0; k < K; ++k) output[n * K + k] = input[n];
+    }
+    for (size_t l = 1; l < shape.size(); ++l) {
+        ActivationKind kind = l + 1 == shape.size() ? outputActivation : activation;
+        size_t fanIn = shape[l - 1];
+        for (int n = 0; n < shape[l]; ++n) {
+            size_t node = nodeOffset[l] + n;
+            double* total = &totalInput[node * K];
+            const double* w = &weights[(linkOffset[l] + n * fanIn) * K];
+            const double* src = &output[nodeOffset[l - 1] * K];
+            for (size_t k = 0; k < K; ++k) total[k] = biases[node * K + k];
+            for (size_t i = 0; i < fanIn; ++i) {
+                for (size_t k = 0; k < K; ++k) total[k] += w[i * K + k] * src[i * K + k];
+            }
+            activate(kind, total, &output[node * K], K);
+        }
+    }
+    return outputs();
+}
+
+void Population::backward(double target) {
+    double* outDer = &outputDer[outputNode * K];
+    const double* out = &output[outputNode * K];
+    for (size_t k = 0; k < K; ++k) outDer[k] = out[k] - target; // Errors::SQUARE.der
+    numAccumulated++;
+
+    for (size_t l = shape.size() - 1; l >= 1; --l) {
+        ActivationKind kind = l + 1 == shape.size() ? outputActivation : activation;
+        size_t fanIn = shape[l - 1];
+        for (int n = 0; n < shape[l]; ++n) {
+            size_t node = nodeOffset[l] + n;
+            double* der = &inputDer[node * K];
+            activationDer(kind, &totalInput[node * K], &output[node * K], &outputDer[node * K], der, K);
+            for (size_t k = 0; k < K; ++k) accInputDer[node * K + k] += der[k];
+
+            size_t firstLink = (linkOffset[l] + n * fanIn) * K;
+            const double* src = &output[nodeOffset[l - 1] * K];
+            for (size_t i = 0; i < fanIn; ++i) {
+                double* acc = &accErrorDer[firstLink + i * K];
+                const double* live = &alive[firstLink + i * K];
+                for (size_t k = 0; k < K; ++k) acc[k] += live[k] * (der[k] * src[i * K + k]);
+            }
+        }
+        if (l == 1) break;
+
+        // Output derivatives of the previous layer, summed over destination
+        // nodes in the same order as backProp.
+        double* prevDer = &outputDer[nodeOffset[l - 1] * K];
+        for (size_t i = 0; i < fanIn * K; ++i) prevDer[i] = 0;
+        for (int n = 0; n < shape[l]; ++n) {
+            const double* der = &inputDer[(nodeOffset[l] + n) * K];
+            const double* w = &weights[(linkOffset[l] + n * fanIn) * K];
+            for (size_t i = 0; i < fanIn; ++i) {
+                for (size_t k = 0; k < K; ++k) prevDer[i * K + k] += w[i * K + k] * der[k];
+            }
+        }
+    }
+}
+
+void Population::update(const double* learningRates, const double* regularizationRates) {
+    if (numAccumulated == 0) {
+        return;
+    }
+    const double n = numAccumulated;
+    for (size_t node = shape[0]; node < biases.size() / K; ++node) {
+        double* b = &biases[node * K];
+        double* acc = &accInputDer[node * K];
+        for (size_t k = 0; k < K; ++k) {
+            b[k] -= learningRates[k] * acc[k] / n;
+            acc[k] = 0;
+        }
+    }
+    for (size_t link = 0; link < weights.size() / K; ++link) {
+        double* w = &weights[link * K];
+        double* acc = &accErrorDer[link * K];
+        double* live = &alive[link * K];
+        for (size_t k = 0; k < K; ++k) {
+            // Dead links keep their weight of 0 (acc stays 0 for them too).
+            double stepped = w[k] - (learningRates[k] / n) * acc[k];
+            double regulDer = regularizationDer(regularization, stepped);
+            double updated = stepped - (learningRates[k] * regularizationRates[k]) * regulDer;
+            // The weight crossed 0 due to L1 regularization: set it to 0.
+            bool crossed = regularization == RegularizationKind::L1 && stepped * updated < 0;
+            w[k] = live[k] == 0 ? w[k] : (crossed ? 0.0 : updated);
+            live[k] = crossed ? 0.0 : live[k];
+            acc[k] = 0;
+        }
+    }
+    numAccumulated = 0;
+}
+
+} // namespace nn
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "nn.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace nn {
+
+/**
+ * K fully connected networks of one shape, trained in lockstep on the same
+ * examples. Every per-link and per-node value is stored network-minor
+ * (`value[i * K + k]` for network k), so each step of forward, backward and
+ * update is an inner loop over the K networks that the compiler vectorizes.
+ *
+ * Network k computes exactly what buildNetwork(shape, ..., seeds[k]) trained
+ * with forwardProp/backProp(Errors::SQUARE)/updateWeights would, but the K
+ * networks may use different learning and regularization rates.
+ */
+class Population {
+public:
+    /**
+     * Creates one network per entry of `seeds`, each initialized like
+     * buildNetwork with that seed.
+     */
+    Population(const std::vector<int>& shape, ActivationKind activation, ActivationKind outputActivation,
+               RegularizationKind regularization, const std::vector<uint64_t>& seeds, bool initZero = false);
+
+    size_t size() const { return K; }
+    const std::vector<int>& getShape() const { return shape; }
+
+    /**
+     * Runs `input` (one value per input node, shared by all networks) forward
+     * and returns the K outputs.
+     */
+    const double* forward(const double* input);
+
+    /**
+     * Accumulates the square-error derivatives for `target` after forward().
+     */
+    void backward(double target);
+
+    /**
+     * Applies the accumulated derivatives; network k uses learningRates[k]
+     * and regularizationRates[k].
+     */
+    void update(const double* learningRates, const double* regularizationRates);
+
+    const double* outputs() const { return output.data() + outputNode * K; }
+
+    double weight(size_t link, size_t k) const { return weights[link * K + k]; }
+    double bias(size_t node, size_t k) const { return biases[node * K + k]; }
+    size_t numLinks() const { return weights.size() / K; }
+    size_t numNodes() const { return biases.size() / K; }
+
+private:
+    std::vector<int> shape;
+    size_t K;
+    ActivationKind activation;
+    ActivationKind outputActivation;
+    RegularizationKind regularization;
+
+    // Node n of layer l is nodeOffset[l] + n; the links into it start at
+    // linkOffset[l] + n * shape[l - 1].
+    std::vector<size_t> nodeOffset;
+    std::vector<size_t> linkOffset;
+    size_t outputNode = 0;
+
+    // Per node, K values each.
+    std::vector<double> biases, totalInput, output, inputDer, outputDer, accInputDer;
+    // Per link, K values each. `alive` is 1 until L1 drives the weight to 0.
+    std::vector<double> weights, accErrorDer, alive;
+    int numAccumulated = 0; // Examples since the last update (shared by all K).
+};
+
+} // namespace nn
@@ -0,0 +1,119 @@
+#include "quantized.hpp"
+#include "kernel_math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace nn {
+
+// The exact activations cost more than the integer products; the fast ones
+// are far more accurate than the quantization.
+static ActivationKind fastKind(ActivationKind kind) {
+    if (kind == ActivationKind::TANH) return ActivationKind::FAST_TANH;
+    if (kind == ActivationKind::SIGMOID) return ActivationKind::FAST_SIGMOID;
+    return kind;
+}
+
+QuantizedNetwork::QuantizedNetwork(const std::vector<int>& shape, ActivationKind activation,
+                                   ActivationKind outputActivation)
+    : shape(shape), activation(fastKind(activation)), outputActivation(fastKind(outputActivation)),
+      weights(shape.size()), weightScale(shape.size(), 1.0), levels(shape.size()), biases(shape.size()),
+      outputs(shape.size()) {
+    for (size_t l = 1; l < shape.size(); ++l) {
+        size_t fanIn = static_cast<size_t>(shape[l - 1]);
+        weights[l].resize(fanIn * shape[l]);
+        biases[l].resize(shape[l]);
+        // A chunk of products, levels^2 each, must fit in an int32_t.
+        size_t terms = std::max<size_t>(1, std::min(fanIn, CHUNK));
+        double limit = std::sqrt(std::numeric_limits<int32_t>::max() / static_cast<double>(terms));
+        levels[l] = std::max(1, static_cast<int>(std::min(32767.0, std::floor(limit))));
+    }
+}
+
+void QuantizedNetwork::load(const Network& network) {
+    for (size_t l = 1; l < shape.size(); ++l) {
+        double largest = 0;
+        for (const Node* node : network[l]) {
+            for (const Link* link : node->inputLinks) largest = std::max(largest, std::abs(link->weight));
+        }
+        weightScale[l] = largest > 0 ? largest / levels[l] : 1.0;
+        size_t i = 0;
+        for (size_t n = 0; n < network[l].size(); ++n) {
+            const Node* node = network[l][n];
+            biases[l][n] = node->bias;
+            for (const Link* link : node->inputLinks) {
+                weights[l][i++] = static_cast<int16_t>(std::lrint(link->weight / weightScale[l]));
+            }
+        }
+    }
+}
+
+void QuantizedNetwork::forward(const double* inputs, size_t count) {
+    auto reserve = [count](auto& buffer, size_t perRow) {
+        if (buffer.size() < count * perRow) buffer.resize(count * perRow);
+    };
+    rows = count;
+    reserve(rowScale, 1);
+    reserve(chunkSums, 1);
+    // The inputs are row-major, every later layer node-major.
+    const double* in = inputs;
+    size_t rowStride = inputSize(), columnStride = 1;
+    for (size_t l = 1; l < shape.size(); ++l) {
+        size_t fanIn = static_cast<size_t>(shape[l - 1]);
+        size_t width = static_cast<size_t>(shape[l]);
+        reserve(quantized, fanIn);
+        reserve(outputs[l], width);
+
+        // One scale per row, mapping its largest input to the layer's
+        // largest level. Rows that are not finite come out as NaN, as they
+        // would from the graph.
+        std::fill_n(rowScale.begin(), count, 0.0);
+        for (size_t k = 0; k < fanIn; ++k) {
+            for (size_t row = 0; row < count; ++row) {
+                rowScale[row] = std::max(rowScale[row], std::abs(in[row * rowStride + k * columnStride]));
+            }
+        }
+        for (size_t row = 0; row < count; ++row) {
+            double largest = rowScale[row];
+            rowScale[row] = std::isfinite(largest) ? (largest > 0 ? largest / levels[l] : 1.0)
+                                                   : std::numeric_limits<double>::quiet_NaN();
+        }
+        for (size_t k = 0; k < fanIn; ++k) {
+            int16_t* a = &quantized[k * count];
+            for (size_t row = 0; row < count; ++row) {
+                double v = in[row * rowStride + k * columnStride] / rowScale[row];
+                v = std::isfinite(v) ? v : 0.0;
+                a[row] = static_cast<int16_t>(v + std::copysign(0.5, v));
+            }
+        }
+
+        // Node n's totals for all rows at once: 16-bit products summed in 32
+        // bits over a chunk of inputs, then added up in double. The loops run
+        // across rows, so the compiler packs them into integer vectors.
+        double* total = outputs[l].data();
+        for (size_t n = 0; n < width; ++n) {
+            const int16_t* w = &weights[l][n * fanIn];
+            double* sum = &total[n * count];
+            std::fill_n(sum, count, 0.0);
+            for (size_t first = 0; first < fanIn; first += CHUNK) {
+                size_t last = std::min(fanIn, first + CHUNK);
+                std::fill_n(chunkSums.begin(), count, 0);
+                for (size_t k = first; k < last; ++k) {
+                    const int16_t* a = &quantized[k * count];
+                    int32_t wk = w[k];
+                    for (size_t row = 0; row < count; ++row) chunkSums[row] += wk * a[row];
+                }
+                for (size_t row = 0; row < count; ++row) sum[row] += chunkSums[row];
+            }
+            for (size_t row = 0; row < count; ++row) {
+                sum[row] = sum[row] * rowScale[row] * weightScale[l] + biases[l][n];
+            }
+        }
+        activate(l + 1 == shape.size() ? outputActivation : activation, total, total, count * width);
+        in = total;
+        rowStride = 1;
+        columnStride = count;
+    }
+}
+
+} // namespace nn
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "nn.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace nn {
+
+/**
+ * An inference-only copy of a network in 16-bit fixed point, for drawing
+ * the decision boundary and the node heatmaps. Each layer's weights share
+ * one scale, and each row of a layer's inputs gets its own scale when it is
+ * run. The products are summed in integers; the biases and the
+ * activation functions stay in double.
+ *
+ * The outputs are within 5e-3 of forwardProp (relative, for unbounded
+ * activations), about one colour step of a heatmap, and usually well
+ * within. Tanh and sigmoid use their fast approximations.
+ */
+class QuantizedNetwork {
+public:
+    QuantizedNetwork(const std::vector<int>& shape, ActivationKind activation, ActivationKind outputActivation);
+
+    size_t inputSize() const { return static_cast<size_t>(shape[0]); }
+
+    /**
+     * Quantizes the weights and copies the biases of `network`, which must
+     * have this shape. Cheap enough to call before every redraw.
+     */
+    void load(const Network& network);
+
+    /**
+     * Runs `count` rows of inputSize() values forward. Allocates only when
+     * `count` exceeds every earlier call.
+     */
+    void forward(const double* inputs, size_t count);
+
+    /**
+     * The outputs of node `n` of layer `l` (1 to the output layer) for the
+     * rows of the last forward().
+     */
+    const double* nodeOutputs(size_t l, size_t n) const { return &outputs[l][n * rows]; }
+
+private:
+    // Products summed in 32 bits before they are added up in double.
+    static constexpr size_t CHUNK = 4;
+
+    std::vector<int> shape;
+    ActivationKind activation;
+    ActivationKind outputActivation;
+    // Per layer l >= 1: weights[l][n * shape[l - 1] + k] is the link from
+    // node k of layer l - 1 to node n, in units of weightScale[l].
+    std::vector<std::vector<int16_t>> weights;
+    std::vector<double> weightScale;
+    // The largest quantized magnitude per layer; small enough that a sum of
+    // CHUNK products cannot overflow 32 bits.
+    std::vector<int> levels;
+    std::vector<std::vector<double>> biases;
+    // Scratch for forward(), by input (or node) and then by row: the
+    // current layer's quantized inputs and every layer's outputs. Then the
+    // per-row input scales and partial sums.
+    std::vector<int16_t> quantized;
+    std::vector<std::vector<double>> outputs;
+    std::vector<double> rowScale;
+    std::vector<int32_t> chunkSums;
+    size_t rows = 0;
+};
+
+} // namespace nn
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <random>
+
+namespace rng {
+
+/**
+ * Well-known stream ids. Each consumer of randomness draws from its own
+ * stream so that, for example, changing the network shape does not change
+ * the generated dataset.
+ */
+enum StreamId : uint32_t {
+    DATA = 0,
+    SHUFFLE = 1,
+    WEIGHTS = 2,
+    EPOCH_ORDER = 3,
+    SWEEP = 4,
+    EDITS = 5,
+};
+
+/**
+ * Philox4x32-10 block function (Salmon et al., "Parallel Random Numbers: As
+ * Easy as 1, 2, 3"). Maps a 128-bit counter and a 64-bit key to 128 random
+ * bits with no internal state.
+ */
+struct Block {
+    uint32_t v[4];
+};
+
+inline Block philox4x32(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint32_t k0, uint32_t k1) {
+    const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+    for (int round = 0; round < 10; ++round) {
+        uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+        uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+        uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n1 = static_cast<uint32_t>(p1);
+        uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        uint32_t n3 = static_cast<uint32_t>(p0);
+        c0 = n0; c1 = n1; c2 = n2; c3 = n3;
+        k0 += W0; k1 += W1;
+    }
+    return {{c0, c1, c2, c3}};
+}
+
+/**
+ * SplitMix64 finalizer, used to derive independent keys.
+ */
+inline uint64_t mix64(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * A counter-based random stream. Every value is a pure function of
+ * (seed, stream, index, draw), so samples can be produced in any order or in
+ * parallel and still be bit-identical to a serial run.
+ */
+class Stream {
+public:
+    Stream(uint64_t seed, uint32_t stream) : key(seed), stream(stream) {}
+
+    /**
+     * Returns an independent stream, e.g. one per epoch.
+     */
+    Stream fork(uint64_t sub) const {
+        return Stream(mix64(key ^ mix64(sub)), stream);
+    }
+
+    /**
+     * Returns 64 random bits for the given example index and draw number.
+     */
+    uint64_t bits(uint64_t index, uint32_t draw = 0) const {
+        Block b = philox4x32(static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), draw >> 1, stream,
+                             static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32));
+        const uint32_t* half = b.v + ((draw & 1u) << 1);
+        return (static_cast<uint64_t>(half[0]) << 32) | half[1];
+    }
+
+    /**
+     * Returns a sample from a uniform [0, 1) distribution.
+     */
+    double uniform(uint64_t index, uint32_t draw = 0) const {
+        return static_cast<double>(bits(index, draw) >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /**
+     * Returns a sample from a uniform [a, b) distribution.
+     */
+    double uniform(double a, double b, uint64_t index, uint32_t draw = 0) const {
+        return a + (b - a) * uniform(index, draw);
+    }
+
+    /**
+     * Returns an integer in [0, n).
+     */
+    uint64_t below(uint64_t n, uint64_t index, uint32_t draw = 0) const {
+        return static_cast<uint64_t>(uniform(index, draw) * static_cast<double>(n));
+    }
+
+    /**
+     * Samples from a normal distribution using the Box-Muller transform.
+     * Consumes draws `draw` and `draw + 1`.
+     */
+    double normal(double mean, double variance, uint64_t index, uint32_t draw = 0) const {
+        double u1 = 1.0 - uniform(index, draw); // (0, 1]
+        double u2 = uniform(index, draw + 1);
+        double z = std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+        return mean + z * std::sqrt(variance);
+    }
+
+private:
+    uint64_t key;
+    uint32_t stream;
+};
+
+/**
+ * Hashes a user-facing seed string (FNV-1a) into a 64-bit key.
+ */
+inline uint64_t seedFromString(const std::string& seed) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (unsigned char c : seed) {
+        h ^= c;
+        h *= 0x100000001B3ull;
+    }
+    return mix64(h);
+}
+
+/**
+ * Returns a fresh seed string from the system entropy source.
+ */
+inline std::string randomSeedString() {
+    return std::to_string(std::random_device{}() % 100000u);
+}
+
+} // namespace rng
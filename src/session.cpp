@@ -0,0 +1,732 @@
+#include "session.hpp"
+#include "codegen.hpp"
+#include "dataset_file.hpp"
+#include "random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+
+// Initialize static maps from state.hpp. Activations are held by pointer:
+// copying the nn::Activations objects here would depend on nn.cpp's static
+// initializers having run first.
+std::map<std::string, const nn::ActivationFunction*> activations = {
+    {"relu", &nn::Activations::RELU},
+    {"tanh", &nn::Activations::TANH},
+    {"sigmoid", &nn::Activations::SIGMOID},
+    {"linear", &nn::Activations::LINEAR}
+};
+std::map<std::string, const nn::RegularizationFunction*> regularizations = {
+    {"none", nullptr},
+    {"L1", &nn::RegularizationFunctions::L1},
+    {"L2", &nn::RegularizationFunctions::L2}
+};
+std::map<std::string, nn::OptimizerKind> optimizers = {
+    {"sgd", nn::OptimizerKind::SGD},
+    {"momentum", nn::OptimizerKind::MOMENTUM},
+    {"nesterov", nn::OptimizerKind::NESTEROV},
+    {"rmsprop", nn::OptimizerKind::RMSPROP},
+    {"adam", nn::OptimizerKind::ADAM}
+};
+std::map<std::string, playground::DataGenerator> datasets = {
+    {"circle", playground::classifyCircleData},
+    {"xor", playground::classifyXORData},
+    {"gauss", playground::classifyTwoGaussData},
+    {"spiral", playground::classifySpiralData},
+    {"star", playground::classifyStarData},
+    {"sine", playground::classifySineData},
+    {"checkerboard", playground::classifyCheckerboardData},
+    {"moons", playground::classifyMoonsData},
+    {"heart", playground::classifyHeartData},
+};
+std::map<std::string, playground::DataGenerator> regDatasets = {
+    {"reg-plane", playground::regressPlane},
+    {"reg-gauss", playground::regressGaussian}
+};
+std::map<std::string, Problem> problems = {
+    {"classification", Problem::CLASSIFICATION},
+    {"regression", Problem::REGRESSION}
+};
+
+// --- Feature Definitions ---
+const InputFeature INPUTS[NUM_INPUTS] = {
+    {"x", [](double x, double y) { return x; }, "X_1", "x"},
+    {"y", [](double x, double y) { return y; }, "X_2", "y"},
+    {"xSquared", [](double x, double y) { return x * x; }, "X_1^2", "x * x"},
+    {"ySquared", [](double x, double y) { return y * y; }, "X_2^2", "y * y"},
+    {"xTimesY", [](double x, double y) { return x * y; }, "X_1X_2", "x * y"},
+    {"sinX", [](double x, double y) { return std::sin(x); }, "sin(X_1)", "std::sin(x)"},
+};
+
+// --- Settings ---
+
+std::map<std::string, std::string> stateSettings(const State& state) {
+    auto number = [](double value) {
+        std::ostringstream out;
+        out << std::setprecision(17) << value;
+        return out.str();
+    };
+    auto flag = [](bool value) { return std::string(value ? "1" : "0"); };
+    std::string shape;
+    for (int i = 0; i < state.numHiddenLayers; ++i) {
+        shape += (i ? "," : "") + std::to_string(state.networkShape[i]);
+    }
+    return {
+        {"problem", state.problem == Problem::REGRESSION ? "regression" : "classification"},
+        {"dataset", state.datasetKey},
+        {"regDataset", state.regDatasetKey},
+        {"activation", state.activationKey},
+        {"regularization", getKeyFromValue(regularizations, state.regularization)},
+        {"optimizer", state.optimizerKey},
+        {"lbfgs", flag(state.lbfgs)},
+        {"lbfgsHistory", std::to_string(state.lbfgsHistory)},
+        {"fastActivations", flag(state.fastActivations)},
+        {"learningRate", number(state.learningRate)},
+        {"regularizationRate", number(state.regularizationRate)},
+        {"noise", number(state.noise)},
+        {"batchSize", std::to_string(state.batchSize)},
+        {"percTrainData", std::to_string(state.percTrainData)},
+        {"numSamples", std::to_string(state.numSamples)},
+        {"shuffleBlockSize", std::to_string(state.shuffleBlockSize)},
+        {"streaming", flag(state.streaming)},
+        {"initZero", flag(state.initZero)},
+        {"networkShape", shape},
+        {"seed", state.seed},
+        {"x", flag(state.x)},
+        {"y", flag(state.y)},
+        {"xSquared", flag(state.xSquared)},
+        {"ySquared", flag(state.ySquared)},
+        {"xTimesY", flag(state.xTimesY)},
+        {"sinX", flag(state.sinX)},
+        {"axisX", std::to_string(state.axisX)},
+        {"axisY", std::to_string(state.axisY)},
+    };
+}
+
+State applySettings(State state, const std::map<std::string, std::string>& settings) {
+    auto lookup = [](const auto& map, const std::string& key, const char* what) {
+        auto it = map.find(key);
+        if (it == map.end()) {
+            throw std::runtime_error(std::string("Unknown ") + what + " '" + key + "'");
+        }
+        return it->second;
+    };
+    for (const auto& [key, value] : settings) {
+        try {
+            if (key == "problem") state.problem = lookup(problems, value, "problem type");
+            else if (key == "dataset") { state.dataset = lookup(datasets, value, "dataset"); state.datasetKey = value; }
+            else if (key == "regDataset") { state.regDataset = lookup(regDatasets, value, "dataset"); state.regDatasetKey = value; }
+            else if (key == "activation") { lookup(activations, value, "activation"); state.activationKey = value; }
+            else if (key == "regularization") state.regularization = lookup(regularizations, value, "regularization");
+            else if (key == "optimizer") { lookup(optimizers, value, "optimizer"); state.optimizerKey = value; }
+            else if (key == "lbfgs") state.lbfgs = value == "1";
+            else if (key == "lbfgsHistory") state.lbfgsHistory = std::max(1, std::stoi(value));
+            else if (key == "fastActivations") state.fastActivations = value == "1";
+            else if (key == "learningRate") state.learningRate = std::stof(value);
+            else if (key == "regularizationRate") state.regularizationRate = std::stof(value);
+            else if (key == "noise") state.noise = std::stof(value);
+            else if (key == "batchSize") state.batchSize = std::max(1, std::stoi(value));
+            else if (key == "percTrainData") state.percTrainData = std::stoi(value);
+            else if (key == "numSamples") state.numSamples = std::stoi(value);
+            else if (key == "shuffleBlockSize") state.shuffleBlockSize = std::stoi(value);
+            else if (key == "streaming") state.streaming = value == "1";
+            else if (key == "initZero") state.initZero = value == "1";
+            else if (key == "networkShape") {
+                state.networkShape.clear();
+                std::stringstream layers(value);
+                std::string layer;
+                while (std::getline(layers, layer, ',')) {
+                    state.networkShape.push_back(std::max(1, std::stoi(layer)));
+                }
+                state.numHiddenLayers = static_cast<int>(state.networkShape.size());
+            }
+            else if (key == "seed") state.seed = value;
+            else if (key == "x") state.x = value == "1";
+            else if (key == "y") state.y = value == "1";
+            else if (key == "xSquared") state.xSquared = value == "1";
+            else if (key == "ySquared") state.ySquared = value == "1";
+            else if (key == "xTimesY") state.xTimesY = value == "1";
+            else if (key == "sinX") state.sinX = value == "1";
+            else if (key == "axisX") state.axisX = std::stoi(value);
+            else if (key == "axisY") state.axisY = std::stoi(value);
+            else throw std::runtime_error("Unknown setting '" + key + "'");
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Malformed value '" + value + "' for setting '" + key + "'");
+        }
+    }
+    return state;
+}
+
+// --- Session Implementation ---
+
+Session::~Session() {
+    if (!network.empty()) {
+        nn::deleteNetwork(network);
+    }
+}
+
+std::string Session::loadDatasetFile(const std::string& path) {
+    auto dataset = std::make_shared<const playground::MappedDataset>(path);
+
+    std::string name = path.substr(path.find_last_of("/\\") + 1);
+    name = name.substr(0, name.find_last_of('.'));
+
+    if (dataset->isClassification()) {
+        datasets[name] = playground::makeFileGenerator(dataset);
+        classificationFiles.push_back(name);
+    } else {
+        regDatasets[name] = playground::makeFileGenerator(dataset);
+        regressionFiles.push_back(name);
+    }
+    return name;
+}
+
+void Session::selectDataset(const std::string& key) {
+    bool regression = state.problem == Problem::REGRESSION;
+    const auto& registry = regression ? regDatasets : datasets;
+    auto it = registry.find(key);
+    if (it == registry.end()) {
+        throw std::runtime_error("Unknown dataset '" + key + "'");
+    }
+    if (regression) {
+        state.regDataset = it->second;
+        state.regDatasetKey = key;
+    } else {
+        state.dataset = it->second;
+        state.datasetKey = key;
+    }
+}
+
+void Session::saveCheckpoint(const std::string& path) {
+    nn::saveCheckpoint(path, network, iter, stateSettings(state));
+}
+
+void Session::exportSource(const std::string& path, const std::string& name) {
+    nn::ActivationKind activation, outputKind;
+    if (!nn::activationKindOf(&hiddenActivation(), activation) ||
+        !nn::activationKindOf(&outputActivation(), outputKind)) {
+        throw std::runtime_error("Only built-in activation functions can be exported");
+    }
+    std::vector<std::string> arguments, inputs;
+    if (data.numFeatures() > 2) {
+        // The input ids of tabular data are already argument names.
+        arguments = inputs = constructInputIds();
+    } else {
+        arguments = {"x", "y"};
+        for (const std::string& id : constructInputIds()) {
+            for (const InputFeature& feature : INPUTS) {
+                if (id == feature.name) inputs.push_back(feature.source);
+            }
+        }
+    }
+    std::ofstream out(path);
+    out << nn::generateSource(network, activation, outputKind, arguments, inputs, name);
+    if (!out.good()) {
+        throw std::runtime_error("Could not write '" + path + "'");
+    }
+}
+
+void Session::loadCheckpoint(const std::string& path) {
+    nn::MappedCheckpoint checkpoint(path);
+    State restored = applySettings(state, checkpoint.metadata());
+    std::vector<int> shape = checkpoint.shape();
+    restored.networkShape.assign(shape.begin() + 1, shape.end() - 1);
+    restored.numHiddenLayers = static_cast<int>(restored.networkShape.size());
+    state = restored;
+
+    reset(true, &checkpoint);
+    if (checkpoint.inputIds() != constructInputIds()) {
+        throw std::runtime_error("Checkpoint '" + path + "' does not match the inputs of its dataset");
+    }
+}
+
+void Session::applyOverrides(const std::map<std::string, std::string>& settings) {
+    static const char* const TRAINING_KEYS[] = {"optimizer", "lbfgs", "lbfgsHistory", "fastActivations",
+                                                "learningRate", "regularizationRate", "batchSize"};
+    State next = applySettings(state, settings);
+    std::map<std::string, std::string> before = stateSettings(state), after = stateSettings(next);
+    for (const auto& entry : settings) {
+        const std::string& key = entry.first;
+        bool training = std::any_of(std::begin(TRAINING_KEYS), std::end(TRAINING_KEYS),
+                                    [&key](const char* name) { return key == name; });
+        if (!training && before[key] != after[key]) {
+            throw std::runtime_error("Setting '" + key + "' cannot be changed on a running session");
+        }
+    }
+
+    state.learningRate = next.learningRate;
+    state.regularizationRate = next.regularizationRate;
+    if (next.batchSize != state.batchSize) {
+        state.batchSize = next.batchSize;
+        // The stream produces batches of a fixed size; the data is seeded,
+        // so regenerating it only restarts the stream.
+        if (stream) generateData();
+    }
+    // Before the optimizer: switching activations rebuilds the kernel and
+    // the optimizer state.
+    if (next.fastActivations != state.fastActivations) {
+        setFastActivations(next.fastActivations);
+    }
+    if (next.optimizerKey != state.optimizerKey) {
+        setOptimizer(next.optimizerKey);
+    }
+    if (next.lbfgs != state.lbfgs || next.lbfgsHistory != state.lbfgsHistory) {
+        setLbfgs(next.lbfgs, next.lbfgsHistory);
+    }
+}
+
+void Session::reset(bool keepSeed, const nn::MappedCheckpoint* checkpoint) {
+    if (!keepSeed || state.seed.empty()) {
+        // Change seed
+        state.seed = rng::randomSeedString();
+    }
+    seed = rng::seedFromString(state.seed);
+
+    if (!network.empty()) {
+        nn::deleteNetwork(network);
+    }
+    iter = 0;
+
+    // The data comes first: its number of features decides the input layer.
+    generateData();
+
+    auto inputIds = constructInputIds();
+    std::vector<int> shape = { (int)inputIds.size() };
+    shape.insert(shape.end(), state.networkShape.begin(), state.networkShape.end());
+    shape.push_back(1);
+
+    const nn::ActivationFunction& activation = hiddenActivation();
+    if (checkpoint && checkpoint->shape() == shape && checkpoint->inputIds() == inputIds) {
+        network = nn::restoreNetwork(*checkpoint, activation, outputActivation(), state.regularization);
+        iter = static_cast<int>(checkpoint->iteration());
+    } else {
+        network = nn::buildNetwork(shape, activation, outputActivation(), state.regularization, inputIds,
+                                   state.initZero, seed);
+    }
+
+    prepareNetwork();
+}
+
+void Session::prepareNetwork() {
+    std::vector<int> shape;
+    for (const auto& layer : network) {
+        shape.push_back(static_cast<int>(layer.size()));
+    }
+    resetOptimizer();
+    kernel.reset();
+    nn::ActivationKind activationKind, outputKind;
+    nn::RegularizationKind regularizationKind;
+    if (nn::activationKindOf(&hiddenActivation(), activationKind) &&
+        nn::activationKindOf(&outputActivation(), outputKind) &&
+        nn::regularizationKindOf(state.regularization, regularizationKind)) {
+        kernel = nn::makeKernel(shape, activationKind, outputKind, regularizationKind);
+        if (kernel) {
+            kernel->load(network);
+        }
+    }
+    input.assign(shape[0], 0.0);
+    // Row buffers are sized for the new input width on first use.
+    rows.clear();
+    targets.clear();
+    outputs.clear();
+    updateLosses();
+}
+
+void Session::resetOptimizer() {
+    size_t numLinks = 0;
+    for (size_t l = 1; l < network.size(); ++l) {
+        numLinks += network[l - 1].size() * network[l].size();
+    }
+    optimizer = nn::Optimizer(optimizers.at(state.optimizerKey));
+    optimizer.reset(numLinks, nn::getOutputNode(network)->id + 1);
+
+    lbfgs.reset();
+    if (state.lbfgs && !stream) {
+        std::vector<double> params(nn::numParameters(network));
+        nn::getParameters(network, params.data());
+        lbfgs = std::make_unique<nn::Lbfgs>(params.size(), state.lbfgsHistory);
+        lbfgs->reset(params.data());
+        lbfgsObjective = [this](const double* x, double* gradient) { return fullBatchLoss(x, gradient); };
+    }
+}
+
+void Session::setLbfgs(bool enabled, int history) {
+    state.lbfgs = enabled;
+    state.lbfgsHistory = std::max(1, history);
+    resetOptimizer();
+}
+
+double Session::fullBatchLoss(const double* params, double* gradient) {
+    nn::setParameters(network, params);
+    if (kernel) {
+        kernel->load(network);
+    }
+    const size_t BLOCK = 256;
+    reserveRows(BLOCK);
+    double totalLoss = 0;
+    for (size_t first = 0; first < numTrain; first += BLOCK) {
+        size_t count = std::min(BLOCK, numTrain - first);
+        for (size_t j = 0; j < count; ++j) {
+            data.point(first + j, point.data());
+            addRow(j, point.data(), data.label(first + j));
+        }
+        trainRows(count);
+        for (size_t j = 0; j < count; ++j) {
+            totalLoss += nn::Errors::SQUARE.error(outputs[j], targets[j]);
+        }
+    }
+    if (kernel) {
+        kernel->store(network);
+    }
+    nn::collectGradient(network, gradient);
+    double loss = numTrain > 0 ? totalLoss / numTrain : 0;
+
+    // The regularization penalty that updateWeights steps along.
+    if (state.regularization) {
+        for (const auto& layer : network) {
+            for (const nn::Node* node : layer) {
+                for (const nn::Link* link : node->inputLinks) {
+                    if (link->isDead) continue;
+                    loss += state.regularizationRate * state.regularization->output(link->weight);
+                    gradient[link->id] += state.regularizationRate * state.regularization->der(link->weight);
+                }
+            }
+        }
+    }
+    return loss;
+}
+
+void Session::setOptimizer(const std::string& key) {
+    if (optimizers.count(key) == 0) {
+        throw std::runtime_error("Unknown optimizer '" + key + "'");
+    }
+    state.optimizerKey = key;
+    resetOptimizer();
+}
+
+const nn::ActivationFunction& Session::hiddenActivation() const {
+    const nn::ActivationFunction* activation = activations.at(state.activationKey);
+    if (state.fastActivations && activation == &nn::Activations::TANH) return nn::Activations::FAST_TANH;
+    if (state.fastActivations && activation == &nn::Activations::SIGMOID) return nn::Activations::FAST_SIGMOID;
+    return *activation;
+}
+
+const nn::ActivationFunction& Session::outputActivation() const {
+    if (state.problem == Problem::REGRESSION) {
+        return nn::Activations::LINEAR;
+    }
+    return state.fastActivations ? nn::Activations::FAST_TANH : nn::Activations::TANH;
+}
+
+void Session::resizeLayer(size_t layer, int width) {
+    state.networkShape.at(layer) = width;
+    auto& nodes = network[layer + 1];
+    while (static_cast<int>(nodes.size()) < width) {
+        // Keyed by the width, so a replayed sequence of edits splits the
+        // same nodes.
+        nn::addNode(network, layer + 1, rng::mix64(seed ^ (layer << 32) ^ nodes.size()));
+    }
+    while (static_cast<int>(nodes.size()) > width) {
+        nn::removeNode(network, layer + 1, nodes.size() - 1);
+    }
+    prepareNetwork();
+}
+
+void Session::addLayer() {
+    size_t layer = network.size() - 1;
+    nn::insertLayer(network, layer, hiddenActivation(), state.regularization);
+    state.networkShape.push_back(static_cast<int>(network[layer].size()));
+    state.numHiddenLayers++;
+    prepareNetwork();
+}
+
+void Session::removeLayer() {
+    if (state.numHiddenLayers == 0) {
+        return;
+    }
+    nn::removeLayer(network, network.size() - 2);
+    state.networkShape.pop_back();
+    state.numHiddenLayers--;
+    prepareNetwork();
+}
+
+void Session::setInput(InputId id, bool enabled) {
+    bool* flags[NUM_INPUTS] = {&state.x, &state.y, &state.xSquared, &state.ySquared, &state.xTimesY, &state.sinX};
+    *flags[id] = enabled;
+    if (data.numFeatures() > 2) {
+        return; // The features are the inputs; the flags do not apply.
+    }
+    // Enabled inputs keep the order of INPUTS in the input layer.
+    size_t index = 0;
+    for (int i = 0; i < id; ++i) {
+        index += *flags[i];
+    }
+    auto& inputLayer = network[0];
+    bool present = index < inputLayer.size() && inputLayer[index]->label == INPUTS[id].name;
+    if (enabled && !present) {
+        nn::addInput(network, index, INPUTS[id].name, state.regularization);
+    } else if (!enabled && present) {
+        nn::removeNode(network, 0, index);
+    } else {
+        return;
+    }
+    prepareNetwork();
+}
+
+void Session::setActivation(const std::string& key) {
+    activations.at(key); // Throws on an unknown key before anything changes.
+    state.activationKey = key;
+    nn::setActivation(network, hiddenActivation());
+    prepareNetwork();
+}
+
+void Session::setFastActivations(bool enabled) {
+    state.fastActivations = enabled;
+    nn::setActivation(network, hiddenActivation());
+    nn::getOutputNode(network)->activation = outputActivation();
+    prepareNetwork();
+}
+
+void Session::step() {
+    if (lbfgs) {
+        if (lbfgs->status() != nn::Lbfgs::Status::RUNNING) {
+            return;
+        }
+        iter++;
+        lbfgs->step(lbfgsObjective);
+        // The line search may have evaluated points it then rejected.
+        nn::setParameters(network, lbfgs->x().data());
+        if (kernel) {
+            kernel->load(network);
+        }
+        return;
+    }
+    iter++;
+    reserveRows(state.batchSize);
+    size_t numRows = 0;
+    if (stream) {
+        // Online training loss: each example is scored before the update it
+        // contributes to, and is never seen again.
+        double totalLoss = 0;
+        size_t numBatches = (streamedEpochSize + state.batchSize - 1) / state.batchSize;
+        for (size_t b = 0; b < numBatches; ++b) {
+            const playground::Batch& batch = stream->acquire();
+            reserveRows(batch.size());
+            for (size_t j = 0; j < batch.size(); ++j) {
+                double streamed[2] = {batch.x[j], batch.y[j]};
+                addRow(numRows++, streamed, batch.label[j]);
+            }
+            stream->release();
+            trainRows(numRows);
+            for (size_t j = 0; j < numRows; ++j) {
+                totalLoss += nn::Errors::SQUARE.error(outputs[j], targets[j]);
+            }
+            numRows = 0;
+            applyUpdate();
+        }
+        streamedLoss = numBatches > 0 ? totalLoss / (numBatches * state.batchSize) : 0;
+    } else {
+        playground::permutation(trainOrder, numTrain, state.shuffleBlockSize, seed, iter);
+        for (size_t i = 0; i < trainOrder.size(); ++i) {
+            uint32_t k = trainOrder[i];
+            data.point(k, point.data());
+            addRow(numRows++, point.data(), data.label(k));
+            if ((i + 1) % state.batchSize == 0) {
+                trainRows(numRows);
+                numRows = 0;
+                applyUpdate();
+            }
+        }
+        // A partial last batch is accumulated and applied with the next one.
+        trainRows(numRows);
+    }
+    if (kernel) {
+        kernel->store(network);
+    }
+}
+
+void Session::reserveRows(size_t count) {
+    if (targets.size() < count) {
+        rows.resize(count * input.size());
+        targets.resize(count);
+        outputs.resize(count);
+    }
+}
+
+void Session::addRow(size_t row, const double* point, double label) {
+    constructInput(point, &rows[row * input.size()]);
+    targets[row] = label;
+}
+
+void Session::trainRows(size_t count) {
+    if (kernel) {
+        kernel->train(rows.data(), targets.data(), count, outputs.data());
+        return;
+    }
+    for (size_t b = 0; b < count; ++b) {
+        std::copy_n(&rows[b * input.size()], input.size(), input.begin());
+        outputs[b] = nn::forwardProp(network, input);
+        nn::backProp(network, targets[b], nn::Errors::SQUARE);
+    }
+}
+
+void Session::applyUpdate() {
+    if (kernel) {
+        kernel->update(state.learningRate, state.regularizationRate, optimizer);
+    } else {
+        nn::updateWeights(network, state.learningRate, state.regularizationRate, optimizer);
+    }
+}
+
+void Session::updateLosses() {
+    testLoss = networkLoss(testData());
+    if (stream) {
+        // Before the first epoch the test split is an unbiased estimate.
+        trainLoss = iter == 0 ? testLoss : streamedLoss;
+    } else {
+        trainLoss = networkLoss(trainData());
+    }
+}
+
+void Session::generateData() {
+    int numSamples = state.numSamples;
+    auto generator = (state.problem == Problem::CLASSIFICATION) ? state.dataset : state.regDataset;
+
+    stream.reset();
+    bool classification = state.problem == Problem::CLASSIFICATION;
+    playground::GeneratorKernel generatorKernel = playground::kernelFor(generator);
+    if (state.streaming && generatorKernel) {
+        // Only the test split is materialized; training batches are produced
+        // ahead of the trainer on the stream's own thread. Generators always
+        // produce numSamples examples.
+        size_t splitIndex = static_cast<size_t>(numSamples * state.percTrainData / 100.0);
+        streamedEpochSize = splitIndex;
+        stream = std::make_unique<playground::BatchStream>(generatorKernel, splitIndex, state.batchSize, state.noise, seed);
+        data = playground::makeDataset(generator, numSamples - static_cast<int>(splitIndex), state.noise, seed,
+                                       classification, dataThreads);
+        numTrain = 0;
+    } else {
+        // Shuffled through a row index, so a mapped file is not copied; the
+        // splits are views into it.
+        data = playground::makeDataset(generator, numSamples, state.noise, seed, classification, dataThreads)
+                   .shuffled(seed);
+        // Split what was produced: a dataset file may hold fewer rows than
+        // numSamples.
+        numTrain = static_cast<size_t>(data.size() * state.percTrainData / 100.0);
+        trainOrder.clear();
+    }
+
+    point.assign(std::max<size_t>(2, data.numFeatures()), 0.0);
+}
+
+playground::Dataset Session::trainData() const {
+    return data.slice(0, numTrain);
+}
+
+playground::Dataset Session::testData() const {
+    return data.slice(numTrain, data.size() - numTrain);
+}
+
+std::vector<std::string> Session::constructInputIds() const {
+    std::vector<std::string> result;
+    if (data.numFeatures() > 2) {
+        // Tabular data: every column is an input, named after its position.
+        for (size_t c = 0; c < data.numFeatures(); ++c) {
+            result.push_back("x" + std::to_string(c + 1));
+        }
+        return result;
+    }
+    if (state.x) result.push_back(INPUTS[INPUT_X].name);
+    if (state.y) result.push_back(INPUTS[INPUT_Y].name);
+    if (state.xSquared) result.push_back(INPUTS[INPUT_X_SQUARED].name);
+    if (state.ySquared) result.push_back(INPUTS[INPUT_Y_SQUARED].name);
+    if (state.xTimesY) result.push_back(INPUTS[INPUT_X_TIMES_Y].name);
+    if (state.sinX) result.push_back(INPUTS[INPUT_SIN_X].name);
+    return result;
+}
+
+size_t Session::numInputs() const {
+    if (data.numFeatures() > 2) {
+        return data.numFeatures();
+    }
+    return state.x + state.y + state.xSquared + state.ySquared + state.xTimesY + state.sinX;
+}
+
+std::vector<double> Session::constructInput(const double* point) const {
+    std::vector<double> result(numInputs());
+    constructInput(point, result.data());
+    return result;
+}
+
+void Session::constructInput(const double* point, double* input) const {
+    if (data.numFeatures() > 2) {
+        std::copy(point, point + data.numFeatures(), input);
+        return;
+    }
+    double x = point[0];
+    double y = point[1];
+    if (state.x) *input++ = INPUTS[INPUT_X].f(x, y);
+    if (state.y) *input++ = INPUTS[INPUT_Y].f(x, y);
+    if (state.xSquared) *input++ = INPUTS[INPUT_X_SQUARED].f(x, y);
+    if (state.ySquared) *input++ = INPUTS[INPUT_Y_SQUARED].f(x, y);
+    if (state.xTimesY) *input++ = INPUTS[INPUT_X_TIMES_Y].f(x, y);
+    if (state.sinX) *input++ = INPUTS[INPUT_SIN_X].f(x, y);
+}
+
+double Session::getLoss(nn::Network& net, const playground::Dataset& data) {
+    if (data.empty()) return 0.0;
+    double totalLoss = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        data.point(i, point.data());
+        constructInput(point.data(), input.data());
+        double output = nn::forwardProp(net, input);
+        totalLoss += nn::Errors::SQUARE.error(output, data.label(i));
+    }
+    return totalLoss / data.size();
+}
+
+void Session::predict(const double* points, size_t count, double* result) {
+    size_t stride = point.size();
+    if (!kernel) {
+        for (size_t b = 0; b < count; ++b) {
+            constructInput(points + b * stride, input.data());
+            result[b] = nn::forwardProp(network, input);
+        }
+        return;
+    }
+    const size_t BLOCK = 256;
+    reserveRows(BLOCK);
+    for (size_t first = 0; first < count; first += BLOCK) {
+        size_t rowsInBlock = std::min(BLOCK, count - first);
+        for (size_t b = 0; b < rowsInBlock; ++b) {
+            constructInput(points + (first + b) * stride, &rows[b * input.size()]);
+        }
+        kernel->predict(rows.data(), rowsInBlock, result + first);
+    }
+}
+
+double Session::networkLoss(const playground::Dataset& data) {
+    if (!kernel) {
+        return getLoss(network, data);
+    }
+    if (data.empty()) return 0.0;
+    // Scored in blocks, so that the kernel can batch them.
+    const size_t BLOCK = 256;
+    reserveRows(BLOCK);
+    double totalLoss = 0;
+    for (size_t first = 0; first < data.size(); first += BLOCK) {
+        size_t count = std::min(BLOCK, data.size() - first);
+        for (size_t b = 0; b < count; ++b) {
+            data.point(first + b, point.data());
+            addRow(b, point.data(), data.label(first + b));
+        }
+        kernel->predict(rows.data(), count, outputs.data());
+        for (size_t b = 0; b < count; ++b) {
+            totalLoss += nn::Errors::SQUARE.error(outputs[b], targets[b]);
+        }
+    }
+    return totalLoss / data.size();
+}
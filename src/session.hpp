@@ -0,0 +1,259 @@
+#pragma once
+
+#include "state.hpp"
+#include "nn.hpp"
+#include "dataset.hpp"
+#include "stream.hpp"
+#include "checkpoint.hpp"
+#include "kernels.hpp"
+#include "lbfgs.hpp"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * The features a 2D dataset offers as network inputs, in input layer order.
+ * `name` identifies the input in settings and checkpoints; `label` is shown
+ * in the UI.
+ */
+enum InputId { INPUT_X, INPUT_Y, INPUT_X_SQUARED, INPUT_Y_SQUARED, INPUT_X_TIMES_Y, INPUT_SIN_X, NUM_INPUTS };
+
+struct InputFeature {
+    const char* name;
+    std::function<double(double, double)> f;
+    std::string label;
+    // `f` as C++ source over x and y, for exported networks.
+    const char* source;
+};
+extern const InputFeature INPUTS[NUM_INPUTS];
+
+/**
+ * Hyperparameters of `state` as "key=value" strings. This is the format of
+ * checkpoint metadata and of playground_cli config files.
+ */
+std::map<std::string, std::string> stateSettings(const State& state);
+
+/**
+ * Returns `state` with `settings` applied; keys that are absent keep their
+ * value. Throws std::runtime_error on unknown keys, on names of datasets,
+ * activations or regularizations that are not available, and on malformed
+ * numbers.
+ */
+State applySettings(State state, const std::map<std::string, std::string>& settings);
+
+/**
+ * A training session: the settings, the generated data and the network, and
+ * the epoch loop that trains it. It has no UI dependencies, so the same code
+ * drives the ImGui app and the headless playground_cli.
+ */
+class Session {
+public:
+    Session() = default;
+    ~Session();
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    State state;
+
+    // Threads that generate the data; 0 uses the hardware concurrency. A
+    // sweep already runs a session per core and gives each one thread.
+    unsigned dataThreads = 0;
+
+    /**
+     * Maps a binary dataset file and registers it in `datasets` or
+     * `regDatasets` under the file name without its extension. Returns that
+     * name. Throws std::runtime_error if the file is not a valid dataset.
+     */
+    std::string loadDatasetFile(const std::string& path);
+
+    /**
+     * Selects the dataset named `key` for the current problem type. Throws
+     * std::runtime_error if there is no such dataset for it.
+     */
+    void selectDataset(const std::string& key);
+
+    /**
+     * Regenerates the data and rebuilds the network from `state`. A fresh seed
+     * is drawn unless `keepSeed` is set and state.seed is non-empty. When
+     * `checkpoint` matches the resulting shape, its weights and epoch are
+     * restored instead of initializing the network.
+     */
+    void reset(bool keepSeed = false, const nn::MappedCheckpoint* checkpoint = nullptr);
+
+    // Architecture edits that keep the trained weights, the data and the
+    // epoch count. Each updates `state` and edits the network in place with
+    // the function-preserving nn edits: new neurons split existing ones, new
+    // layers start as the identity and new inputs with zero weights; removed
+    // neurons and inputs take their links with them.
+    // Grows or shrinks hidden layer `layer` (0-based) to `width` neurons.
+    void resizeLayer(size_t layer, int width);
+    // Appends a hidden layer, as wide as the one before it, before the output.
+    void addLayer();
+    // Removes the last hidden layer, folding its weights into the output.
+    void removeLayer();
+    // Adds or removes a 2D input feature.
+    void setInput(InputId id, bool enabled);
+    // Switches the hidden activation to activations[key].
+    void setActivation(const std::string& key);
+    // Switches between the exact and the fast tanh and sigmoid, hidden and
+    // output layers alike; the weights are kept.
+    void setFastActivations(bool enabled);
+
+    // The activations the network is built with: activations[activationKey]
+    // and the output's, with the fast variants substituted when
+    // state.fastActivations is set.
+    const nn::ActivationFunction& hiddenActivation() const;
+    const nn::ActivationFunction& outputActivation() const;
+
+    /**
+     * Switches to the update rule optimizers[key] with fresh state; the
+     * weights are kept. Architecture edits and reset() also restart the
+     * optimizer state, which checkpoints do not save.
+     */
+    void setOptimizer(const std::string& key);
+
+    /**
+     * Switches full-batch L-BFGS training on or off, with `history` stored
+     * steps; it starts from the current weights.
+     */
+    void setLbfgs(bool enabled, int history);
+
+    // The L-BFGS minimizer while state.lbfgs is in effect, null otherwise.
+    // Its status tells whether training has converged; step() then does
+    // nothing.
+    const nn::Lbfgs* lbfgsProgress() const { return lbfgs.get(); }
+
+    /**
+     * Trains for one epoch over the training split (or one streamed epoch).
+     * Losses are not recomputed; call updateLosses() when they are needed.
+     */
+    void step();
+
+    /**
+     * Recomputes lossTrain() and lossTest() for the current network.
+     */
+    void updateLosses();
+
+    /**
+     * Writes the network, the current epoch and stateSettings() to a binary
+     * checkpoint. Throws std::runtime_error on I/O errors.
+     */
+    void saveCheckpoint(const std::string& path);
+
+    /**
+     * Writes the network as a C++ header with `double predict(x, y)` in
+     * namespace `name` (predict(x1, ..., xN) for tabular data), computing
+     * the input features itself; see nn::generateSource. Throws
+     * std::runtime_error for custom activation functions and on I/O errors.
+     */
+    void exportSource(const std::string& path, const std::string& name);
+
+    /**
+     * Applies the settings of a checkpoint, regenerates the data from the
+     * saved seed and restores the saved weights. Throws std::runtime_error if
+     * the file is invalid, names a dataset that is not loaded, or does not
+     * match the inputs of its dataset (the session then holds a freshly
+     * initialized network).
+     */
+    void loadCheckpoint(const std::string& path);
+
+    /**
+     * Changes training settings of a running session, e.g. command-line
+     * overrides after loadCheckpoint, keeping the weights and the epoch.
+     * The optimizer, L-BFGS, fast activations and batch size go through
+     * the same paths as the setters, so training follows them. Settings that decide the data or
+     * the network may only repeat their current value; anything else throws
+     * std::runtime_error and leaves the session unchanged.
+     */
+    void applyOverrides(const std::map<std::string, std::string>& settings);
+
+    std::vector<std::string> constructInputIds() const;
+    std::vector<double> constructInput(const double* point) const;
+    // Writes the network input for `point` to `input` (one value per input id).
+    void constructInput(const double* point, double* input) const;
+    double getLoss(nn::Network& net, const playground::Dataset& data);
+
+    /**
+     * Writes the network output for `count` points, stored row-major with
+     * max(2, numFeatures()) values each, to `outputs`.
+     */
+    void predict(const double* points, size_t count, double* outputs);
+
+    nn::Network& getNetwork() { return network; }
+    const playground::Dataset& getData() const { return data; }
+    playground::Dataset trainData() const;
+    playground::Dataset testData() const;
+
+    // True if training runs on an nn::Kernel rather than the graph engine
+    // (custom activation functions need the graph). The graph is kept in
+    // sync after every step().
+    bool usesKernel() const { return kernel != nullptr; }
+
+    int iteration() const { return iter; }
+    double lossTrain() const { return trainLoss; }
+    double lossTest() const { return testLoss; }
+
+    bool isStreaming() const { return stream != nullptr; }
+    size_t streamedPerEpoch() const { return streamedEpochSize; }
+    // Examples visited by one call to step().
+    size_t examplesPerEpoch() const { return stream ? streamedEpochSize : numTrain; }
+
+    // Names of datasets loaded from files, in `datasets` or `regDatasets`.
+    const std::vector<std::string>& fileDatasets() const { return classificationFiles; }
+    const std::vector<std::string>& fileRegDatasets() const { return regressionFiles; }
+
+private:
+    void generateData();
+    // Picks the kernel for the current network and resizes the buffers.
+    void prepareNetwork();
+    void resetOptimizer();
+    // The L-BFGS objective: mean square error over the training split plus
+    // the regularization penalty, at `params`, and its gradient.
+    double fullBatchLoss(const double* params, double* gradient);
+    size_t numInputs() const;
+    // Training rows: network inputs, targets and the outputs of the last pass.
+    void reserveRows(size_t count);
+    void addRow(size_t row, const double* point, double label);
+    // Forward and backward passes for the first `count` rows, no update.
+    void trainRows(size_t count);
+    void applyUpdate();
+    double networkLoss(const playground::Dataset& data);
+
+    uint64_t seed = 0; // Hash of state.seed; keys every random stream of a run.
+    nn::Network network;
+    // Set at reset() unless the graph engine is needed; it then holds the
+    // authoritative weights during step().
+    std::unique_ptr<nn::Kernel> kernel;
+    // Update rule state for every weight and bias, used by either engine.
+    nn::Optimizer optimizer;
+    std::unique_ptr<nn::Lbfgs> lbfgs;
+    nn::Lbfgs::Objective lbfgsObjective;
+    int iter = 0;
+    double trainLoss = 0;
+    double testLoss = 0;
+
+    // The dataset is stored once, in a shuffled order given by a row index;
+    // the first numTrain examples form the training split and the rest the
+    // test split.
+    playground::Dataset data;
+    size_t numTrain = 0;
+    // Visiting order of the training split, re-permuted every epoch.
+    std::vector<uint32_t> trainOrder;
+    // Scratch row of numFeatures() values, and the network input built from it.
+    std::vector<double> point;
+    std::vector<double> input;
+    // One row of input.size() values per example of a batch.
+    std::vector<double> rows, targets, outputs;
+
+    // In streaming mode `data` only holds the test split and training batches
+    // come from this stream; an epoch is streamedEpochSize examples.
+    std::unique_ptr<playground::BatchStream> stream;
+    size_t streamedEpochSize = 0;
+    double streamedLoss = 0;
+
+    std::vector<std::string> classificationFiles;
+    std::vector<std::string> regressionFiles;
+};
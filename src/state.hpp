@@ -10,8 +10,9 @@
 struct State;
 
 // Maps for converting strings to function pointers
-extern std::map<std::string, nn::ActivationFunction> activations;
+extern std::map<std::string, const nn::ActivationFunction*> activations;
 extern std::map<std::string, const nn::RegularizationFunction*> regularizations;
+extern std::map<std::string, nn::OptimizerKind> optimizers;
 // Use the correct 'playground' namespace
 extern std::map<std::string, playground::DataGenerator> datasets;
 extern std::map<std::string, playground::DataGenerator> regDatasets;
@@ -44,8 +45,23 @@ struct State {
     int batchSize = 10;
     bool discretize = false;
     int percTrainData = 70;
+    int shuffleBlockSize = 0; // 0 shuffles the whole training split each epoch
+    bool streaming = false;   // Generate fresh training batches on the fly
+
+    // Feature columns shown on the plot axes for datasets with more than two
+    // features; the remaining features are held at their mean.
+    int axisX = 0;
+    int axisY = 1;
 
     std::string activationKey = "tanh";
+    // Polynomial approximations of tanh and sigmoid in place of the libm
+    // calls; see nn::Activations::FAST_TANH.
+    bool fastActivations = false;
+    std::string optimizerKey = "sgd";
+    // Full-batch L-BFGS instead of minibatch updates; one epoch is one
+    // L-BFGS iteration. Ignored when streaming.
+    bool lbfgs = false;
+    int lbfgsHistory = 10;
     const nn::RegularizationFunction* regularization = nullptr;
     Problem problem = Problem::CLASSIFICATION;
 
@@ -67,6 +83,9 @@ struct State {
     int numSamples = 500;
     playground::DataGenerator dataset = playground::classifyCircleData;
     playground::DataGenerator regDataset = playground::regressPlane;
+    // Names of `dataset` and `regDataset` in the `datasets`/`regDatasets` maps.
+    std::string datasetKey = "circle";
+    std::string regDatasetKey = "reg-plane";
     std::string seed;
 
     void resetToDefaults() {
@@ -78,7 +97,15 @@ struct State {
         batchSize = 10;
         discretize = false;
         percTrainData = 50;
+        shuffleBlockSize = 0;
+        streaming = false;
+        axisX = 0;
+        axisY = 1;
         activationKey = "tanh";
+        fastActivations = false;
+        optimizerKey = "sgd";
+        lbfgs = false;
+        lbfgsHistory = 10;
         regularization = nullptr;
         problem = Problem::CLASSIFICATION;
         initZero = false;
@@ -93,5 +120,7 @@ struct State {
         sinX = false;
         dataset = playground::classifyCircleData;
         regDataset = playground::regressPlane;
+        datasetKey = "circle";
+        regDatasetKey = "reg-plane";
     }
 };
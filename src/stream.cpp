@@ -0,0 +1,99 @@
+#include "stream.hpp"
+#include "random.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+namespace playground {
+
+BatchStream::BatchStream(GeneratorKernel kernel, size_t epochSize, size_t batchSize, double noise, uint64_t seed,
+                         size_t numBuffers)
+    : kernel(kernel), epochSize(std::min<size_t>(std::max<size_t>(1, epochSize), UINT32_MAX)),
+      batchSize(std::max<size_t>(1, batchSize)), noise(noise), seed(seed), ring(std::max<size_t>(2, numBuffers)) {
+    for (auto& batch : ring) {
+        batch.x.resize(this->batchSize);
+        batch.y.resize(this->batchSize);
+        batch.label.resize(this->batchSize);
+    }
+    producer = std::thread(&BatchStream::produce, this);
+}
+
+BatchStream::~BatchStream() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    freeCondition.notify_all();
+    producer.join();
+}
+
+const Batch& BatchStream::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    readyCondition.wait(lock, [this] { return numReady > 0; });
+    numReady--;
+    numInUse = 1;
+    return ring[head];
+}
+
+void BatchStream::release() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        head = (head + 1) % ring.size();
+        numInUse = 0;
+    }
+    freeCondition.notify_one();
+}
+
+void BatchStream::fill(Batch& batch, uint64_t index) const {
+    const uint64_t n = epochSize;
+    uint64_t currentEpoch = ~0ull;
+    uint64_t multiplier = 1, offset = 0;
+    GeneratorParams params{epochSize, noise, seed};
+
+    for (size_t j = 0; j < batchSize; ++j) {
+        uint64_t sample = index * batchSize + j;
+        uint64_t epoch = sample / n;
+        if (epoch != currentEpoch) {
+            // Each virtual epoch gets its own data seed and its own visiting
+            // order: the affine map l -> (multiplier * l + offset) mod n is a
+            // bijection whenever gcd(multiplier, n) == 1.
+            currentEpoch = epoch;
+            uint64_t key = rng::mix64(seed ^ rng::mix64(epoch + 1));
+            params.seed = key;
+            multiplier = n > 1 ? 1 + rng::mix64(key) % (n - 1) : 1;
+            while (std::gcd(multiplier, n) != 1) {
+                multiplier++;
+            }
+            offset = rng::mix64(key + 1) % n;
+        }
+        uint64_t local = sample % n;
+        // Both factors are below n <= 2^32, so the product fits in 64 bits.
+        uint64_t position = (multiplier * local + offset) % n;
+        kernel(params, position, position + 1, {&batch.x[j], &batch.y[j], &batch.label[j]});
+    }
+    batch.index = index;
+}
+
+void BatchStream::produce() {
+    uint64_t nextIndex = 0;
+    while (true) {
+        size_t slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            freeCondition.wait(lock, [this] { return stopping || numReady + numInUse < ring.size(); });
+            if (stopping) {
+                return;
+            }
+            slot = (head + numInUse + numReady) % ring.size();
+        }
+        // The slot is not visible to the consumer until numReady is bumped.
+        fill(ring[slot], nextIndex++);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            numReady++;
+        }
+        readyCondition.notify_one();
+    }
+}
+
+} // namespace playground
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "dataset.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace playground {
+
+/**
+ * One mini-batch of streamed examples in struct-of-arrays layout.
+ */
+struct Batch {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> label;
+    uint64_t index = 0; // Position of the batch in the stream.
+
+    size_t size() const { return x.size(); }
+};
+
+/**
+ * Generates an unbounded sequence of fresh mini-batches on a producer thread
+ * into a small ring of reusable buffers, so memory stays constant no matter
+ * how long training runs.
+ *
+ * The stream is cut into virtual epochs of `epochSize` samples. Every virtual
+ * epoch is a freshly seeded dataset of that size visited in a pseudo-random
+ * order, so batches follow the same distribution as a materialized dataset
+ * without ever repeating. The contents only depend on the constructor
+ * arguments, never on thread timing. There is a single consumer: at most one
+ * batch is held between `acquire` and `release`. Epochs are capped at 2^32
+ * samples.
+ */
+class BatchStream {
+public:
+    BatchStream(GeneratorKernel kernel, size_t epochSize, size_t batchSize, double noise, uint64_t seed,
+                size_t numBuffers = 4);
+    ~BatchStream();
+
+    BatchStream(const BatchStream&) = delete;
+    BatchStream& operator=(const BatchStream&) = delete;
+
+    /**
+     * Blocks until the next batch is ready. The batch stays valid until
+     * `release` is called.
+     */
+    const Batch& acquire();
+
+    /**
+     * Hands the batch returned by `acquire` back to the producer.
+     */
+    void release();
+
+    /**
+     * Fills `batch` with the batch at position `index` of the stream.
+     */
+    void fill(Batch& batch, uint64_t index) const;
+
+private:
+    void produce();
+
+    GeneratorKernel kernel;
+    size_t epochSize;
+    size_t batchSize;
+    double noise;
+    uint64_t seed;
+
+    std::vector<Batch> ring;
+    size_t head = 0;     // Slot handed out by the next acquire().
+    size_t numReady = 0; // Filled slots waiting for the consumer.
+    size_t numInUse = 0; // Slots between acquire() and release().
+    bool stopping = false;
+
+    std::mutex mutex;
+    std::condition_variable readyCondition;
+    std::condition_variable freeCondition;
+    std::thread producer;
+};
+
+} // namespace playground
@@ -0,0 +1,340 @@
+#include "sweep.hpp"
+#include "population.hpp"
+#include "random.hpp"
+#include "session.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+SweepAxis parseSweepAxis(const std::string& text) {
+    size_t eq = text.find('=');
+    if (eq == std::string::npos || eq == 0 || eq + 1 == text.size()) {
+        throw std::runtime_error("Expected key=value1/value2/... but got '" + text + "'");
+    }
+    SweepAxis axis;
+    axis.key = text.substr(0, eq);
+    std::stringstream values(text.substr(eq + 1));
+    std::string value;
+    while (std::getline(values, value, '/')) {
+        if (!value.empty()) {
+            axis.values.push_back(value);
+        }
+    }
+    if (axis.values.empty()) {
+        throw std::runtime_error("No values for '" + axis.key + "'");
+    }
+    return axis;
+}
+
+// Draws a value of `axis` for the run with the given index.
+static std::string sampleAxis(const SweepAxis& axis, const rng::Stream& stream, uint64_t run, uint32_t draw) {
+    const std::string& value = axis.values[stream.below(axis.values.size(), run, draw)];
+    size_t dots = value.find("..");
+    if (dots == std::string::npos) {
+        return value;
+    }
+    double lo = std::stod(value.substr(0, dots));
+    double hi = std::stod(value.substr(dots + 2));
+    double u = stream.uniform(run, draw + 1);
+    double sampled = lo > 0 && hi > 0 ? lo * std::pow(hi / lo, u) : lo + (hi - lo) * u;
+    std::ostringstream out;
+    out.precision(6);
+    out << sampled;
+    return out.str();
+}
+
+std::vector<std::map<std::string, std::string>> sweepConfigurations(const SweepSpec& spec) {
+    std::vector<std::map<std::string, std::string>> configs;
+    if (spec.randomSamples > 0) {
+        const rng::Stream stream(spec.seed, rng::SWEEP);
+        for (size_t run = 0; run < spec.randomSamples; ++run) {
+            std::map<std::string, std::string> config;
+            for (size_t a = 0; a < spec.axes.size(); ++a) {
+                config[spec.axes[a].key] = sampleAxis(spec.axes[a], stream, run, static_cast<uint32_t>(2 * a));
+            }
+            configs.push_back(config);
+        }
+        return configs;
+    }
+
+    for (const auto& axis : spec.axes) {
+        for (const auto& value : axis.values) {
+            if (value.find("..") != std::string::npos) {
+                throw std::runtime_error("Range '" + value + "' for '" + axis.key + "' needs a random search");
+            }
+        }
+    }
+    // Odometer over the axes; the last axis varies fastest.
+    std::vector<size_t> digits(spec.axes.size(), 0);
+    while (true) {
+        std::map<std::string, std::string> config;
+        for (size_t a = 0; a < spec.axes.size(); ++a) {
+            config[spec.axes[a].key] = spec.axes[a].values[digits[a]];
+        }
+        configs.push_back(config);
+        size_t a = spec.axes.size();
+        while (a > 0 && ++digits[a - 1] == spec.axes[a - 1].values.size()) {
+            digits[--a] = 0;
+        }
+        if (a == 0) {
+            break;
+        }
+    }
+    return configs;
+}
+
+// Trains one configuration to completion.
+static SweepResult runOne(const SweepSpec& spec, size_t index, const std::map<std::string, std::string>& config) {
+    SweepResult result;
+    result.index = index;
+    result.settings = config;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        Session session;
+        session.dataThreads = 1;
+        std::map<std::string, std::string> settings = spec.base;
+        if (!settings.count("seed")) {
+            settings["seed"] = std::to_string(spec.seed);
+        }
+        for (const auto& [key, value] : config) {
+            settings[key] = value;
+        }
+        session.state = applySettings(session.state, settings);
+        session.reset(true);
+
+        for (int epoch = 1; epoch <= spec.epochs; ++epoch) {
+            session.step();
+            if (spec.targetLoss > 0 && result.epochsToTarget < 0) {
+                session.updateLosses();
+                if (session.lossTest() <= spec.targetLoss) {
+                    result.epochsToTarget = epoch;
+                    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                    result.secondsToTarget = elapsed.count();
+                }
+            }
+        }
+        session.updateLosses();
+        result.lossTrain = session.lossTrain();
+        result.lossTest = session.lossTest();
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
+
+// Settings that only change how weights are updated; runs that differ in
+// nothing else can share one Population.
+static bool isLockstepKey(const std::string& key) {
+    return key == "learningRate" || key == "regularizationRate";
+}
+
+// Trains configs[begin, end) as one Population. Mirrors runOne/Session::step
+// step for step, so the losses match separate runs.
+static std::vector<SweepResult> runLockstep(const SweepSpec& spec,
+                                            const std::vector<std::map<std::string, std::string>>& configs,
+                                            size_t begin, size_t end) {
+    size_t K = end - begin;
+    std::vector<SweepResult> results(K);
+    auto start = std::chrono::steady_clock::now();
+    try {
+        std::map<std::string, std::string> settings = spec.base;
+        if (!settings.count("seed")) {
+            settings["seed"] = std::to_string(spec.seed);
+        }
+        std::vector<double> learningRates(K), regularizationRates(K);
+        for (size_t k = 0; k < K; ++k) {
+            results[k].index = begin + k;
+            results[k].settings = configs[begin + k];
+            std::map<std::string, std::string> own = settings;
+            for (const auto& [key, value] : configs[begin + k]) {
+                own[key] = value;
+            }
+            State state = applySettings(State(), own);
+            learningRates[k] = state.learningRate;
+            regularizationRates[k] = state.regularizationRate;
+        }
+
+        // The shared session provides the data, the inputs and the shape.
+        Session session;
+        session.dataThreads = 1;
+        session.state = applySettings(session.state, settings);
+        session.reset(true);
+        const State& state = session.state;
+        uint64_t seed = rng::seedFromString(state.seed);
+
+        std::vector<int> shape;
+        for (const auto& layer : session.getNetwork()) {
+            shape.push_back(static_cast<int>(layer.size()));
+        }
+        nn::ActivationKind activation, outputActivation;
+        nn::RegularizationKind regularization;
+        if (!nn::activationKindOf(&session.hiddenActivation(), activation) ||
+            !nn::activationKindOf(&session.outputActivation(), outputActivation) ||
+            !nn::regularizationKindOf(state.regularization, regularization)) {
+            throw std::runtime_error("Lockstep training needs built-in activation and regularization functions");
+        }
+        nn::Population population(shape, activation, outputActivation, regularization,
+                                  std::vector<uint64_t>(K, seed), state.initZero);
+
+        // Network inputs for every example, computed once.
+        size_t numInputs = static_cast<size_t>(shape[0]);
+        auto featurize = [&](const playground::Dataset& data, std::vector<double>& inputs) {
+            std::vector<double> point(std::max<size_t>(2, data.numFeatures()));
+            inputs.resize(data.size() * numInputs);
+            for (size_t i = 0; i < data.size(); ++i) {
+                data.point(i, point.data());
+                std::vector<double> input = session.constructInput(point.data());
+                std::copy(input.begin(), input.end(), inputs.begin() + i * numInputs);
+            }
+        };
+        playground::Dataset train = session.trainData(), test = session.testData();
+        std::vector<double> trainInputs, testInputs;
+        featurize(train, trainInputs);
+        featurize(test, testInputs);
+
+        std::vector<double> losses(K);
+        auto computeLosses = [&](const playground::Dataset& data, const std::vector<double>& inputs) {
+            std::fill(losses.begin(), losses.end(), 0.0);
+            for (size_t i = 0; i < data.size(); ++i) {
+                const double* out = population.forward(&inputs[i * numInputs]);
+                double label = data.label(i);
+                for (size_t k = 0; k < K; ++k) {
+                    losses[k] += nn::Errors::SQUARE.error(out[k], label);
+                }
+            }
+            for (size_t k = 0; k < K; ++k) {
+                losses[k] = data.empty() ? 0.0 : losses[k] / data.size();
+            }
+        };
+
+        std::vector<uint32_t> order;
+        for (int epoch = 1; epoch <= spec.epochs; ++epoch) {
+            playground::permutation(order, train.size(), state.shuffleBlockSize, seed, epoch);
+            for (size_t i = 0; i < order.size(); ++i) {
+                uint32_t j = order[i];
+                population.forward(&trainInputs[j * numInputs]);
+                population.backward(train.label(j));
+                if ((i + 1) % state.batchSize == 0) {
+                    population.update(learningRates.data(), regularizationRates.data());
+                }
+            }
+            if (spec.targetLoss > 0) {
+                computeLosses(test, testInputs);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                for (size_t k = 0; k < K; ++k) {
+                    if (results[k].epochsToTarget < 0 && losses[k] <= spec.targetLoss) {
+                        results[k].epochsToTarget = epoch;
+                        results[k].secondsToTarget = elapsed.count();
+                    }
+                }
+            }
+        }
+        computeLosses(test, testInputs);
+        for (size_t k = 0; k < K; ++k) results[k].lossTest = losses[k];
+        computeLosses(train, trainInputs);
+        for (size_t k = 0; k < K; ++k) results[k].lossTrain = losses[k];
+    } catch (const std::exception& e) {
+        for (auto& result : results) {
+            result.error = e.what();
+        }
+    }
+    // The networks trained together, so they share the wall time.
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    for (auto& result : results) {
+        result.seconds = elapsed.count();
+    }
+    return results;
+}
+
+void runSweep(const SweepSpec& spec, unsigned numThreads, const std::function<void(const SweepResult&)>& onResult) {
+    std::vector<std::map<std::string, std::string>> configs = sweepConfigurations(spec);
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Work is handed out in groups: one run each, or up to lockstepWidth
+    // runs sharing a Population.
+    bool lockstep = spec.lockstepWidth > 1 &&
+                    std::all_of(spec.axes.begin(), spec.axes.end(),
+                                [](const SweepAxis& axis) { return isLockstepKey(axis.key); });
+    if (lockstep) {
+        // Streamed data is generated per run, and Population only runs
+        // minibatch SGD; bad base settings are reported per run by runOne.
+        try {
+            State base = applySettings(State(), spec.base);
+            lockstep = !base.streaming && base.optimizerKey == "sgd" && !base.lbfgs;
+        } catch (const std::exception&) {
+            lockstep = false;
+        }
+    }
+    size_t groupSize = lockstep ? spec.lockstepWidth : 1;
+    size_t numGroups = (configs.size() + groupSize - 1) / groupSize;
+    numThreads = static_cast<unsigned>(std::min<size_t>(numThreads, numGroups));
+
+    // Runs differ a lot in cost, so workers pull the next group as they
+    // finish instead of taking fixed ranges.
+    std::atomic<size_t> next(0);
+    std::mutex resultMutex;
+    auto worker = [&]() {
+        for (size_t g = next++; g < numGroups; g = next++) {
+            size_t begin = g * groupSize, end = std::min(configs.size(), begin + groupSize);
+            std::vector<SweepResult> results;
+            if (lockstep) {
+                results = runLockstep(spec, configs, begin, end);
+            } else {
+                results.push_back(runOne(spec, begin, configs[begin]));
+            }
+            std::lock_guard<std::mutex> lock(resultMutex);
+            for (const auto& result : results) {
+                onResult(result);
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < numThreads; ++t) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+
+// Quotes a CSV field if it holds a separator (network shapes do).
+static std::string csvField(const std::string& value) {
+    if (value.find_first_of(",\"\n") == std::string::npos) {
+        return value;
+    }
+    std::string quoted = "\"";
+    for (char c : value) {
+        quoted += c;
+        if (c == '"') quoted += '"';
+    }
+    return quoted + "\"";
+}
+
+void writeSweepHeader(std::ostream& out, const SweepSpec& spec) {
+    out << "run";
+    for (const auto& axis : spec.axes) {
+        out << "," << csvField(axis.key);
+    }
+    out << ",train_loss,test_loss,epochs_to_target,seconds_to_target,seconds,error\n";
+}
+
+void writeSweepRow(std::ostream& out, const SweepSpec& spec, const SweepResult& result) {
+    out << result.index;
+    for (const auto& axis : spec.axes) {
+        auto it = result.settings.find(axis.key);
+        out << "," << csvField(it != result.settings.end() ? it->second : "");
+    }
+    out << "," << result.lossTrain << "," << result.lossTest << "," << result.epochsToTarget << ","
+        << result.secondsToTarget << "," << result.seconds << "," << csvField(result.error) << "\n";
+    out.flush();
+}
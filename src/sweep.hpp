@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * One swept setting. `values` are settings strings (see applySettings); in a
+ * random search an entry "lo..hi" is sampled from that numeric range instead,
+ * log-uniformly when both bounds are positive.
+ */
+struct SweepAxis {
+    std::string key;
+    std::vector<std::string> values;
+};
+
+struct SweepSpec {
+    std::map<std::string, std::string> base; // Settings shared by every run.
+    std::vector<SweepAxis> axes;
+    int epochs = 100;
+    // Runs record when their test loss first reaches this value; 0 disables
+    // the check (and the per-epoch loss evaluation it needs).
+    double targetLoss = 0;
+    // 0 runs the full grid; otherwise this many random draws over the axes.
+    size_t randomSamples = 0;
+    uint64_t seed = 1;
+    // When every axis only changes update rates (learningRate,
+    // regularizationRate), runs share their data and network shape and are
+    // trained in lockstep as nn::Populations of up to this many networks.
+    // 0 or 1 trains every run as its own Session.
+    size_t lockstepWidth = 32;
+};
+
+struct SweepResult {
+    size_t index = 0;
+    std::map<std::string, std::string> settings; // The swept values.
+    double lossTrain = 0;
+    double lossTest = 0;
+    int epochsToTarget = -1;   // -1 if the target was never reached.
+    double secondsToTarget = -1;
+    double seconds = 0;        // Wall time of the run, data generation included.
+    std::string error;         // Non-empty if the run could not be set up.
+};
+
+/**
+ * Parses "key=v1/v2/..." into an axis. Throws std::runtime_error if there is
+ * no '=' or no value.
+ */
+SweepAxis parseSweepAxis(const std::string& text);
+
+/**
+ * Expands `spec` into the settings of every run: the cartesian product of the
+ * axes, or `randomSamples` draws from the counter-based RNG. Throws
+ * std::runtime_error if a grid axis holds a range.
+ */
+std::vector<std::map<std::string, std::string>> sweepConfigurations(const SweepSpec& spec);
+
+/**
+ * Trains one Session per configuration on a pool of `numThreads` workers (0
+ * uses every hardware thread); each run generates its data on its worker.
+ * `onResult` is called once per run as it finishes, in completion order,
+ * never concurrently. Unless the seed is set
+ * in `base` or swept, every run uses spec.seed so that all of them see the
+ * same data. Lockstep runs produce the same losses as separate Sessions.
+ */
+void runSweep(const SweepSpec& spec, unsigned numThreads, const std::function<void(const SweepResult&)>& onResult);
+
+/**
+ * Writes the CSV header for the results of `spec`.
+ */
+void writeSweepHeader(std::ostream& out, const SweepSpec& spec);
+
+/**
+ * Writes one result as a CSV row matching writeSweepHeader.
+ */
+void writeSweepRow(std::ostream& out, const SweepSpec& spec, const SweepResult& result);
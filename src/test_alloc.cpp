@@ -0,0 +1,106 @@
+#include "session.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+// Every heap allocation of the process goes through these, so a test can
+// check that a code path does not allocate at all.
+static std::atomic<size_t> numAllocations(0);
+
+void* operator new(std::size_t size) {
+    numAllocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// The steady-state training path of the app: one epoch, the losses, and the
+// network output over a grid of points.
+static void trainingStep(Session& session, const std::vector<double>& grid, std::vector<double>& outputs) {
+    session.step();
+    session.updateLosses();
+    session.getLoss(session.getNetwork(), session.testData());
+    session.predict(grid.data(), outputs.size(), outputs.data());
+}
+
+/**
+ * Warms a session up with `settings`, then checks that further steps do not
+ * allocate. Failures throw, so that they fail the test in every build.
+ */
+static void check_no_allocations(const std::string& name, const std::map<std::string, std::string>& settings) {
+    std::cout << "--- Running Test: No Allocations (" << name << ") ---" << std::endl;
+    Session session;
+    session.state = applySettings(session.state, settings);
+    session.reset(true);
+
+    std::vector<double> grid(2 * 100), outputs(100);
+    for (size_t i = 0; i < grid.size(); ++i) grid[i] = (i % 13) - 6.0;
+    for (int epoch = 0; epoch < 3; ++epoch) {
+        trainingStep(session, grid, outputs);
+    }
+
+    size_t before = numAllocations;
+    for (int epoch = 0; epoch < 10; ++epoch) {
+        trainingStep(session, grid, outputs);
+    }
+    size_t allocations = numAllocations - before;
+    if (allocations != 0) {
+        throw std::runtime_error(std::to_string(allocations) + " allocations in 10 steady-state epochs");
+    }
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+// An activation Session does not recognize, so that it trains on the graph.
+static const nn::ActivationFunction CUSTOM_TANH = {
+    [](double x) { return std::tanh(x); },
+    [](double x) { return 1 - std::tanh(x) * std::tanh(x); },
+};
+
+int main() {
+    try {
+        // The counter must see allocations, or every check below passes.
+        size_t before = numAllocations;
+        std::vector<double> probe(16);
+        if (numAllocations != before + 1) {
+            throw std::runtime_error("allocations are not counted");
+        }
+
+        check_no_allocations("specialized kernel", {{"seed", "1"}, {"batchSize", "10"}});
+        check_no_allocations("dense kernel", {{"seed", "1"}, {"networkShape", "12,12,12"}});
+        check_no_allocations("streaming", {{"seed", "1"}, {"streaming", "1"}});
+        check_no_allocations("adam", {{"seed", "1"}, {"optimizer", "adam"}});
+        check_no_allocations("L-BFGS", {{"seed", "1"}, {"lbfgs", "1"}});
+        activations["customTanh"] = &CUSTOM_TANH;
+        check_no_allocations("graph engine", {{"seed", "1"}, {"activation", "customTanh"}});
+
+        std::cout << "All allocation tests passed successfully!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "A test failed with an exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "nnplayground.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_POINTS 400
+
+/* Unlike assert, evaluates its argument in every build, since the calls
+ * under test are inside it. */
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            fprintf(stderr, "ASSERT FAILED: %s (%s:%d)\n", #condition, __FILE__,     \
+                    __LINE__);                                                        \
+            exit(1);                                                                  \
+        }                                                                             \
+    } while (0)
+
+static void assert_close(double a, double b, double epsilon, const char* msg) {
+    if (fabs(a - b) > epsilon) {
+        fprintf(stderr, "ASSERT FAILED: %g is not close to %g. %s\n", a, b, msg);
+        exit(1);
+    }
+}
+
+/* XOR of the signs on a grid over [-5, 5]^2, as +-1 labels. */
+static void make_xor(double* inputs, double* targets) {
+    for (int i = 0; i < NUM_POINTS; ++i) {
+        double x = -4.75 + 0.5 * (i % 20);
+        double y = -4.75 + 0.5 * (i / 20);
+        inputs[2 * i] = x;
+        inputs[2 * i + 1] = y;
+        targets[i] = x * y >= 0 ? 1.0 : -1.0;
+    }
+}
+
+/**
+ * Trains XOR through the C API, then checks the batch outputs, the
+ * parameter view and a checkpoint round trip.
+ */
+static void test_train_predict_save_load(void) {
+    printf("--- Running Test: C API Train, Predict, Save, Load ---\n");
+    static double inputs[2 * NUM_POINTS], targets[NUM_POINTS], outputs[NUM_POINTS], restored[NUM_POINTS];
+    make_xor(inputs, targets);
+
+    const int shape[] = {2, 8, 4, 1};
+    nnp_network* network = nnp_create(shape, 4, NNP_TANH, NNP_TANH, NNP_REGULARIZATION_NONE, 7);
+    CHECK(network);
+    CHECK(nnp_api_version() == NNP_API_VERSION);
+    CHECK(nnp_num_inputs(network) == 2);
+    /* 2*8 + 8*4 + 4 links and a bias per node, input nodes included. */
+    CHECK(nnp_num_parameters(network) == 52 + 15);
+
+    double first = 0, loss = 0;
+    for (int epoch = 0; epoch < 200; ++epoch) {
+        CHECK(nnp_train(network, inputs, targets, NUM_POINTS, 10, 0.03, 0, &loss) == 0);
+        if (epoch == 0) first = loss;
+    }
+    CHECK(loss < first / 4);
+
+    CHECK(nnp_predict(network, inputs, NUM_POINTS, outputs) == 0);
+    int correct = 0;
+    for (int i = 0; i < NUM_POINTS; ++i) correct += (outputs[i] >= 0) == (targets[i] >= 0);
+    CHECK(correct >= NUM_POINTS * 9 / 10);
+
+    /* Parameters written back unchanged leave the outputs unchanged. */
+    size_t count = nnp_num_parameters(network);
+    double* parameters = malloc(count * sizeof(double));
+    CHECK(nnp_get_parameters(network, parameters) == 0);
+    CHECK(nnp_set_parameters(network, parameters) == 0);
+    CHECK(nnp_predict(network, inputs, NUM_POINTS, restored) == 0);
+    for (int i = 0; i < NUM_POINTS; ++i) assert_close(restored[i], outputs[i], 0, "set_parameters");
+
+    const char* path = "test_c_api_checkpoint.nnck";
+    CHECK(nnp_save_checkpoint(network, path) == 0);
+    nnp_network* loaded = nnp_load_checkpoint(path);
+    CHECK(loaded);
+    CHECK(nnp_predict(loaded, inputs, NUM_POINTS, restored) == 0);
+    for (int i = 0; i < NUM_POINTS; ++i) assert_close(restored[i], outputs[i], 0, "checkpoint round trip");
+    remove(path);
+
+    free(parameters);
+    nnp_destroy(loaded);
+    nnp_destroy(network);
+    printf("PASSED\n\n");
+}
+
+/**
+ * Tests that failures return an error code and a message instead of
+ * throwing through the C boundary.
+ */
+static void test_errors(void) {
+    printf("--- Running Test: C API Errors ---\n");
+    CHECK(nnp_load_checkpoint("does_not_exist.nnck") == NULL);
+    CHECK(nnp_last_error()[0] != '\0');
+
+    const int no_output[] = {2, 3};
+    CHECK(nnp_create(no_output, 2, NNP_RELU, NNP_LINEAR, NNP_REGULARIZATION_L2, 1) == NULL);
+
+    const int shape[] = {2, 1};
+    nnp_network* network = nnp_create(shape, 2, NNP_RELU, NNP_LINEAR, NNP_REGULARIZATION_L2, 1);
+    CHECK(network);
+    double input[2] = {0.5, -0.5}, target = 1.0;
+    CHECK(nnp_train(network, input, &target, 1, 0, 0.1, 0, NULL) == -1);
+    CHECK(nnp_predict(NULL, input, 1, &target) == -1);
+    nnp_destroy(network);
+    nnp_destroy(NULL);
+    printf("PASSED\n\n");
+}
+
+int main(void) {
+    test_train_predict_save_load();
+    test_errors();
+    printf("All C API tests passed successfully!\n");
+    return 0;
+}
@@ -1,4 +1,9 @@
 #include "dataset.hpp"
+#include "stream.hpp"
+#include "dataset_file.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <algorithm> // For std::min
@@ -15,6 +20,9 @@ void print_examples(const std::string& name, const std::vector<playground::Examp
 }
 
 int main() {
+    // Every check reports its own result; any failure fails the run.
+    bool failed = false;
+
     // Test classifyTwoGaussData
     {
         int num_samples_test = 10;
@@ -22,6 +30,7 @@ int main() {
         auto test_data = playground::classifyTwoGaussData(num_samples_test, noise_test);
         if (test_data.size() != num_samples_test) {
             std::cerr << "Test Failed: classifyTwoGaussData generated incorrect number of samples." << std::endl;
+            failed = true;
         } else {
             std::cout << "Test Passed: classifyTwoGaussData" << std::endl;
         }
@@ -34,6 +43,7 @@ int main() {
         auto test_data = playground::classifySpiralData(num_samples_test, noise_test);
         if (test_data.size() != num_samples_test) {
             std::cerr << "Test Failed: classifySpiralData generated incorrect number of samples." << std::endl;
+            failed = true;
         } else {
             std::cout << "Test Passed: classifySpiralData" << std::endl;
         }
@@ -57,6 +67,244 @@ int main() {
             std::cout << "Test Passed: shuffle" << std::endl;
         } else {
             std::cerr << "Test Failed: shuffle did not reorder the data." << std::endl;
+            failed = true;
+        }
+    }
+
+    // Test that a seed fully determines the generated data
+    {
+        auto a = playground::classifySpiralData(200, 0.3, 42);
+        auto b = playground::classifySpiralData(200, 0.3, 42);
+        auto c = playground::classifySpiralData(200, 0.3, 43);
+        bool same = a.size() == b.size();
+        bool differs = false;
+        for (size_t i = 0; same && i < a.size(); ++i) {
+            same = a[i].x == b[i].x && a[i].y == b[i].y && a[i].label == b[i].label;
+            differs = differs || a[i].x != c[i].x;
+        }
+        if (same && differs) {
+            std::cout << "Test Passed: seeded generation" << std::endl;
+        } else {
+            std::cerr << "Test Failed: seeded generation is not reproducible." << std::endl;
+            failed = true;
+        }
+    }
+
+    // Test that parallel generation matches a serial run bit for bit
+    {
+        const playground::GeneratorParams params{100000, 0.2, 5};
+        std::vector<double> serial(3 * params.numSamples), parallel(3 * params.numSamples);
+        double* s = serial.data();
+        double* p = parallel.data();
+        playground::generateParallel(playground::heartKernel, params, {s, s + params.numSamples, s + 2 * params.numSamples}, 1);
+        playground::generateParallel(playground::heartKernel, params, {p, p + params.numSamples, p + 2 * params.numSamples}, 4);
+        if (serial == parallel) {
+            std::cout << "Test Passed: parallel generation" << std::endl;
+        } else {
+            std::cerr << "Test Failed: parallel generation differs from the serial run." << std::endl;
+            failed = true;
+        }
+
+        // The same for a packed Dataset, as a sweep generates it.
+        auto single = playground::makeDataset(playground::classifySpiralData, 100000, 0.2, 5, true, 1);
+        auto threaded = playground::makeDataset(playground::classifySpiralData, 100000, 0.2, 5, true, 4);
+        bool same = single.size() == threaded.size();
+        for (size_t i = 0; same && i < single.size(); ++i) {
+            same = single.x()[i] == threaded.x()[i] && single.y()[i] == threaded.y()[i] &&
+                   single.label(i) == threaded.label(i);
+        }
+        if (same) {
+            std::cout << "Test Passed: dataset thread count" << std::endl;
+        } else {
+            std::cerr << "Test Failed: the dataset depends on the thread count." << std::endl;
+            failed = true;
+        }
+    }
+
+    // Test that streamed batches are deterministic and cover each virtual epoch
+    {
+        playground::BatchStream stream(playground::spiralKernel, 100, 10, 0.1, 9);
+        playground::Batch expected;
+        expected.x.resize(10);
+        expected.y.resize(10);
+        expected.label.resize(10);
+        bool ok = true;
+        int numPositive = 0;
+        for (uint64_t b = 0; b < 10; ++b) {
+            const playground::Batch& batch = stream.acquire();
+            stream.fill(expected, b);
+            ok = ok && batch.index == b && batch.x == expected.x && batch.y == expected.y && batch.label == expected.label;
+            for (double label : batch.label) {
+                numPositive += label > 0;
+            }
+            stream.release();
+        }
+        // The first virtual epoch is a full 100-sample spiral: half positive.
+        if (ok && numPositive == 50) {
+            std::cout << "Test Passed: batch stream" << std::endl;
+        } else {
+            std::cerr << "Test Failed: batch stream is not deterministic or misses samples." << std::endl;
+            failed = true;
+        }
+    }
+
+    // Test CSV -> binary conversion and mapped loading
+    {
+        {
+            std::ofstream csv("test_dataset_roundtrip.csv");
+            csv << "x,y,label\n1.5,-2,1\n0.25,3,0\n-4,0.5,1\n";
+        }
+        bool ok = false;
+        try {
+            size_t rows = playground::convertCsvToDataset("test_dataset_roundtrip.csv", "test_dataset_roundtrip.nnpd");
+            playground::MappedDataset dataset("test_dataset_roundtrip.nnpd");
+            auto generator = playground::makeFileGenerator(
+                std::make_shared<playground::MappedDataset>("test_dataset_roundtrip.nnpd"));
+            auto points = generator(10, 0.0, 0);
+            ok = rows == 3 && dataset.size() == 3 && dataset.isClassification() &&
+                 dataset.column(0)[0] == 1.5f && dataset.column(1)[2] == 0.5f &&
+                 dataset.label(0) == 1 && dataset.label(1) == -1 &&
+                 reinterpret_cast<uintptr_t>(dataset.column(1)) % 64 == 0 &&
+                 points.size() == 3 && points[2].x == -4 && points[1].label == -1;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+        std::remove("test_dataset_roundtrip.csv");
+        std::remove("test_dataset_roundtrip.nnpd");
+        if (ok) {
+            std::cout << "Test Passed: dataset file" << std::endl;
+        } else {
+            std::cerr << "Test Failed: dataset file round trip." << std::endl;
+            failed = true;
+        }
+    }
+
+    // Test that a header whose sizes wrap around is rejected, not mapped
+    {
+        bool ok = true;
+        // numRows * sizeof(float) wraps to 0 and to 16.
+        for (uint64_t numRows : {uint64_t(1) << 62, (uint64_t(1) << 62) + 4}) {
+            playground::DatasetFileHeader header = {};
+            std::memcpy(header.magic, "NNPD", 4);
+            header.version = playground::DATASET_FILE_VERSION;
+            header.numRows = numRows;
+            header.numFeatures = 1;
+            header.labelType = playground::LABELS_FLOAT32;
+            {
+                std::ofstream file("test_dataset_wrap.nnpd", std::ios::binary);
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file << std::string(256, '\0');
+            }
+            try {
+                playground::MappedDataset dataset("test_dataset_wrap.nnpd");
+                ok = false;
+            } catch (const std::runtime_error&) {
+            }
+        }
+        std::remove("test_dataset_wrap.nnpd");
+        if (ok) {
+            std::cout << "Test Passed: wrapping dataset header" << std::endl;
+        } else {
+            std::cerr << "Test Failed: a dataset header with wrapping sizes was accepted." << std::endl;
+            failed = true;
+        }
+    }
+
+    // Test a tabular dataset with more than two features
+    {
+        {
+            std::ofstream csv("test_dataset_wide.csv");
+            csv << "a,b,c,d,target\n1,2,3,4,0.5\n-1,0,2,8,1.5\n";
+        }
+        bool ok = false;
+        try {
+            playground::convertCsvToDataset("test_dataset_wide.csv", "test_dataset_wide.nnpd");
+            auto generator = playground::makeFileGenerator(
+                std::make_shared<playground::MappedDataset>("test_dataset_wide.nnpd"));
+            auto dataset = playground::makeDataset(generator, 2, 0.0, 0, false);
+            double point[4];
+            dataset.point(1, point);
+            auto means = dataset.means();
+            auto range = dataset.range(3);
+            auto projected = dataset.example(0, 2, 3);
+            ok = dataset.size() == 2 && dataset.numFeatures() == 4 && !dataset.isClassification() &&
+                 point[0] == -1 && point[3] == 8 && dataset.label(1) == 1.5 &&
+                 means.size() == 4 && means[1] == 1 && range.first == 4 && range.second == 8 &&
+                 projected.x == 3 && projected.y == 4 && dataset.permuted(5).numFeatures() == 4;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+        std::remove("test_dataset_wide.csv");
+        std::remove("test_dataset_wide.nnpd");
+        if (ok) {
+            std::cout << "Test Passed: N-dimensional dataset" << std::endl;
+        } else {
+            std::cerr << "Test Failed: N-dimensional dataset columns." << std::endl;
+            failed = true;
+        }
+    }
+
+    // Test the struct-of-arrays Dataset against the Example2D generators
+    {
+        auto examples = playground::classifyCircleData(300, 0.1, 3);
+        auto dataset = playground::makeDataset(playground::classifyCircleData, 300, 0.1, 3, true);
+        auto regression = playground::makeDataset(playground::regressPlane, 300, 0.1, 3, false);
+        bool ok = dataset.size() == 300 && dataset.isClassification() && !regression.isClassification();
+        for (size_t i = 0; ok && i < examples.size(); ++i) {
+            ok = dataset.x()[i] == static_cast<float>(examples[i].x) && dataset.label(i) == examples[i].label;
+        }
+        auto test = dataset.slice(200, 1000);
+        ok = ok && test.size() == 100 && test.x() == dataset.x() + 200;
+        auto shuffled = dataset.permuted(11);
+        double labelSum = 0, shuffledSum = 0;
+        for (size_t i = 0; i < dataset.size(); ++i) {
+            labelSum += dataset.label(i);
+            shuffledSum += shuffled.label(i);
+        }
+        ok = ok && shuffled.size() == 300 && labelSum == shuffledSum;
+        // The indexed view visits the same order without copying the columns,
+        // and its slices, ranges and means follow the index.
+        auto indexed = dataset.shuffled(11);
+        auto indexedTail = indexed.slice(250, 50);
+        ok = ok && indexed.x() == dataset.x() && indexedTail.size() == 50 &&
+             indexed.range(1) == dataset.range(1) && indexed.means() == shuffled.means();
+        for (size_t i = 0; ok && i < dataset.size(); ++i) {
+            playground::Example2D a = indexed.example(i), b = shuffled.example(i);
+            ok = a.x == b.x && a.y == b.y && a.label == b.label;
+            if (i >= 250) ok = ok && indexedTail.label(i - 250) == b.label;
+        }
+        if (ok) {
+            std::cout << "Test Passed: Dataset" << std::endl;
+        } else {
+            std::cerr << "Test Failed: Dataset does not match the generated examples." << std::endl;
+            failed = true;
+        }
+    }
+
+    // Test permutation (full and blocked)
+    {
+        bool ok = true;
+        std::vector<uint32_t> order;
+        for (size_t blockSize : {static_cast<size_t>(0), static_cast<size_t>(8)}) {
+            playground::permutation(order, 101, blockSize);
+            std::vector<uint32_t> sorted = order;
+            std::sort(sorted.begin(), sorted.end());
+            for (size_t i = 0; i < sorted.size(); ++i) {
+                if (sorted[i] != i) ok = false;
+            }
+            if (order.size() != 101) ok = false;
+        }
+        // Every block of a blocked shuffle holds one contiguous run of indices.
+        for (size_t begin = 0; begin + 8 <= 96; begin += 8) {
+            uint32_t lo = *std::min_element(order.begin() + begin, order.begin() + begin + 8);
+            uint32_t hi = *std::max_element(order.begin() + begin, order.begin() + begin + 8);
+            if (hi - lo != 7 || lo % 8 != 0) ok = false;
+        }
+        if (ok) {
+            std::cout << "Test Passed: permutation" << std::endl;
+        } else {
+            std::cerr << "Test Failed: permutation is not a valid (blocked) permutation." << std::endl;
+            failed = true;
         }
     }
 
@@ -67,6 +315,7 @@ int main() {
         auto test_data = playground::classifyXORData(num_samples_test, noise_test);
         if (test_data.size() != num_samples_test) {
             std::cerr << "Test Failed: classifyXORData generated incorrect number of samples." << std::endl;
+            failed = true;
         } else {
             std::cout << "Test Passed: classifyXORData" << std::endl;
         }
@@ -79,11 +328,12 @@ int main() {
         auto test_data = playground::classifyCircleData(num_samples_test, noise_test);
         if (test_data.size() != num_samples_test) {
             std::cerr << "Test Failed: classifyCircleData generated incorrect number of samples." << std::endl;
+            failed = true;
         } else {
             std::cout << "Test Passed: classifyCircleData" << std::endl;
         }
     }
 
 
-    return 0;
+    return failed ? 1 : 0;
 }
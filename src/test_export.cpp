@@ -0,0 +1,90 @@
+// The checks are asserts; keep them in release builds too.
+#undef NDEBUG
+#include "session.hpp"
+// Generated at build time by playground_cli --export; see CMakeLists.txt.
+#include "spiral_model.hpp"
+#include "plane_model.hpp"
+#include "fast_model.hpp"
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Helper for comparing floating point numbers
+void assert_close(double a, double b, double epsilon = 1e-9, const std::string& msg = "") {
+    if (std::abs(a - b) > epsilon) {
+        std::cerr << "ASSERT FAILED: " << a << " is not close to " << b << ". " << msg << std::endl;
+        assert(false);
+    }
+}
+
+// The parameters are compile-time constants: six inputs, 6 and 4 hidden
+// nodes and the output, with a bias per node.
+static_assert(sizeof(spiral_model::WEIGHTS) / sizeof(double) == 6 * 6 + 6 * 4 + 4);
+static_assert(sizeof(spiral_model::BIASES) / sizeof(double) == 6 + 6 + 4 + 1);
+
+/**
+ * Checks that the generated `predict` computes what the graph engine
+ * computes for the network in `checkpoint`, over the whole plot.
+ */
+static void check_exported(const std::string& name, const std::string& checkpoint, double (*predict)(double, double)) {
+    std::cout << "--- Running Test: Exported " << name << " ---" << std::endl;
+    Session session;
+    session.loadCheckpoint(checkpoint);
+    size_t points = 0;
+    for (double x = -6; x <= 6; x += 0.25) {
+        for (double y = -6; y <= 6; y += 0.25) {
+            double point[] = {x, y};
+            double exact = nn::forwardProp(session.getNetwork(), session.constructInput(point));
+            assert_close(predict(x, y), exact, 1e-12, name + " differs from forwardProp");
+            points++;
+        }
+    }
+    assert(points == 49 * 49);
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+// An activation Session does not recognize.
+static const nn::ActivationFunction CUSTOM_TANH = {
+    [](double x) { return std::tanh(x); },
+    [](double x) { return 1 - std::tanh(x) * std::tanh(x); },
+};
+
+void test_export_needs_builtin_activations() {
+    std::cout << "--- Running Test: Export Needs Built-In Activations ---" << std::endl;
+    activations["customTanh"] = &CUSTOM_TANH;
+    Session session;
+    session.state = applySettings(session.state, {{"seed", "1"}, {"activation", "customTanh"}});
+    session.reset(true);
+    bool threw = false;
+    try {
+        session.exportSource("unused.hpp", "unused");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    activations.erase("customTanh");
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " DIR (where the build exported the models)" << std::endl;
+        return 2;
+    }
+    std::string dir = argv[1];
+    try {
+        check_exported("spiral (tanh, all features)", dir + "/spiral_model.nnck", spiral_model::predict);
+        check_exported("reg-plane (relu, linear output)", dir + "/plane_model.nnck", plane_model::predict);
+        check_exported("circle (fast sigmoid, fast tanh output)", dir + "/fast_model.nnck", fast_model::predict);
+        test_export_needs_builtin_activations();
+
+        std::cout << "All export tests passed successfully!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "A test failed with an exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,8 +1,18 @@
-#include "playground.hpp"
+// The checks are asserts; keep them in release builds too.
+#undef NDEBUG
+#include "session.hpp"
+#include "kernel_math.hpp"
+#include "sweep.hpp"
+#include "dataset_file.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
 #include <iostream>
 #include <string>
 #include <cmath>
 #include <cassert>
+#include <map>
 
 // Helper for comparing floating point numbers
 void assert_close(double a, double b, double epsilon = 1e-9, const std::string& msg = "") {
@@ -12,16 +22,9 @@ void assert_close(double a, double b, double epsilon = 1e-9, const std::string&
     }
 }
 
-// --- Feature Definitions ---
-struct InputFeature {
-    std::function<double(double, double)> f;
-    std::string label;
-};
-extern std::map<std::string, InputFeature> INPUTS;
-
 void test_x_feature() {
     std::cout << "--- Running Test: X Feature ---" << std::endl;
-    InputFeature feature = INPUTS["x"];
+    InputFeature feature = INPUTS[INPUT_X];
     assert_close(feature.f(1.0, 2.0), 1.0, 1e-9, "X feature failed for (1, 2)");
     assert_close(feature.f(-5.0, 10.0), -5.0, 1e-9, "X feature failed for (-5, 10)");
     assert_close(feature.f(0.0, 0.0), 0.0, 1e-9, "X feature failed for (0, 0)");
@@ -30,7 +33,7 @@ void test_x_feature() {
 
 void test_y_feature() {
     std::cout << "--- Running Test: Y Feature ---" << std::endl;
-    InputFeature feature = INPUTS["y"];
+    InputFeature feature = INPUTS[INPUT_Y];
     assert_close(feature.f(1.0, 2.0), 2.0, 1e-9, "Y feature failed for (1, 2)");
     assert_close(feature.f(-5.0, 10.0), 10.0, 1e-9, "Y feature failed for (-5, 10)");
     assert_close(feature.f(0.0, 0.0), 0.0, 1e-9, "Y feature failed for (0, 0)");
@@ -39,7 +42,7 @@ void test_y_feature() {
 
 void test_x_squared_feature() {
     std::cout << "--- Running Test: X Squared Feature ---" << std::endl;
-    InputFeature feature = INPUTS["xSquared"];
+    InputFeature feature = INPUTS[INPUT_X_SQUARED];
     assert_close(feature.f(2.0, 3.0), 4.0, 1e-9, "X Squared feature failed for (2, 3)");
     assert_close(feature.f(-3.0, 5.0), 9.0, 1e-9, "X Squared feature failed for (-3, 5)");
     assert_close(feature.f(0.0, 0.0), 0.0, 1e-9, "X Squared feature failed for (0, 0)");
@@ -48,7 +51,7 @@ void test_x_squared_feature() {
 
 void test_y_squared_feature() {
     std::cout << "--- Running Test: Y Squared Feature ---" << std::endl;
-    InputFeature feature = INPUTS["ySquared"];
+    InputFeature feature = INPUTS[INPUT_Y_SQUARED];
     assert_close(feature.f(2.0, 3.0), 9.0, 1e-9, "Y Squared feature failed for (2, 3)");
     assert_close(feature.f(3.0, -4.0), 16.0, 1e-9, "Y Squared feature failed for (3, -4)");
     assert_close(feature.f(0.0, 0.0), 0.0, 1e-9, "Y Squared feature failed for (0, 0)");
@@ -57,7 +60,7 @@ void test_y_squared_feature() {
 
 void test_x_times_y_feature() {
     std::cout << "--- Running Test: X Times Y Feature ---" << std::endl;
-    InputFeature feature = INPUTS["xTimesY"];
+    InputFeature feature = INPUTS[INPUT_X_TIMES_Y];
     assert_close(feature.f(2.0, 3.0), 6.0, 1e-9, "X Times Y feature failed for (2, 3)");
     assert_close(feature.f(-2.0, 5.0), -10.0, 1e-9, "X Times Y feature failed for (-2, 5)");
     assert_close(feature.f(0.0, 5.0), 0.0, 1e-9, "X Times Y feature failed for (0, 5)");
@@ -66,13 +69,347 @@ void test_x_times_y_feature() {
 
 void test_sin_x_feature() {
     std::cout << "--- Running Test: Sin(X) Feature ---" << std::endl;
-    InputFeature feature = INPUTS["sinX"];
+    InputFeature feature = INPUTS[INPUT_SIN_X];
     assert_close(feature.f(0.0, 5.0), 0.0, 1e-9, "Sin(X) feature failed for (0, 5)");
     assert_close(feature.f(M_PI / 2.0, 1.0), 1.0, 1e-9, "Sin(X) feature failed for (PI/2, 1)");
     assert_close(feature.f(M_PI, 2.0), 0.0, 1e-9, "Sin(X) feature failed for (PI, 2)");
     std::cout << "PASSED" << std::endl << std::endl;
 }
 
+void test_session_training() {
+    std::cout << "--- Running Test: Headless Session ---" << std::endl;
+    Session session;
+    session.state = applySettings(session.state, {{"dataset", "circle"}, {"seed", "7"}, {"numSamples", "400"}});
+    session.reset(true);
+    assert(session.usesKernel());
+    double initialLoss = session.lossTest();
+    for (int epoch = 0; epoch < 50; ++epoch) {
+        session.step();
+    }
+    session.updateLosses();
+    assert(session.iteration() == 50);
+    assert(session.examplesPerEpoch() == session.trainData().size());
+    assert(session.lossTest() < initialLoss);
+
+    // The same seed reproduces the run exactly.
+    Session replay;
+    replay.state = session.state;
+    replay.reset(true);
+    for (int epoch = 0; epoch < 50; ++epoch) {
+        replay.step();
+    }
+    replay.updateLosses();
+    assert_close(replay.lossTest(), session.lossTest(), 0.0, "Seeded sessions diverged");
+
+    // Regression datasets are not offered for classification.
+    for (const char* key : {"no-such-dataset", "reg-plane"}) {
+        bool threw = false;
+        try {
+            session.selectDataset(key);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    assert(session.state.datasetKey == "circle" && session.state.dataset);
+
+    // A streamed epoch with an empty training split has no loss to report.
+    Session empty;
+    empty.state = applySettings(empty.state, {{"seed", "7"}, {"streaming", "1"}, {"percTrainData", "0"}});
+    empty.reset(true);
+    empty.step();
+    empty.updateLosses();
+    assert(empty.isStreaming() && empty.lossTrain() == 0 && std::isfinite(empty.lossTest()));
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+void test_session_file_dataset() {
+    std::cout << "--- Running Test: Session File Dataset ---" << std::endl;
+    {
+        std::ofstream csv("test_feature_file.csv");
+        for (int i = 0; i < 200; ++i) csv << (i % 20) * 0.5 - 5 << "," << (i / 20) - 5 << "," << (i % 2) << "\n";
+    }
+    playground::convertCsvToDataset("test_feature_file.csv", "test_feature_file.nnpd");
+    Session session;
+    std::string name = session.loadDatasetFile("test_feature_file.nnpd");
+    session.state = applySettings(session.state, {{"seed", "1"}, {"percTrainData", "70"}});
+    session.selectDataset(name);
+    session.reset(true);
+
+    // The split applies to the 200 rows of the file, not to numSamples.
+    assert(session.state.numSamples > 200);
+    assert(session.trainData().size() == 140 && session.testData().size() == 60);
+    session.step();
+    session.updateLosses();
+    assert(session.lossTest() > 0);
+
+    datasets.erase(name);
+    std::remove("test_feature_file.csv");
+    std::remove("test_feature_file.nnpd");
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+void test_session_edits() {
+    std::cout << "--- Running Test: Session Architecture Edits ---" << std::endl;
+    Session session;
+    session.state = applySettings(session.state, {{"dataset", "circle"}, {"seed", "3"}, {"networkShape", "4,2"}});
+    session.reset(true);
+    for (int epoch = 0; epoch < 20; ++epoch) {
+        session.step();
+    }
+    session.updateLosses();
+    double loss = session.lossTest();
+
+    // Function-preserving edits keep the trained loss and the epoch count.
+    session.resizeLayer(0, 6);
+    session.setInput(INPUT_X_SQUARED, true);
+    assert(session.getNetwork()[0].size() == 3 && session.getNetwork()[1].size() == 6);
+    assert(session.state.xSquared && session.state.networkShape[0] == 6);
+    assert(session.constructInputIds()[2] == session.getNetwork()[0][2]->label);
+    assert_close(session.lossTest(), loss, 1e-12, "Edits changed the trained network");
+    assert(session.iteration() == 20 && session.usesKernel());
+
+    session.addLayer();
+    assert(session.state.numHiddenLayers == 3 && session.state.networkShape.back() == 2);
+    session.setActivation("relu");
+    session.removeLayer();
+    session.resizeLayer(0, 3);
+    session.setInput(INPUT_X, false);
+    assert(session.getNetwork().size() == 4 && session.getNetwork()[0].size() == 2);
+    assert(session.getNetwork()[1].size() == 3 && session.state.activationKey == "relu");
+    for (int epoch = 0; epoch < 5; ++epoch) {
+        session.step();
+    }
+    session.updateLosses();
+    assert(session.iteration() == 25 && std::isfinite(session.lossTest()));
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+void test_session_optimizers() {
+    std::cout << "--- Running Test: Session Optimizers ---" << std::endl;
+    // Spiral, where SGD at its best rate is still far from fitting after 100
+    // epochs and Adam is not.
+    std::map<std::string, std::string> settings = {
+        {"dataset", "spiral"}, {"seed", "1"}, {"networkShape", "8,8"}, {"learningRate", "0.03"}};
+    std::map<std::string, double> losses;
+    for (const std::string key : {"sgd", "adam"}) {
+        Session session;
+        settings["optimizer"] = key;
+        session.state = applySettings(session.state, settings);
+        assert(stateSettings(session.state).at("optimizer") == key);
+        session.reset(true);
+        for (int epoch = 0; epoch < 100; ++epoch) {
+            session.step();
+        }
+        session.updateLosses();
+        losses[key] = session.lossTest();
+
+        // Switching keeps the weights.
+        double loss = session.lossTest();
+        session.setOptimizer("rmsprop");
+        session.updateLosses();
+        assert_close(session.lossTest(), loss, 0.0, "Switching optimizers changed the network");
+        assert(session.state.optimizerKey == "rmsprop");
+    }
+    assert(losses["adam"] < losses["sgd"] / 2);
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+void test_session_lbfgs() {
+    std::cout << "--- Running Test: Full-Batch L-BFGS ---" << std::endl;
+    Session session;
+    session.state = applySettings(session.state, {{"problem", "regression"}, {"regDataset", "reg-plane"},
+                                                  {"seed", "1"}, {"lbfgs", "1"}, {"lbfgsHistory", "7"}});
+    assert(stateSettings(session.state).at("lbfgsHistory") == "7");
+    session.reset(true);
+    const nn::Lbfgs* lbfgs = session.lbfgsProgress();
+    assert(lbfgs != nullptr);
+    double previous = session.lossTrain();
+    for (int epoch = 0; epoch < 3000 && lbfgs->status() == nn::Lbfgs::Status::RUNNING; ++epoch) {
+        session.step();
+        if (epoch < 20) {
+            // Full-batch steps never increase the training loss.
+            session.updateLosses();
+            assert(session.lossTrain() <= previous);
+            previous = session.lossTrain();
+        }
+    }
+    assert(lbfgs->status() == nn::Lbfgs::Status::CONVERGED);
+    session.updateLosses();
+    assert(session.lossTrain() < 1e-6);
+    assert_close(session.lossTrain(), lbfgs->loss(), 1e-12, "The session does not hold the L-BFGS point");
+
+    // Converged training stops, and switching back resumes minibatches.
+    int converged = session.iteration();
+    session.step();
+    assert(session.iteration() == converged);
+    session.setLbfgs(false, 7);
+    assert(session.lbfgsProgress() == nullptr);
+    session.step();
+    assert(session.iteration() == converged + 1);
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+void test_session_fast_activations() {
+    std::cout << "--- Running Test: Fast Activations ---" << std::endl;
+    std::map<std::string, std::string> settings = {{"dataset", "spiral"}, {"seed", "1"}, {"networkShape", "8,8"}};
+    Session exact, fast;
+    exact.state = applySettings(exact.state, settings);
+    settings["fastActivations"] = "1";
+    fast.state = applySettings(fast.state, settings);
+    assert(stateSettings(fast.state).at("fastActivations") == "1");
+    exact.reset(true);
+    fast.reset(true);
+    assert(&fast.hiddenActivation() == &nn::Activations::FAST_TANH);
+    assert(&fast.outputActivation() == &nn::Activations::FAST_TANH);
+    assert(nn::getOutputNode(fast.getNetwork())->activation.output(0.4) == nn::fastTanh(0.4));
+    for (int epoch = 0; epoch < 50; ++epoch) {
+        exact.step();
+        fast.step();
+    }
+    exact.updateLosses();
+    fast.updateLosses();
+    // The approximation error stays far below anything training can see.
+    assert_close(fast.lossTest(), exact.lossTest(), 1e-5, "Fast activations changed training");
+
+    // Switching back keeps the weights and restores the exact functions.
+    fast.setFastActivations(false);
+    assert(&fast.hiddenActivation() == &nn::Activations::TANH);
+    fast.updateLosses();
+    assert_close(fast.lossTest(), exact.lossTest(), 1e-5);
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+/**
+ * Tests that overrides on a resumed session change how it trains, not just
+ * its settings, and that data and shape settings cannot be overridden.
+ */
+void test_session_resume_overrides() {
+    std::cout << "--- Running Test: Resume With Overrides ---" << std::endl;
+    const std::string path = "test_feature_resume.nnck";
+    {
+        Session session;
+        session.state = applySettings(session.state, {{"dataset", "spiral"}, {"seed", "2"}, {"networkShape", "6,6"}});
+        session.reset(true);
+        for (int epoch = 0; epoch < 5; ++epoch) session.step();
+        session.saveCheckpoint(path);
+    }
+    // Reference: the resumed session switched through the setter.
+    Session reference;
+    reference.loadCheckpoint(path);
+    reference.setOptimizer("adam");
+    Session resumed, plain;
+    resumed.loadCheckpoint(path);
+    resumed.applyOverrides({{"optimizer", "adam"}, {"dataset", "spiral"}});
+    plain.loadCheckpoint(path);
+    for (int epoch = 0; epoch < 5; ++epoch) {
+        reference.step();
+        resumed.step();
+        plain.step();
+    }
+    for (Session* session : {&reference, &resumed, &plain}) session->updateLosses();
+    assert(stateSettings(resumed.state).at("optimizer") == "adam");
+    assert(resumed.lossTest() == reference.lossTest());
+    assert(resumed.lossTest() != plain.lossTest());
+
+    Session fullBatch;
+    fullBatch.loadCheckpoint(path);
+    assert(fullBatch.lbfgsProgress() == nullptr);
+    fullBatch.applyOverrides({{"lbfgs", "1"}, {"lbfgsHistory", "4"}});
+    assert(fullBatch.lbfgsProgress() != nullptr);
+    int epoch = fullBatch.iteration();
+    fullBatch.step();
+    // One L-BFGS iteration evaluates the full batch at least once.
+    assert(fullBatch.iteration() == epoch + 1 && fullBatch.lbfgsProgress()->evaluations() >= 1);
+
+    // Fast activations reach the nodes and the kernel: the resumed session
+    // trains like one switched through setFastActivations.
+    Session fastReference, fast;
+    fastReference.loadCheckpoint(path);
+    fastReference.setFastActivations(true);
+    fast.loadCheckpoint(path);
+    fast.applyOverrides({{"fastActivations", "1"}});
+    assert(nn::getOutputNode(fast.getNetwork())->activation.output(0.4) == nn::fastTanh(0.4));
+    for (Session* session : {&fastReference, &fast}) {
+        session->step();
+        session->updateLosses();
+    }
+    assert(fast.lossTest() == fastReference.lossTest());
+
+    // A streamed session restarts its stream at the new batch size, so it
+    // trains like one started with it.
+    std::map<std::string, std::string> streaming = {{"dataset", "circle"}, {"seed", "2"}, {"streaming", "1"}};
+    Session streamed, started;
+    streamed.state = applySettings(streamed.state, streaming);
+    streamed.reset(true);
+    streamed.applyOverrides({{"batchSize", "25"}});
+    streaming["batchSize"] = "25";
+    started.state = applySettings(started.state, streaming);
+    started.reset(true);
+    for (Session* session : {&streamed, &started}) {
+        session->step();
+        session->updateLosses();
+    }
+    assert(streamed.lossTest() == started.lossTest());
+
+    bool threw = false;
+    try {
+        resumed.applyOverrides({{"learningRate", "0.1"}, {"networkShape", "3"}});
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(stateSettings(resumed.state).at("learningRate") == stateSettings(plain.state).at("learningRate"));
+    std::remove(path.c_str());
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+void test_sweep() {
+    std::cout << "--- Running Test: Parallel Sweep ---" << std::endl;
+    SweepSpec spec;
+    spec.base = {{"numSamples", "200"}};
+    spec.axes = {parseSweepAxis("learningRate=0.01/0.1/0.3"), parseSweepAxis("networkShape=4,2/3")};
+    spec.epochs = 5;
+    assert(sweepConfigurations(spec).size() == 6);
+
+    std::vector<SweepResult> serial, parallel;
+    runSweep(spec, 1, [&](const SweepResult& r) { serial.push_back(r); });
+    runSweep(spec, 4, [&](const SweepResult& r) { parallel.push_back(r); });
+    assert(serial.size() == 6 && parallel.size() == 6);
+    auto byIndex = [](const SweepResult& a, const SweepResult& b) { return a.index < b.index; };
+    std::sort(parallel.begin(), parallel.end(), byIndex);
+    for (size_t i = 0; i < serial.size(); ++i) {
+        // Runs are independent and seeded, so threading does not change them.
+        assert(serial[i].index == i && parallel[i].index == i && serial[i].error.empty());
+        assert_close(serial[i].lossTest, parallel[i].lossTest, 0.0, "Sweep run depends on threading");
+    }
+
+    // Rate-only sweeps train in lockstep and must match separate Sessions.
+    spec.axes = {parseSweepAxis("learningRate=0.01/0.1/0.3"), parseSweepAxis("regularizationRate=0/0.01")};
+    spec.base["regularization"] = "L1";
+    std::vector<SweepResult> separate, lockstep;
+    spec.lockstepWidth = 0;
+    runSweep(spec, 2, [&](const SweepResult& r) { separate.push_back(r); });
+    spec.lockstepWidth = 4;
+    runSweep(spec, 2, [&](const SweepResult& r) { lockstep.push_back(r); });
+    std::sort(separate.begin(), separate.end(), byIndex);
+    std::sort(lockstep.begin(), lockstep.end(), byIndex);
+    assert(separate.size() == 6 && lockstep.size() == 6);
+    for (size_t i = 0; i < separate.size(); ++i) {
+        assert(lockstep[i].error.empty());
+        assert_close(separate[i].lossTrain, lockstep[i].lossTrain, 1e-12, "Lockstep train loss differs");
+        assert_close(separate[i].lossTest, lockstep[i].lossTest, 1e-12, "Lockstep test loss differs");
+    }
+
+    spec.randomSamples = 8;
+    spec.axes = {parseSweepAxis("learningRate=0.001..0.1")};
+    for (const auto& config : sweepConfigurations(spec)) {
+        double rate = std::stod(config.at("learningRate"));
+        assert(rate >= 0.001 && rate <= 0.1);
+    }
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
 int main() {
     try {
         test_x_feature();
@@ -81,6 +418,14 @@ int main() {
         test_y_squared_feature();
         test_x_times_y_feature();
         test_sin_x_feature();
+        test_session_training();
+        test_session_file_dataset();
+        test_session_edits();
+        test_session_optimizers();
+        test_session_lbfgs();
+        test_session_fast_activations();
+        test_session_resume_overrides();
+        test_sweep();
 
         std::cout << "All feature tests passed successfully!" << std::endl;
     } catch (const std::exception& e) {
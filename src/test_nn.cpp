@@ -1,10 +1,23 @@
+// The checks are asserts; keep them in release builds too.
+#undef NDEBUG
 #include "nn.hpp"
+#include "checkpoint.hpp"
+#include "population.hpp"
+#include "kernels.hpp"
+#include "lbfgs.hpp"
+#include "kernel_math.hpp"
+#include "quantized.hpp"
 #include <iostream>
 #include <vector>
 #include <string>
 #include <cassert>
 #include <cmath>
 #include <numeric>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
 
 // Helper for comparing floating point numbers
 void assert_close(double a, double b, double epsilon = 1e-9, const std::string& msg = "") {
@@ -31,9 +44,12 @@ void test_build_and_delete_network() {
     assert(network[1].size() == 3); // Hidden layer
     assert(network[2].size() == 1); // Output layer
 
-    // Test node IDs
-    assert(network[0][0]->id == "x1");
-    assert(network[0][1]->id == "x2");
+    // Test node IDs and labels
+    assert(network[0][0]->label == "x1");
+    assert(network[0][1]->label == "x2");
+    assert(network[0][0]->id == 0 && network[1][2]->id == 4 && network[2][0]->id == 5);
+    assert(network[1][1]->label.empty());
+    assert(network[1][0]->inputLinks[1]->id == 1 && network[2][0]->inputLinks[2]->id == 8);
 
     // Test link creation
     // Each node in the hidden layer should have 2 input links (from the input layer)
@@ -50,6 +66,37 @@ void test_build_and_delete_network() {
     std::cout << "PASSED" << std::endl << std::endl;
 }
 
+/**
+ * Tests that the seed fully determines the initial weights.
+ */
+void test_seeded_init() {
+    std::cout << "--- Running Test: Seeded Initialization ---" << std::endl;
+
+    std::vector<int> shape = {2, 4, 2, 1};
+    std::vector<std::string> input_ids = {"x1", "x2"};
+    nn::Network a = nn::buildNetwork(shape, nn::Activations::TANH, nn::Activations::TANH, nullptr, input_ids, false, 7);
+    nn::Network b = nn::buildNetwork(shape, nn::Activations::TANH, nn::Activations::TANH, nullptr, input_ids, false, 7);
+    nn::Network c = nn::buildNetwork(shape, nn::Activations::TANH, nn::Activations::TANH, nullptr, input_ids, false, 8);
+
+    bool differs = false;
+    for (size_t l = 1; l < a.size(); ++l) {
+        for (size_t n = 0; n < a[l].size(); ++n) {
+            for (size_t k = 0; k < a[l][n]->inputLinks.size(); ++k) {
+                double w = a[l][n]->inputLinks[k]->weight;
+                assert(w == b[l][n]->inputLinks[k]->weight);
+                assert(w >= -0.5 && w < 0.5);
+                differs = differs || w != c[l][n]->inputLinks[k]->weight;
+            }
+        }
+    }
+    assert(differs);
+
+    nn::deleteNetwork(a);
+    nn::deleteNetwork(b);
+    nn::deleteNetwork(c);
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
 /**
  * Tests the forward propagation logic with known weights.
  */
@@ -187,13 +234,550 @@ void test_full_training_loop_XOR() {
     std::cout << "PASSED" << std::endl << std::endl;
 }
 
+/**
+ * Tests that a checkpoint restores weights, biases, dead links and metadata.
+ */
+void test_checkpoint_round_trip() {
+    std::cout << "--- Running Test: Checkpoint Round Trip ---" << std::endl;
+
+    std::vector<int> shape = {3, 5, 2, 1};
+    std::vector<std::string> input_ids = {"x", "y", "sinX"};
+    nn::Network network = nn::buildNetwork(shape, nn::Activations::RELU, nn::Activations::TANH,
+                                           &nn::RegularizationFunctions::L2, input_ids, false, 42);
+    network[1][2]->bias = -0.75;
+    network[2][1]->inputLinks[3]->isDead = true;
+
+    const std::string path = "test_nn_checkpoint.nnck";
+    nn::saveCheckpoint(path, network, 123, {{"activation", "relu"}, {"learningRate", "0.03"}});
+    {
+        nn::MappedCheckpoint checkpoint(path);
+        assert(checkpoint.shape() == shape);
+        assert(checkpoint.iteration() == 123);
+        assert(checkpoint.inputIds() == input_ids);
+        assert(checkpoint.metadata().at("activation") == "relu");
+        assert(checkpoint.metadata().at("learningRate") == "0.03");
+
+        nn::Network restored = nn::restoreNetwork(checkpoint, nn::Activations::RELU, nn::Activations::TANH,
+                                                  &nn::RegularizationFunctions::L2);
+        std::vector<double> input = {0.3, -1.2, 0.5};
+        assert(nn::forwardProp(restored, input) == nn::forwardProp(network, input));
+        for (size_t l = 0; l < network.size(); ++l) {
+            for (size_t n = 0; n < network[l].size(); ++n) {
+                assert(restored[l][n]->id == network[l][n]->id);
+                assert(restored[l][n]->label == network[l][n]->label);
+                assert(restored[l][n]->bias == network[l][n]->bias);
+                for (size_t k = 0; k < network[l][n]->inputLinks.size(); ++k) {
+                    assert(restored[l][n]->inputLinks[k]->weight == network[l][n]->inputLinks[k]->weight);
+                    assert(restored[l][n]->inputLinks[k]->isDead == network[l][n]->inputLinks[k]->isDead);
+                }
+            }
+        }
+        nn::deleteNetwork(restored);
+    }
+    // A string section size that wraps the end offset around.
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        uint64_t stringBytes = ~uint64_t(0) - 63;
+        file.seekp(offsetof(nn::CheckpointHeader, stringBytes));
+        file.write(reinterpret_cast<const char*>(&stringBytes), sizeof(stringBytes));
+    }
+    bool wrapped = false;
+    try {
+        nn::MappedCheckpoint corrupt(path);
+    } catch (const std::runtime_error& e) {
+        // Rejected by the size check, before any pointer is formed from it.
+        wrapped = std::string(e.what()).find("truncated") != std::string::npos;
+    }
+    assert(wrapped);
+    std::remove(path.c_str());
+
+    bool rejected = false;
+    try {
+        nn::MappedCheckpoint missing(path);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+
+    nn::deleteNetwork(network);
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+/**
+ * Tests that a Population trains each of its networks exactly like a
+ * separately built Network with the same seed and rates.
+ */
+void test_population_lockstep() {
+    std::cout << "--- Running Test: Population Lockstep ---" << std::endl;
+
+    std::vector<int> shape = {2, 4, 3, 1};
+    std::vector<uint64_t> seeds = {1, 2, 3, 4};
+    std::vector<double> learning_rates = {0.01, 0.03, 0.1, 0.3};
+    std::vector<double> regularization_rates = {0.0, 0.001, 0.01, 0.05};
+    std::vector<std::string> input_ids = {"x", "y"};
+
+    nn::Population population(shape, nn::ActivationKind::TANH, nn::ActivationKind::TANH,
+                              nn::RegularizationKind::L1, seeds);
+    std::vector<nn::Network> networks;
+    for (uint64_t seed : seeds) {
+        networks.push_back(nn::buildNetwork(shape, nn::Activations::TANH, nn::Activations::TANH,
+                                            &nn::RegularizationFunctions::L1, input_ids, false, seed));
+    }
+
+    for (int step = 0; step < 200; ++step) {
+        double input[2] = {std::sin(step * 0.7), std::cos(step * 1.3)};
+        double target = input[0] * input[1] > 0 ? 1.0 : -1.0;
+        const double* outputs = population.forward(input);
+        population.backward(target);
+        for (size_t k = 0; k < networks.size(); ++k) {
+            double output = nn::forwardProp(networks[k], {input[0], input[1]});
+            assert_close(outputs[k], output, 1e-12);
+            nn::backProp(networks[k], target, nn::Errors::SQUARE);
+        }
+        if (step % 5 == 4) {
+            population.update(learning_rates.data(), regularization_rates.data());
+            for (size_t k = 0; k < networks.size(); ++k) {
+                nn::updateWeights(networks[k], learning_rates[k], regularization_rates[k]);
+            }
+        }
+    }
+
+    size_t dead = 0;
+    for (size_t k = 0; k < networks.size(); ++k) {
+        size_t node = 0, link = 0;
+        for (size_t l = 0; l < networks[k].size(); ++l) {
+            for (nn::Node* n : networks[k][l]) {
+                if (l > 0) assert_close(population.bias(node, k), n->bias, 1e-12);
+                for (nn::Link* in : n->inputLinks) {
+                    assert_close(population.weight(link, k), in->weight, 1e-12);
+                    dead += in->isDead;
+                    link++;
+                }
+                node++;
+            }
+        }
+        assert(link == population.numLinks());
+        nn::deleteNetwork(networks[k]);
+    }
+    // The strongest L1 rates should have pruned some links.
+    assert(dead > 0);
+
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+/**
+ * Trains a kernel and a graph side by side, in blocks of `batch` examples,
+ * and checks that they end with the same weights, biases and dead links.
+ */
+static void check_kernel_matches_graph(const std::vector<int>& shape, size_t batch,
+                                       nn::OptimizerKind kind = nn::OptimizerKind::SGD) {
+    std::vector<std::string> input_ids;
+    for (int i = 0; i < shape[0]; ++i) input_ids.push_back("x" + std::to_string(i));
+    nn::Network network = nn::buildNetwork(shape, nn::Activations::RELU, nn::Activations::TANH,
+                                           &nn::RegularizationFunctions::L1, input_ids, false, 11);
+    nn::Network reference = nn::buildNetwork(shape, nn::Activations::RELU, nn::Activations::TANH,
+                                             &nn::RegularizationFunctions::L1, input_ids, false, 11);
+    auto kernel = nn::makeKernel(shape, nn::ActivationKind::RELU, nn::ActivationKind::TANH,
+                                 nn::RegularizationKind::L1);
+    assert(kernel != nullptr);
+    kernel->load(network);
+    size_t numLinks = 0;
+    for (size_t l = 1; l < shape.size(); ++l) numLinks += static_cast<size_t>(shape[l - 1]) * shape[l];
+    nn::Optimizer optimizer(kind), referenceOptimizer(kind);
+    optimizer.reset(numLinks, nn::getOutputNode(network)->id + 1);
+    referenceOptimizer.reset(numLinks, nn::getOutputNode(network)->id + 1);
+
+    std::vector<double> inputs(batch * shape[0]), targets(batch), outputs(batch);
+    for (int step = 0; step < 40; ++step) {
+        for (size_t b = 0; b < batch; ++b) {
+            for (int i = 0; i < shape[0]; ++i) inputs[b * shape[0] + i] = std::sin(step * 0.7 + b * 1.3 + i * 0.4);
+            targets[b] = inputs[b * shape[0]] > 0 ? 1.0 : -1.0;
+        }
+        kernel->train(inputs.data(), targets.data(), batch, outputs.data());
+        for (size_t b = 0; b < batch; ++b) {
+            std::vector<double> input(inputs.begin() + b * shape[0], inputs.begin() + (b + 1) * shape[0]);
+            assert_close(outputs[b], nn::forwardProp(reference, input), 1e-12);
+            nn::backProp(reference, targets[b], nn::Errors::SQUARE);
+        }
+        if (step % 3 == 2) {
+            kernel->update(0.1, 0.02, optimizer);
+            nn::updateWeights(reference, 0.1, 0.02, referenceOptimizer);
+        }
+    }
+    // Stored mid-batch: pending accumulators carry over like the graph's, and
+    // the graph continues from the kernel's optimizer state.
+    kernel->store(network);
+    nn::updateWeights(network, 0.1, 0.02, optimizer);
+    nn::updateWeights(reference, 0.1, 0.02, referenceOptimizer);
+
+    size_t dead = 0;
+    for (size_t l = 0; l < network.size(); ++l) {
+        for (size_t n = 0; n < network[l].size(); ++n) {
+            assert_close(network[l][n]->bias, reference[l][n]->bias, 1e-12);
+            for (size_t k = 0; k < network[l][n]->inputLinks.size(); ++k) {
+                nn::Link* link = network[l][n]->inputLinks[k];
+                assert_close(link->weight, reference[l][n]->inputLinks[k]->weight, 1e-12);
+                assert(link->isDead == reference[l][n]->inputLinks[k]->isDead);
+                dead += link->isDead;
+            }
+        }
+    }
+    assert(dead > 0);
+
+    nn::deleteNetwork(network);
+    nn::deleteNetwork(reference);
+}
+
+/**
+ * Tests that the specialized and the dense kernels train exactly like the
+ * graph engine.
+ */
+void test_kernels() {
+    std::cout << "--- Running Test: Training Kernels ---" << std::endl;
+
+    assert(nn::makeKernel({2, 0, 1}, nn::ActivationKind::TANH, nn::ActivationKind::TANH,
+                          nn::RegularizationKind::NONE) == nullptr);
+    check_kernel_matches_graph({3, 4, 2, 1}, 1);  // Specialized, one example at a time.
+    check_kernel_matches_graph({3, 4, 2, 1}, 7);  // Specialized, batched.
+    // Dense, with full and partial tiles and more than one summation block.
+    check_kernel_matches_graph({6, 9, 5, 3, 1}, 10);
+    check_kernel_matches_graph({5, 300, 12, 1}, 37);
+    // Every update rule, on both kinds of kernel.
+    for (nn::OptimizerKind kind : {nn::OptimizerKind::MOMENTUM, nn::OptimizerKind::NESTEROV,
+                                   nn::OptimizerKind::RMSPROP, nn::OptimizerKind::ADAM}) {
+        check_kernel_matches_graph({3, 4, 2, 1}, 7, kind);
+        check_kernel_matches_graph({6, 9, 5, 3, 1}, 10, kind);
+    }
+
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+// Network outputs for a fixed set of inputs.
+static std::vector<double> outputsOn(nn::Network& network, const std::vector<std::vector<double>>& inputs) {
+    std::vector<double> result;
+    for (const auto& input : inputs) {
+        result.push_back(nn::forwardProp(network, input));
+    }
+    return result;
+}
+
+static void assert_same_outputs(const std::vector<double>& a, const std::vector<double>& b, const std::string& msg) {
+    assert(a.size() == b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        assert_close(a[i], b[i], 1e-12, msg);
+    }
+}
+
+/**
+ * Tests that the incremental edits preserve the function where they promise
+ * to, and keep the graph consistent.
+ */
+void test_incremental_edits() {
+    std::cout << "--- Running Test: Incremental Edits ---" << std::endl;
+    nn::Network network = nn::buildNetwork({2, 3, 2, 1}, nn::Activations::TANH, nn::Activations::TANH, nullptr,
+                                           {"x1", "x2"}, false, 5);
+    std::vector<std::vector<double>> inputs = {{0.5, -1.0}, {2.0, 0.3}, {-1.5, -0.2}};
+    std::vector<double> expected = outputsOn(network, inputs);
+
+    // Splitting a neuron keeps the function; ids stay dense.
+    nn::addNode(network, 1, 7);
+    nn::addNode(network, 2, 8);
+    assert(network[1].size() == 4 && network[2].size() == 3);
+    assert(network[2][0]->id == 6 && nn::getOutputNode(network)->id == 9);
+    assert(nn::getOutputNode(network)->inputLinks[2]->id == 22);
+    assert_same_outputs(outputsOn(network, inputs), expected, "Split neuron changed the output");
+
+    // A new input starts with zero weights, wherever it is inserted.
+    nn::addInput(network, 1, "x3", nullptr);
+    assert(network[0].size() == 3 && network[0][1]->label == "x3" && network[0][2]->label == "x2");
+    std::vector<std::vector<double>> wideInputs;
+    for (const auto& input : inputs) wideInputs.push_back({input[0], 4.0, input[1]});
+    assert_same_outputs(outputsOn(network, wideInputs), expected, "New input changed the output");
+    nn::removeNode(network, 0, 1);
+    assert_same_outputs(outputsOn(network, inputs), expected, "Removing the new input changed the output");
+
+    // A linear identity layer, and removing it again, keep the function.
+    nn::insertLayer(network, 2, nn::Activations::LINEAR, nullptr);
+    assert(network.size() == 5 && network[2].size() == 4 && network[3][0]->inputLinks.size() == 4);
+    assert_same_outputs(outputsOn(network, inputs), expected, "Identity layer changed the output");
+    nn::removeLayer(network, 2);
+    assert(network.size() == 4 && network[2][0]->inputLinks[3]->source == network[1][3]);
+    assert_same_outputs(outputsOn(network, inputs), expected, "Removing a linear layer changed the output");
+
+    // Removing a neuron drops its links, and the network still trains.
+    nn::removeNode(network, 1, 0);
+    assert(network[1].size() == 3 && network[0][0]->outputs.size() == 3 && network[2][0]->inputLinks.size() == 3);
+    nn::setActivation(network, nn::Activations::RELU);
+    assert_close(network[1][0]->activation.output(-1.0), 0.0, 0.0, "Activation was not replaced");
+    assert_close(nn::getOutputNode(network)->activation.output(-1.0), std::tanh(-1.0), 1e-15, "Output activation changed");
+    for (int step = 0; step < 5; ++step) {
+        nn::forwardProp(network, inputs[0]);
+        nn::backProp(network, 1.0, nn::Errors::SQUARE);
+        nn::updateWeights(network, 0.1, 0);
+    }
+
+    bool threw = false;
+    try {
+        nn::removeNode(network, 3, 0);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    nn::deleteNetwork(network);
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+/**
+ * Tests the flat parameter view against finite differences, and L-BFGS on
+ * the Rosenbrock function and on a small network.
+ */
+void test_lbfgs() {
+    std::cout << "--- Running Test: L-BFGS ---" << std::endl;
+    nn::Lbfgs rosenbrock(2, 5);
+    const double start[2] = {-1.2, 1.0};
+    rosenbrock.reset(start);
+    nn::Lbfgs::Objective banana = [](const double* x, double* g) {
+        double a = 1 - x[0], b = x[1] - x[0] * x[0];
+        g[0] = -2 * a - 400 * x[0] * b;
+        g[1] = 200 * b;
+        return a * a + 100 * b * b;
+    };
+    for (int i = 0; i < 200 && rosenbrock.step(banana) == nn::Lbfgs::Status::RUNNING; ++i) {}
+    assert(rosenbrock.status() == nn::Lbfgs::Status::CONVERGED);
+    assert_close(rosenbrock.x()[0], 1.0, 1e-6, "Rosenbrock minimum x");
+    assert_close(rosenbrock.x()[1], 1.0, 1e-6, "Rosenbrock minimum y");
+
+    nn::Network network = nn::buildNetwork({2, 3, 1}, nn::Activations::TANH, nn::Activations::LINEAR, nullptr,
+                                           {"x1", "x2"}, false, 3);
+    std::vector<std::vector<double>> inputs = {{0.1, 0.5}, {-1.0, 2.0}, {0.3, -0.7}};
+    std::vector<double> targets = {0.2, -0.5, 0.9};
+    nn::Lbfgs::Objective meanSquareError = [&](const double* params, double* gradient) {
+        nn::setParameters(network, params);
+        double loss = 0;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            loss += nn::Errors::SQUARE.error(nn::forwardProp(network, inputs[i]), targets[i]);
+            nn::backProp(network, targets[i], nn::Errors::SQUARE);
+        }
+        nn::collectGradient(network, gradient);
+        return loss / inputs.size();
+    };
+    size_t n = nn::numParameters(network);
+    assert(n == 9 + 6);
+    std::vector<double> params(n), gradient(n), scratch(n);
+    nn::getParameters(network, params.data());
+    assert_close(params[9 + 5], network[2][0]->bias, 0.0, "Output bias slot");
+    meanSquareError(params.data(), gradient.data());
+    for (size_t i = 0; i < n; ++i) {
+        std::vector<double> shifted = params;
+        shifted[i] += 1e-6;
+        double up = meanSquareError(shifted.data(), scratch.data());
+        shifted[i] -= 2e-6;
+        double down = meanSquareError(shifted.data(), scratch.data());
+        assert_close(gradient[i], (up - down) / 2e-6, 1e-8, "Gradient differs from finite differences");
+    }
+
+    // Three examples, nine weights: the network can fit them exactly.
+    nn::Lbfgs lbfgs(n, 10);
+    lbfgs.reset(params.data());
+    for (int i = 0; i < 200 && lbfgs.step(meanSquareError) == nn::Lbfgs::Status::RUNNING; ++i) {}
+    assert(lbfgs.status() == nn::Lbfgs::Status::CONVERGED && lbfgs.loss() < 1e-10);
+    nn::deleteNetwork(network);
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+/**
+ * Tests the accuracy of the fast activations against libm, and that the
+ * kernels compute them exactly like the graph engine.
+ */
+void test_fast_activations() {
+    std::cout << "--- Running Test: Fast Activations ---" << std::endl;
+    double tanhError = 0, sigmoidError = 0, derivativeError = 0;
+    for (double x = -40; x <= 40; x += 1e-3) {
+        tanhError = std::max(tanhError, std::abs(nn::fastTanh(x) - std::tanh(x)));
+        sigmoidError = std::max(sigmoidError, std::abs(nn::fastSigmoid(x) - 1 / (1 + std::exp(-x))));
+        derivativeError = std::max(derivativeError, std::abs(nn::Activations::FAST_TANH.der(x) -
+                                                             nn::Activations::TANH.der(x)));
+    }
+    assert(tanhError <= 4e-9 && sigmoidError <= 2e-9 && derivativeError <= 1e-8);
+    // Saturation without overflow.
+    assert(nn::fastTanh(1e6) == 1 && nn::fastTanh(-1e6) == -1 && nn::fastTanh(0) == 0);
+    assert(nn::fastSigmoid(-1e6) >= 0 && nn::fastSigmoid(-1e6) < 1e-300 && nn::fastSigmoid(1e6) == 1);
+
+    std::vector<int> shape = {2, 3, 1};
+    nn::Network network = nn::buildNetwork(shape, nn::Activations::FAST_SIGMOID, nn::Activations::FAST_TANH,
+                                           nullptr, {"x", "y"}, false, 5);
+    nn::ActivationKind hidden, output;
+    bool known = nn::activationKindOf(&nn::Activations::FAST_SIGMOID, hidden) &&
+                 nn::activationKindOf(&nn::Activations::FAST_TANH, output);
+    assert(known);
+    auto kernel = nn::makeKernel(shape, hidden, output, nn::RegularizationKind::NONE);
+    kernel->load(network);
+    std::vector<double> input = {0.3, -1.7};
+    double target = 0.5, out;
+    kernel->train(input.data(), &target, 1, &out);
+    assert_close(out, nn::forwardProp(network, input), 1e-15, "Kernel and graph disagree");
+    nn::deleteNetwork(network);
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+/**
+ * Tests that the fixed-point inference matches the graph engine to within
+ * about one colour step of a heatmap, for every layer.
+ */
+void test_quantized_inference() {
+    std::cout << "--- Running Test: Quantized Inference ---" << std::endl;
+    struct Case {
+        std::vector<int> shape;
+        const nn::ActivationFunction* activation;
+        nn::ActivationKind kind;
+        const nn::ActivationFunction* output;
+        nn::ActivationKind outputKind;
+    };
+    const std::vector<Case> cases = {
+        {{2, 4, 2, 1}, &nn::Activations::TANH, nn::ActivationKind::TANH, &nn::Activations::TANH,
+         nn::ActivationKind::TANH},
+        {{5, 8, 8, 1}, &nn::Activations::RELU, nn::ActivationKind::RELU, &nn::Activations::LINEAR,
+         nn::ActivationKind::LINEAR},
+        {{3, 6, 1}, &nn::Activations::SIGMOID, nn::ActivationKind::SIGMOID, &nn::Activations::TANH,
+         nn::ActivationKind::TANH},
+        // A fan-in wide enough to lower the levels below 16 bits.
+        {{6, 300, 40, 1}, &nn::Activations::TANH, nn::ActivationKind::TANH, &nn::Activations::TANH,
+         nn::ActivationKind::TANH},
+    };
+    for (const Case& c : cases) {
+        std::vector<std::string> inputIds;
+        for (int i = 0; i < c.shape[0]; ++i) inputIds.push_back("x" + std::to_string(i));
+        nn::Network network = nn::buildNetwork(c.shape, *c.activation, *c.output, nullptr, inputIds, false, 3);
+        // Trained weights are larger and more uneven than initial ones.
+        nn::forEachNode(network, true, [](nn::Node* node) {
+            node->bias = std::sin(node->id * 1.7);
+            for (nn::Link* link : node->inputLinks) link->weight *= 1 + 2 * std::cos(link->id * 0.9);
+        });
+        nn::QuantizedNetwork quantized(c.shape, c.kind, c.outputKind);
+        quantized.load(network);
+
+        // Inputs as the boundary grid makes them: up to 6, squares to 36.
+        const size_t count = 50;
+        std::vector<double> inputs(count * c.shape[0]);
+        for (size_t i = 0; i < inputs.size(); ++i) inputs[i] = 6 * std::sin(i * 0.61) * (i % 3 ? 1 : 6);
+        quantized.forward(inputs.data(), count);
+        double maxError = 0;
+        for (size_t row = 0; row < count; ++row) {
+            std::vector<double> input(inputs.begin() + row * c.shape[0], inputs.begin() + (row + 1) * c.shape[0]);
+            nn::forwardProp(network, input);
+            for (size_t l = 1; l < network.size(); ++l) {
+                for (size_t n = 0; n < network[l].size(); ++n) {
+                    double output = quantized.nodeOutputs(l, n)[row];
+                    // Relative for unbounded activations.
+                    double error = std::abs(output - network[l][n]->output) /
+                                   std::max(1.0, std::abs(network[l][n]->output));
+                    maxError = std::max(maxError, error);
+                }
+            }
+        }
+        // A heatmap colour step is about 1/240 of the output range.
+        if (maxError > 5e-3) {
+            std::cerr << "Quantization error " << maxError << std::endl;
+        }
+        assert(maxError <= 5e-3);
+        nn::deleteNetwork(network);
+    }
+    std::cout << "PASSED" << std::endl << std::endl;
+}
+
+/**
+ * Tests that forwardPropBatch matches forwardProp, rounded to float, for the
+ * outputs and the hidden nodes, and that threads can share one network.
+ */
+void test_forward_prop_batch() {
+    std::cout << "--- Running Test: Forward Prop Batch ---" << std::endl;
+    static const nn::ActivationFunction CUSTOM_SOFTSIGN = {
+        [](double x) { return x / (1 + std::abs(x)); },
+        [](double x) { return 1 / ((1 + std::abs(x)) * (1 + std::abs(x))); },
+    };
+    struct Case {
+        std::vector<int> shape;
+        const nn::ActivationFunction* activation;
+        const nn::ActivationFunction* output;
+    };
+    const std::vector<Case> cases = {
+        {{2, 4, 2, 1}, &nn::Activations::TANH, &nn::Activations::TANH},
+        {{5, 8, 8, 1}, &nn::Activations::RELU, &nn::Activations::LINEAR},
+        {{3, 6, 1}, &nn::Activations::FAST_SIGMOID, &nn::Activations::FAST_TANH},
+        {{2, 3, 3, 1}, &CUSTOM_SOFTSIGN, &nn::Activations::SIGMOID},
+    };
+    for (const Case& c : cases) {
+        std::vector<std::string> inputIds;
+        for (int i = 0; i < c.shape[0]; ++i) inputIds.push_back("x" + std::to_string(i));
+        nn::Network network = nn::buildNetwork(c.shape, *c.activation, *c.output, nullptr, inputIds, false, 5);
+        nn::forEachNode(network, true, [](nn::Node* node) { node->bias = std::sin(node->id * 1.3); });
+        network[1][0]->inputLinks[1]->isDead = true;
+        network[1][0]->inputLinks[1]->weight = 0;
+
+        // Not a multiple of the block size, with padding after each row.
+        const size_t count = 150, stride = c.shape[0] + 2;
+        size_t numHidden = 0;
+        for (size_t l = 1; l + 1 < c.shape.size(); ++l) numHidden += c.shape[l];
+        std::vector<float> inputs(count * stride);
+        for (size_t i = 0; i < inputs.size(); ++i) inputs[i] = static_cast<float>(5 * std::sin(i * 0.37));
+        std::vector<float> outputs(count), hidden(count * numHidden);
+        nn::forwardPropBatch(network, inputs.data(), count, stride, outputs.data(), hidden.data());
+
+        for (size_t row = 0; row < count; ++row) {
+            std::vector<double> input(inputs.begin() + row * stride, inputs.begin() + row * stride + c.shape[0]);
+            assert(outputs[row] == static_cast<float>(nn::forwardProp(network, input)));
+            size_t h = 0;
+            for (size_t l = 1; l + 1 < network.size(); ++l) {
+                for (const nn::Node* node : network[l]) {
+                    assert(hidden[row * numHidden + h++] == static_cast<float>(node->output));
+                }
+            }
+        }
+
+        // Concurrent calls on the same network each get the same outputs.
+        std::vector<std::vector<float>> results(4, std::vector<float>(count));
+        std::vector<std::thread> threads;
+        for (auto& result : results) {
+            threads.emplace_back([&network, &inputs, &result, stride] {
+                for (int repeat = 0; repeat < 20; ++repeat) {
+                    nn::forwardPropBatch(network, inputs.data(), count, stride, result.data());
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        for (const auto& result : results) assert(result == outputs);
+        nn::deleteNetwork(network);
+    }
+
+    bool threw = false;
+    nn::Network network = nn::buildNetwork({3, 2, 1}, nn::Activations::TANH, nn::Activations::TANH, nullptr,
+                                           {"a", "b", "c"});
+    float input[2] = {0, 0}, output = 0;
+    try {
+        nn::forwardPropBatch(network, input, 1, 2, &output);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    nn::deleteNetwork(network);
+    std::cout << "PASSED" << std::endl << std::endl;
+}
 
 int main() {
     try {
         test_build_and_delete_network();
+        test_seeded_init();
         test_forward_propagation();
         test_backprop_and_update();
         test_full_training_loop_XOR();
+        test_checkpoint_round_trip();
+        test_population_lockstep();
+        test_kernels();
+        test_incremental_edits();
+        test_lbfgs();
+        test_fast_activations();
+        test_quantized_inference();
+        test_forward_prop_batch();
 
         std::cout << "All tests passed successfully!" << std::endl;
     } catch (const std::exception& e) {